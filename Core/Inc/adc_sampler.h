@@ -0,0 +1,123 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : adc_sampler.h
+  * @brief          : Timer-triggered ADC1 sampling into a circular DMA buffer
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * TIM3 update (TRGO) starts one ADC1 scan of the channel sequence every
+  * 1/ADC_SAMPLE_RATE_HZ. DMA1 channel 1 moves the results into a circular
+  * buffer of two halves. On each half/full-transfer interrupt the finished
+  * half is reduced to one mean per channel and queued for the main loop, so
+  * nothing converts, polls or waits on the CPU.
+  *
+  * Slow channels are also oversampled: ADC_SAMPLER_DECIMATE blocks (256
+  * samples, 4^4) are summed and shifted right by 4 for a 16-bit result.
+  * Voltages are ratiometric to VREFINT, so a drifting supply cancels out.
+  *
+  * Set up with registers: this HAL tree does not include the ADC driver.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __ADC_SAMPLER_H
+#define __ADC_SAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Channels in the conversion sequence (order = DMA buffer order)
+  */
+typedef enum {
+  ADC_CH_PUMP_CURRENT = 0,      // PA3 / ADC_IN3
+  ADC_CH_BATTERY,               // PA4 / ADC_IN4 (battery divider)
+  ADC_CH_VREFINT,               // ADC_IN17 (internal 1.2 V reference)
+  ADC_CH_TEMP,                  // ADC_IN16 (internal temperature sensor)
+  ADC_CH_COUNT
+} AdcChannel_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define ADC_SAMPLER_BLOCK     32    // Sequences per DMA half buffer
+#define ADC_SAMPLER_QUEUE     8     // Block means buffered for the main loop (power of 2)
+#define ADC_SAMPLER_BLOCK_MS  ((ADC_SAMPLER_BLOCK * 1000U) / ADC_SAMPLE_RATE_HZ)
+#define ADC_SAMPLER_DECIMATE  8     // Blocks per oversampled result (8 x 32 = 256 = 4^4)
+#define ADC_OVERSAMPLED_FS    (4095U * 16U)   // Full scale of a 16-bit oversampled value
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Configure TIM3, ADC1 and DMA1 channel 1 and start sampling
+  * @param  None
+  * @retval None
+  */
+void AdcSampler_Init(void);
+
+/**
+  * @brief  Retune the sample trigger after a core clock change
+  * @param  None
+  * @retval None
+  */
+void AdcSampler_ClockChanged(void);
+
+/**
+  * @brief  Take the oldest queued block
+  * @param  means Receives one mean (raw 12-bit counts) per channel
+  * @retval uint8_t 1 if a block was taken, 0 if the queue is empty
+  */
+uint8_t AdcSampler_PopBlock(uint16_t means[ADC_CH_COUNT]);
+
+/**
+  * @brief  Latest oversampled value of a channel (O(1), non-blocking)
+  * @param  ch Channel
+  * @retval uint16_t 16-bit result (0..ADC_OVERSAMPLED_FS), 0 before the first
+  */
+uint16_t AdcSampler_GetOversampled(AdcChannel_t ch);
+
+/**
+  * @brief  Pin voltage of a channel, ratiometric to VREFINT
+  * @param  ch Channel
+  * @retval uint16_t Millivolts, 0 before the first oversampled result
+  */
+uint16_t AdcSampler_GetMillivolts(AdcChannel_t ch);
+
+/**
+  * @brief  Analog supply voltage derived from VREFINT
+  * @param  None
+  * @retval uint16_t Millivolts, 0 before the first oversampled result
+  */
+uint16_t AdcSampler_GetVdda_mV(void);
+
+/**
+  * @brief  Die temperature from the internal sensor (typical V25 / slope)
+  * @param  None
+  * @retval int16_t Tenths of a degree Celsius
+  */
+int16_t AdcSampler_GetChipTemp_dC(void);
+
+/**
+  * @brief  Blocks dropped because the main loop fell behind
+  * @param  None
+  * @retval uint32_t Overrun count
+  */
+uint32_t AdcSampler_GetOverruns(void);
+
+/**
+  * @brief  DMA1 channel 1 half/full transfer handler
+  * @param  None
+  * @retval None
+  */
+void AdcSampler_DmaISR(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ADC_SAMPLER_H */
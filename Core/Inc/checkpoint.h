@@ -0,0 +1,81 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : checkpoint.h
+  * @brief          : Power-fail checkpoint of lifetime counters to flash
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The PVD interrupt fires when VDD falls below CHECKPOINT_PVD_LEVEL. The
+  * handler writes one 32-byte record (16 half-word programs, ~1 ms) into the
+  * next free slot of a flash page that was erased at boot, so no erase is
+  * needed during the hold-up time. The commit marker is programmed last:
+  * a record cut short by the brownout is simply not valid.
+  *
+  * At boot the newest valid record is restored into the state machine and
+  * usage statistics. The page is erased only at boot, once every slot is used.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Checkpoint status
+  */
+typedef struct {
+  uint8_t  restored;            // 1 if a record was restored at boot
+  uint8_t  sequence;            // Sequence number of the restored / last written record
+  uint16_t lastFlush_us;        // Measured flush time of the last record (see below)
+  uint8_t  overBudget;          // lastFlush_us + commit exceeds CHECKPOINT_BUDGET_US
+  uint8_t  freeSlots;           // Pre-erased slots left in the page
+  uint32_t flushes;             // Records written since boot (supply dips that recovered)
+  uint32_t skipped;             // Power-fail events with no free slot left
+} CheckpointStatus_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Restore the newest checkpoint, prepare a free slot and arm the PVD
+  * @param  None
+  * @retval None
+  * @note   Call after StateMachine_Init() - it overwrites the zeroed counters
+  */
+void Checkpoint_Init(void);
+
+/**
+  * @brief  Re-arm the flush once VDD is back above the PVD threshold (main loop)
+  * @param  None
+  * @retval None
+  */
+void Checkpoint_Process(void);
+
+/**
+  * @brief  PVD interrupt handler - write the checkpoint record
+  * @param  None
+  * @retval None
+  */
+void Checkpoint_PvdISR(void);
+
+/**
+  * @brief  Get checkpoint status
+  * @param  None
+  * @retval const CheckpointStatus_t* Pointer to status
+  */
+const CheckpointStatus_t* Checkpoint_GetStatus(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CHECKPOINT_H */
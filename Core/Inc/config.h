@@ -65,6 +65,11 @@ extern "C" {
 #define OVERFLOW_SENSOR_ACTIVE_LOW // Sensor reads LOW when overflow detected
 // #define OVERFLOW_SENSOR_ACTIVE_HIGH // Sensor reads HIGH when overflow detected
 
+/* LOW LEVEL PROBE Configuration (Optional, PB0) ----------------------------*/
+// Second float switch well below WATER_LIMIT; dry = refill now
+#define LOW_PROBE_ACTIVE_LOW       // Probe reads LOW while water covers it
+// #define LOW_PROBE_ACTIVE_HIGH   // Probe reads HIGH while water covers it
+
 /* ============================================================================
    TIMING CONFIGURATION
    ============================================================================
@@ -85,15 +90,30 @@ extern "C" {
                                          // Prevents rapid cycling, protects pump
                                          // Recommended: 5-15 seconds
 
-#define PUMP_STARTUP_DELAY      2000    // Delay after door closes: 2 seconds
+#define PUMP_STARTUP_DELAY      2000    // Delay after door closes: 2 seconds (upper bound)
                                          // Allows water to settle before pumping
                                          // Recommended: 1-3 seconds
 
+#define SETTLE_STABLE_SAMPLES   40      // Settle ends early once the level reads the same this many
+                                         // samples in a row (40 x 20 ms = 800 ms)
+                                         // 0 = Always wait PUMP_STARTUP_DELAY
+#define SETTLE_SAMPLE_MS        20      // Level sample period while settling (>= WAIT_SETTLE loop interval)
+
 /* Sensor Debounce Timing ---------------------------------------------------*/
 #define DEBOUNCE_DELAY          100      // Debounce delay: 50 ms
                                          // Prevents false triggers from switch bounce
                                          // Recommended: 20-100 ms
 
+// Sensor health (ENABLE_SENSOR_HEALTH): EXTI debounce adapted per input to twice
+// its measured bounce time, chatter and stuck level switch raise ERROR_SENSOR_FAULT
+#define SENSOR_DEBOUNCE_INIT_MS  50     // EXTI debounce window until bounce has been measured
+#define SENSOR_DEBOUNCE_MIN_MS   10     // Shortest window (clean switch)
+#define SENSOR_DEBOUNCE_MAX_MS   100    // Longest window; edges closer than this form one bounce burst
+#define SENSOR_CHATTER_EDGES     60     // Edges per minute on one input that count as chatter
+#define SENSOR_CHATTER_MINUTES   2      // Consecutive chattering minutes before a sensor fault
+#define SENSOR_STUCK_FILLS       2      // Long fills with water available and no level edge before a sensor fault
+#define SENSOR_STUCK_MIN_RUN_MS  60000  // Shorter fills say nothing about the level switch
+
 /* LED Blink Timing ---------------------------------------------------------*/
 #define LED_BLINK_FAST          250     // Fast blink rate: 250 ms (4 Hz)
                                          // Used for active states (filling, door open)
@@ -121,6 +141,41 @@ extern "C" {
 
 #define PUMP_POWER_RATING       10      // Pump power in Watts
 
+/* Gallon Inventory ---------------------------------------------------------*/
+#define GALLON_CAPACITY_ML        19000 // Usable volume of a full gallon (19 L jug)
+#define GALLON_LOW_WARNING_ML     4000  // Early warning below this (~2 tank refills)
+#define GALLON_ESTIMATE_MARGIN_ML 2500  // Slack past "empty" before a fill is cut
+                                         // Keep > ESTIMATED_TANK_SIZE so a missed swap still completes a fill
+#define GALLON_SWAP_MIN_OPEN_MS   5000  // Door open at least this long to count as a gallon swap
+#define GALLON_DRY_RUN_MIN_MS     30000 // Never cut a fill by estimate before this
+#define GALLON_LOW_BLINK_MS       2000  // Status LED toggle period while gallon is low
+
+/* Flow Meter (Optional) ----------------------------------------------------*/
+#define FLOW_METER_PULSES_PER_LITER 450 // Hall sensor K-factor (YF-S201: F = 7.5 * Q[L/min])
+#define FLOW_RATE_WINDOW_MS       1000  // Flow rate averaging window
+#define FLOW_PRIME_MS             5000  // No-flow check starts this long after pump on
+#define FLOW_DRY_RUN_MS           8000  // No pulse for this long while pumping = gallon empty
+#define FLOW_FILL_LIMIT_ML        3000  // Volumetric limit: more than this without tank full = sensor fault
+                                         // 0 = Disable. Keep > ESTIMATED_TANK_SIZE
+
+/* ADC Sampling -------------------------------------------------------------*/
+#define ADC_SAMPLE_RATE_HZ        1000  // TIM3 TRGO -> ADC1 scan rate (32 ms blocks, 256 ms oversampled)
+#define ADC_VREFINT_MV            1200  // Internal reference (1.16-1.24 V, no factory cal on F1)
+#define ADC_TEMP_V25_MV           1430  // Temp sensor voltage at 25 C (typ.)
+#define ADC_TEMP_SLOPE_UV_PER_C   4300  // Temp sensor slope (typ. 4.3 mV/C)
+
+/* Pump Current Sensing (Optional) ------------------------------------------*/
+#define PUMP_CURRENT_ZERO_COUNTS  0     // ADC counts at 0 mA (2048 for a bidirectional hall sensor)
+#define PUMP_CURRENT_FULL_SCALE_MA 3300 // Current at ADC full scale (0.1 ohm shunt x10 amp = 1 V/A)
+#define PUMP_CURRENT_BLANK_MS     1000  // Ignore motor inrush after pump on
+#define PUMP_CURRENT_DRY_MA       250   // Dry below this until a running current is learned
+#define PUMP_CURRENT_DRY_PERCENT  70    // Dry below this % of the learned running current
+#define PUMP_CURRENT_DRY_HOLD_MS  3000  // ... for this long
+#define PUMP_CURRENT_STALL_MA     2000  // Stall above this until a running current is learned
+#define PUMP_CURRENT_STALL_PERCENT 180  // Stall above this % of the learned running current
+#define PUMP_CURRENT_STALL_HOLD_MS 500  // ... for this long
+#define PUMP_CURRENT_AVG_SHIFT    2     // Moving average weight 1/4 per block (~130 ms)
+
 /* ============================================================================
    SAFETY PARAMETERS
    ============================================================================
@@ -133,18 +188,109 @@ extern "C" {
 #define PUMP_OVERHEAT_COOLDOWN  300000  // 5 min forced cooldown (ms)
 
 /* Optional Features (Enable if hardware supported) -------------------------*/
-#define ENABLE_BATTERY_MONITOR  0       // Requires ADC1
+#define ENABLE_BATTERY_MONITOR  0       // Requires battery divider on PA4 (ADC1 via TIM3 + DMA1)
 #define ENABLE_USAGE_STATS      0       // Requires Flash storage
-#define ENABLE_REMOTE_MONITOR   0       // Requires UART1
+#define ENABLE_REMOTE_MONITOR   0       // Requires USART1 on PA9 (TX) / PA10 (RX)
+#define ENABLE_FLOW_METER       0       // Requires hall flow sensor on PA12 (TIM1_ETR)
+#define ENABLE_PUMP_CURRENT     0       // Requires current shunt/sensor on PA3 (ADC1 via TIM3 + DMA1)
+#define ENABLE_POWER_GOVERNOR   0       // Requires ENABLE_BATTERY_MONITOR (battery powered units)
+
+/* Remote Telemetry Timing --------------------------------------------------*/
+#define REMOTE_BAUD_RATE         115200 // USART1 8N1
+#define REMOTE_STATUS_INTERVAL   5000   // Status frame every 5 seconds
+#define REMOTE_LATENCY_INTERVAL  60000  // Latency histogram report every minute
+
+/* Telemetry Formatting -----------------------------------------------------*/
+#define FMT_BENCHMARK            0      // 1 = Time Fmt_Json* against sprintf at boot (links printf back in)
+#define FMT_BENCH_RUNS           64     // Status frames formatted per method
+
+/* Memory Pools -------------------------------------------------------------*/
+#define REMOTE_FRAME_SIZE        288    // Bytes per telemetry frame (longest line: status frame, 274 with every field at its maximum)
+#define REMOTE_FRAME_COUNT       1      // Frames in the pool (transmit is blocking: one at a time)
+
+/* Stack Monitor ------------------------------------------------------------*/
+#define STACK_SCAN_WORDS         64     // Painted words checked per main loop pass (~20 us at 8 MHz)
+#define STACK_WARN_HEADROOM      512    // Raise ERROR_STACK_LOW below this many untouched bytes
+
+/* Deferred Log -------------------------------------------------------------*/
+#define LOG_RING_WORDS           256    // Record ring in 32-bit words, power of two (1 KB, ~60 records)
+#define LOG_LEVEL_MIN            1      // Compile out records below this level (0 DEBUG, 1 INFO, 2 WARN, 3 ERROR)
+#define LOG_DRAIN_RECORDS        8      // Records sent per main loop pass (28 bytes max each)
+
+/* Task Supervisor ----------------------------------------------------------*/
+#define SUP_DEADLINE_CONTROL_MS      200 // Control pass normally every 10-50 ms
+#define SUP_DEADLINE_HOUSEKEEPING_MS 200 // Same pass, after the state machine
+#define SUP_DEADLINE_IO_MS           300 // Every loop pass, but includes blocking telemetry
+#define SUP_WWDG_MIN_MS              5   // WWDG window: refreshes wait this long after the last (fastest loop interval: 10 ms)
+#define SUP_WWDG_TIMEOUT_MS          250 // ... and further apart than this (262 ms at most with an 8 MHz PCLK1)
+
+/* Timebase -----------------------------------------------------------------*/
+#define TICK_PERIOD_MS          1       // HAL tick interrupt period: 1 (1 kHz) or 10 (100 Hz, 1 ms sub-tick reads)
+
+/* Deep Sleep (STOP mode) ---------------------------------------------------*/
+#define DEEP_SLEEP_MAX_MS          2000 // RTC housekeeping wake - must stay below IWDG timeout (~3.2 s)
+#define DEEP_SLEEP_RUN_CURRENT_UA  5000 // MCU current awake, HSI 8 MHz (datasheet typ.)
+#define DEEP_SLEEP_STOP_CURRENT_UA 20   // MCU current in STOP: LP regulator 14 uA typ. + LSI/RTC/IWDG
+
+/* Power-Fail Checkpoint ----------------------------------------------------*/
+#define CHECKPOINT_FLASH_ADDR     0x0800FC00     // Last 1 KB page, kept out of FLASH in the linker script
+#define CHECKPOINT_PVD_LEVEL      PWR_PVDLEVEL_7 // Flush when VDD falls below 2.9 V
+#define CHECKPOINT_BUDGET_US      1500  // Hold-up from 2.9 V to 2.0 V (flash program minimum):
+                                         // 47 uF on 3V3 at ~15 mA gives ~2.8 ms
+
+/* Crash Capture ------------------------------------------------------------*/
+#define CRASH_FLASH_ADDR          0x0800F400     // 1 KB page below config, 8 records of 128 bytes
+
+/* Power Governor (Optional) ------------------------------------------------*/
+#define POWER_ECO_ENTER_MV        3600  // Filtered battery below this -> eco
+#define POWER_ECO_EXIT_MV         3800  // ... back to normal above this
+#define POWER_CRITICAL_ENTER_MV   3300  // Filtered battery below this -> critical
+#define POWER_CRITICAL_EXIT_MV    3500  // ... back to eco above this
+#define POWER_SWITCH_DWELL_MS     10000 // A new profile must be wanted this long before switching
+#define POWER_EVAL_INTERVAL_MS    1000  // Battery filter / profile evaluation period
+#define POWER_LED_PERIOD_MS       1000  // LED duty window in eco/critical
+#define POWER_ECO_TELEMETRY_MS    30000 // Status frame period in eco (critical: off)
+#define POWER_ECO_STARTS_PER_HOUR 12    // Pump start budget in eco
+#define POWER_CRITICAL_STARTS_PER_HOUR 4 // Pump start budget in critical
 
 /* Rapid Cycling Protection -------------------------------------------------*/
-#define MAX_RAPID_CYCLES        10      // Maximum cycles before error check
-#define MIN_AVG_CYCLE_TIME      30000   // Minimum average cycle time: 30 seconds
-                                         // If average cycle < this, trigger error
+#define START_BURST             6       // Pump starts allowed back to back (token bucket size)
+#define START_REFILL_PER_HOUR   20      // Starts regained per hour: one every 3 minutes sustained
+                                         // Bucket empty -> ERROR_RAPID_CYCLING
+#define START_HISTORY           32      // Start ticks kept (>= START_BURST + START_REFILL_PER_HOUR)
+
+/* Refill Policy ------------------------------------------------------------*/
+#define REFILL_BATCH_ML         500     // Refill once this much is estimated drunk since the last fill
+#define REFILL_MAX_DEFER_MS     1200000 // ... or this long after the last fill (20 min), whatever the estimate
+                                         // Bounds how long the tank stays below the level switch
+
+/* Leak Detection -----------------------------------------------------------*/
+// A drain from the switch with no door activity since the last fill, in an hour
+// of day that is normally quiet, is compared against the learned distribution
+// of such drain intervals. False alarms per quiet drain ~ (ALPHA/1000)^CONFIRM.
+#define LEAK_QUIET_X16          4       // Slot is quiet while it and both neighbours see < 0.25 drains/h together (x16)
+#define LEAK_LEARN_HOURS        72      // No alarms until the hour profile has seen three days
+#define LEAK_ALPHA_PERMIL       100     // Drain is suspicious below this percentile of the baseline
+#define LEAK_CONFIRM_DRAINS     3       // Suspicious drains in a row (one quiet stretch) for an alarm
+#define LEAK_PRIOR_COUNT        16      // Baseline prior: quiet hours normally see no drain at all
 
 /* Error Recovery -----------------------------------------------------------*/
 #define ERROR_RESET_DOOR_TIME   3000    // Door must be open for 3 seconds to reset error
 
+// Automatic retry policy (ENABLE_AUTO_RECOVERY): retries before the error stays
+// latched, and the first backoff, doubled on every retry up to RECOVERY_BACKOFF_MAX_MS.
+// Overflow, sensor fault and stack errors are always latched until the door reset.
+#define RECOVERY_PUMP_TIMEOUT_RETRIES      0        // Latched: with a stuck level switch a retry overfills
+#define RECOVERY_PUMP_TIMEOUT_BACKOFF_MS   1800000  // 30 minutes
+#define RECOVERY_RAPID_CYCLING_RETRIES     5
+#define RECOVERY_RAPID_CYCLING_BACKOFF_MS  600000   // 10 minutes (the start bucket has refilled by then)
+#define RECOVERY_GALLON_EMPTY_RETRIES      2        // Each retry on a really empty gallon is one more dry run
+#define RECOVERY_GALLON_EMPTY_BACKOFF_MS   1800000  // 30 minutes (a swap opens the door and resets at once)
+#define RECOVERY_PUMP_STALL_RETRIES        3
+#define RECOVERY_PUMP_STALL_BACKOFF_MS     120000   // 2 minutes (debris may clear, a warm motor cools)
+#define RECOVERY_BACKOFF_MAX_MS            7200000  // 2 hours
+#define RECOVERY_FORGET_MS                 86400000 // Retry budget of a code restored after 24 hours without it
+
 /* ============================================================================
    ERROR CODES
    ============================================================================ */
@@ -154,6 +300,10 @@ extern "C" {
 #define ERROR_RAPID_CYCLING     3       // Too many rapid pump cycles detected
 #define ERROR_GALLON_EMPTY      4       // Pump ran for normal fill time but tank not full (Gallon Empty)
 #define ERROR_OVERFLOW          5       // Overflow sensor triggered
+#define ERROR_PUMP_STALL        6       // Pump current above stall threshold (blocked rotor)
+#define ERROR_STACK_LOW         7       // Stack high-water mark close to .bss (early overflow warning)
+#define ERROR_LEAK              8       // Tank drained repeatedly in quiet hours without door activity (suspected leak)
+#define ERROR_CODE_COUNT        9       // Highest error code + 1
 
 /* ============================================================================
    FEATURE ENABLE/DISABLE
@@ -163,8 +313,25 @@ extern "C" {
 #define ENABLE_COOLDOWN_PERIOD  1       // 1 = Enable cooldown between cycles, 0 = Disable
 #define ENABLE_STARTUP_DELAY    1       // 1 = Enable delay after door close, 0 = Disable
 #define ENABLE_TIMEOUT_SAFETY   1       // 1 = Enable pump timeout protection, 0 = Disable
-#define ENABLE_RAPID_CYCLE_CHECK 1      // 1 = Enable rapid cycling detection, 0 = Disable
+#define ENABLE_RAPID_CYCLE_CHECK 1      // 1 = Token-bucket pump start limiter (rapid cycling error), 0 = Disable
 #define ENABLE_OVERFLOW_SENSOR  0       // 1 = Enable overflow sensor, 0 = Disable (Default)
+#define ENABLE_REFILL_POLICY    1       // 1 = Batch top-ups (volume / time / low probe), 0 = Refill whenever not full
+#define ENABLE_LOW_PROBE        0       // 1 = Low level probe on PB0 forces a refill, 0 = Not fitted (Default)
+#define ENABLE_ISR_PUMP_CUTOFF  1       // 1 = Level/overflow EXTI switches pump off directly, 0 = Main loop only
+#define ENABLE_DEEP_SLEEP       1       // 1 = STOP mode in IDLE/FULL, 0 = Always run
+#define ENABLE_FAST_TICK_ISR    1       // 1 = Minimal TIM4 tick ISR, 0 = HAL_TIM_IRQHandler path
+#define ENABLE_GALLON_ESTIMATOR 1       // 1 = Track gallon volume, warn early, cut dry runs, 0 = Disable
+#define ENABLE_POWER_FAIL_CHECKPOINT 1  // 1 = PVD flushes lifetime counters to flash, restored at boot, 0 = Disable
+#define ENABLE_WARM_RESTART     1       // 1 = Resume state/hold-off/counters after watchdog reset (BKP registers), 0 = Always cold
+#define ENABLE_CRASH_DUMP       1       // 1 = Capture faults to .noinit RAM, keep in flash, report at boot, 0 = Halt on fault
+#define ENABLE_HEAP             0       // 1 = newlib heap via _sbrk, 0 = _sbrk traps (allocation-free build, static pools)
+#define ENABLE_STACK_MONITOR    1       // 1 = Scan painted stack for its high-water mark, warn before overflow, 0 = Disable
+#define ENABLE_DEFERRED_LOG     1       // 1 = LOG_* macros write binary records (strings stay in the ELF), 0 = Compiled out
+#define ENABLE_TASK_SUPERVISOR  1       // 1 = IWDG refreshed only after every main loop task checked in, 0 = Refresh every pass
+#define ENABLE_WWDG             1       // 1 = Window watchdog on the control pass (too fast / too slow), 0 = IWDG only
+#define ENABLE_AUTO_RECOVERY    1       // 1 = Transient errors retry after an exponential backoff, 0 = Door reset only
+#define ENABLE_SENSOR_HEALTH    1       // 1 = Adaptive EXTI debounce, chatter / stuck sensor faults, 0 = Fixed 50 ms debounce
+#define ENABLE_LEAK_DETECT      1       // 1 = Flag unexplained drains in quiet hours (ERROR_LEAK), 0 = Disable
 
 /* ============================================================================
    DERIVED MACROS - DO NOT MODIFY
@@ -202,6 +369,15 @@ extern "C" {
   #define PUMP_OFF()  HAL_GPIO_WritePin(PUMP_WATER_GALLON_GPIO_Port, PUMP_WATER_GALLON_Pin, GPIO_PIN_RESET)
 #endif
 
+// Register-level variants for interrupt context (single store, no HAL call)
+#ifdef PUMP_ACTIVE_LOW
+  #define PUMP_OFF_ISR()  (PUMP_WATER_GALLON_GPIO_Port->BSRR = PUMP_WATER_GALLON_Pin)
+  #define PUMP_IS_ON()    ((PUMP_WATER_GALLON_GPIO_Port->ODR & PUMP_WATER_GALLON_Pin) == 0U)
+#else
+  #define PUMP_OFF_ISR()  (PUMP_WATER_GALLON_GPIO_Port->BRR = PUMP_WATER_GALLON_Pin)
+  #define PUMP_IS_ON()    ((PUMP_WATER_GALLON_GPIO_Port->ODR & PUMP_WATER_GALLON_Pin) != 0U)
+#endif
+
 /* Door Switch Reading Macros -----------------------------------------------*/
 #if defined(DOOR_SWITCH_TYPE_NO) && defined(DOOR_SWITCH_ACTIVE_LOW)
   // NO switch, Active LOW: Door closed = switch closes = reads LOW
@@ -246,6 +422,26 @@ extern "C" {
   #define IS_TANK_EMPTY()   (HAL_GPIO_ReadPin(WATER_LIMIT_GPIO_Port, WATER_LIMIT_Pin) == GPIO_PIN_SET)
 #endif
 
+/* Overflow Sensor Reading Macros -------------------------------------------*/
+#if defined(OVERFLOW_SENSOR_ACTIVE_LOW)
+  #define OVERFLOW_SENSOR_PULL  GPIO_PULLUP     // Idle high
+#else
+  #define OVERFLOW_SENSOR_PULL  GPIO_PULLDOWN   // Idle low
+#endif
+
+#if defined(OVERFLOW_SENSOR_TYPE_NO) && defined(OVERFLOW_SENSOR_ACTIVE_LOW)
+  #define IS_OVERFLOW()     (HAL_GPIO_ReadPin(OVERFLOW_SENSOR_GPIO_Port, OVERFLOW_SENSOR_Pin) == GPIO_PIN_RESET)
+
+#elif defined(OVERFLOW_SENSOR_TYPE_NO) && defined(OVERFLOW_SENSOR_ACTIVE_HIGH)
+  #define IS_OVERFLOW()     (HAL_GPIO_ReadPin(OVERFLOW_SENSOR_GPIO_Port, OVERFLOW_SENSOR_Pin) == GPIO_PIN_SET)
+
+#elif defined(OVERFLOW_SENSOR_TYPE_NC) && defined(OVERFLOW_SENSOR_ACTIVE_LOW)
+  #define IS_OVERFLOW()     (HAL_GPIO_ReadPin(OVERFLOW_SENSOR_GPIO_Port, OVERFLOW_SENSOR_Pin) == GPIO_PIN_SET)
+
+#elif defined(OVERFLOW_SENSOR_TYPE_NC) && defined(OVERFLOW_SENSOR_ACTIVE_HIGH)
+  #define IS_OVERFLOW()     (HAL_GPIO_ReadPin(OVERFLOW_SENSOR_GPIO_Port, OVERFLOW_SENSOR_Pin) == GPIO_PIN_RESET)
+#endif
+
 /* ============================================================================
    CONFIGURATION VALIDATION
    ============================================================================ */
@@ -289,6 +485,63 @@ extern "C" {
   #endif
 #endif
 
+#if (TICK_PERIOD_MS != 1) && (TICK_PERIOD_MS != 10)
+  #error "TICK_PERIOD_MS must be 1 or 10!"
+#endif
+
+#if ENABLE_DEEP_SLEEP && (DEEP_SLEEP_MAX_MS >= 3000)
+  #error "DEEP_SLEEP_MAX_MS must stay below the IWDG timeout!"
+#endif
+
+#if ENABLE_FLOW_METER && (FLOW_FILL_LIMIT_ML > 0) && (FLOW_FILL_LIMIT_ML <= ESTIMATED_TANK_SIZE)
+  #error "FLOW_FILL_LIMIT_ML must be larger than ESTIMATED_TANK_SIZE!"
+#endif
+
+#if ENABLE_PUMP_CURRENT && (PUMP_CURRENT_BLANK_MS >= PUMP_NORMAL_FILL_TIME)
+  #error "PUMP_CURRENT_BLANK_MS must be shorter than a fill!"
+#endif
+
+#if ENABLE_POWER_GOVERNOR && !ENABLE_BATTERY_MONITOR
+  #error "ENABLE_POWER_GOVERNOR requires ENABLE_BATTERY_MONITOR!"
+#endif
+
+#if ENABLE_POWER_GOVERNOR && ((POWER_CRITICAL_ENTER_MV >= POWER_CRITICAL_EXIT_MV) || \
+                              (POWER_CRITICAL_EXIT_MV >= POWER_ECO_ENTER_MV) ||      \
+                              (POWER_ECO_ENTER_MV >= POWER_ECO_EXIT_MV))
+  #error "Power governor thresholds must satisfy CRITICAL_ENTER < CRITICAL_EXIT < ECO_ENTER < ECO_EXIT!"
+#endif
+
+#if ENABLE_TASK_SUPERVISOR && ((SUP_DEADLINE_CONTROL_MS >= 3000) || (SUP_DEADLINE_HOUSEKEEPING_MS >= 3000) || \
+                               (SUP_DEADLINE_IO_MS >= 3000))
+  #error "Supervisor deadlines must stay below the IWDG timeout!"
+#endif
+
+#if ENABLE_WWDG && (!ENABLE_TASK_SUPERVISOR || SUP_WWDG_MIN_MS >= 10 || SUP_WWDG_MIN_MS >= SUP_WWDG_TIMEOUT_MS)
+  #error "ENABLE_WWDG requires ENABLE_TASK_SUPERVISOR and SUP_WWDG_MIN_MS below the 10 ms loop interval!"
+#endif
+
+#if SETTLE_STABLE_SAMPLES > 255
+  #error "SETTLE_STABLE_SAMPLES must fit in 8 bits!"
+#endif
+
+#if ENABLE_AUTO_RECOVERY && (RECOVERY_BACKOFF_MAX_MS > 0x7FFFFFFFUL || RECOVERY_FORGET_MS > 0x7FFFFFFFUL)
+  #error "RECOVERY_BACKOFF_MAX_MS and RECOVERY_FORGET_MS must stay below half the 32-bit tick range!"
+#endif
+
+#if ENABLE_SENSOR_HEALTH && ((SENSOR_DEBOUNCE_MIN_MS > SENSOR_DEBOUNCE_INIT_MS) || \
+                             (SENSOR_DEBOUNCE_INIT_MS > SENSOR_DEBOUNCE_MAX_MS) || (SENSOR_STUCK_FILLS < 1))
+  #error "Sensor health needs SENSOR_DEBOUNCE_MIN_MS <= SENSOR_DEBOUNCE_INIT_MS <= SENSOR_DEBOUNCE_MAX_MS and SENSOR_STUCK_FILLS >= 1!"
+#endif
+
+#if ENABLE_LEAK_DETECT && ((LEAK_CONFIRM_DRAINS < 1) || (LEAK_CONFIRM_DRAINS > 8) || \
+                           (LEAK_ALPHA_PERMIL < 1) || (LEAK_ALPHA_PERMIL >= 1000) || (LEAK_PRIOR_COUNT < 1))
+  #error "Leak detection needs 1 <= LEAK_CONFIRM_DRAINS <= 8, 1 <= LEAK_ALPHA_PERMIL < 1000 and LEAK_PRIOR_COUNT >= 1!"
+#endif
+
+#if ENABLE_LOW_PROBE && (!ENABLE_REFILL_POLICY || (!defined(LOW_PROBE_ACTIVE_LOW) && !defined(LOW_PROBE_ACTIVE_HIGH)))
+  #error "ENABLE_LOW_PROBE requires ENABLE_REFILL_POLICY and LOW_PROBE_ACTIVE_LOW or LOW_PROBE_ACTIVE_HIGH!"
+#endif
+
 #ifdef __cplusplus
 }
 #endif
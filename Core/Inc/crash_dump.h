@@ -0,0 +1,120 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : crash_dump.h
+  * @brief          : Fault capture in .noinit RAM with post-mortem report
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The HardFault, MemManage, BusFault and UsageFault handlers live here
+  * (their CubeMX generation is switched off in the .ioc). They move MSP to
+  * a small reserved fault stack, so a stack overflow does not fault again
+  * inside the capture. They save the stacked exception frame, the fault
+  * status registers, the current state and the last trace events to a
+  * .noinit RAM record, switch the pump off and reset. The next boot copies
+  * the record to flash so it survives a power cycle. The remote monitor
+  * reports it, and Tools/crash_symbolize.py resolves PC/LR against the ELF.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __CRASH_DUMP_H
+#define __CRASH_DUMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+#include "latency_trace.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define CRASH_TRACE_EVENTS        4     // Newest trace events kept in a record
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Fault handler that captured the record
+  */
+typedef enum {
+  CRASH_FAULT_HARD = 0,
+  CRASH_FAULT_MEMMANAGE,
+  CRASH_FAULT_BUS,
+  CRASH_FAULT_USAGE,
+  CRASH_FAULT_COUNT
+} CrashFault_t;
+
+/**
+  * @brief  Crash record (.noinit RAM, then one 128-byte flash slot)
+  */
+typedef struct {
+  uint32_t magic;
+  uint32_t r0, r1, r2, r3, r12;
+  uint32_t lr;                  // Caller of the faulting function
+  uint32_t pc;                  // Faulting instruction
+  uint32_t xpsr;
+  uint32_t excReturn;           // EXC_RETURN: which stack, thread/handler mode
+  uint32_t sp;                  // SP before the exception frame was pushed
+  uint32_t cfsr;                // Configurable fault status (MMFSR | BFSR << 8 | UFSR << 16)
+  uint32_t hfsr;                // HardFault status (FORCED = escalated)
+  uint32_t bfar;                // Bus fault address (valid if BFSR.BFARVALID)
+  uint32_t mmfar;               // MemManage address (valid if MMFSR.MMARVALID)
+  uint32_t tick;                // HAL tick at the fault
+  uint8_t  fault;               // CrashFault_t
+  uint8_t  state;               // SystemState_t at the fault
+  uint8_t  eventCount;          // Valid entries in events
+  uint8_t  sequence;            // Crash number since the flash page was erased
+  TraceEvent_t events[CRASH_TRACE_EVENTS];
+  uint32_t check;               // Additive checksum of everything above
+} CrashRecord_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Enable the configurable fault handlers, persist a pending record
+  * @param  None
+  * @retval None
+  */
+void CrashDump_Init(void);
+
+/**
+  * @brief  Newest crash record (from this reset or from flash)
+  * @param  None
+  * @retval const CrashRecord_t* Record, NULL if none is stored
+  */
+const CrashRecord_t* CrashDump_GetLast(void);
+
+/**
+  * @brief  Whether the last reset was caused by a captured fault
+  * @param  None
+  * @retval uint8_t 1 if the record was captured just before this boot
+  */
+uint8_t CrashDump_IsNew(void);
+
+/**
+  * @brief  Fault name (for reports)
+  * @param  fault Fault handler id
+  * @retval const char* Name string
+  */
+const char* CrashDump_GetFaultName(CrashFault_t fault);
+
+/**
+  * @brief  Common fault entry, called from the naked handlers
+  * @param  frame Stacked exception frame (r0-r3, r12, lr, pc, xPSR)
+  * @param  excReturn EXC_RETURN value from LR
+  * @param  fault Fault handler id
+  * @retval None (resets the MCU)
+  */
+void CrashDump_Capture(uint32_t* frame, uint32_t excReturn, uint32_t fault);
+
+void HardFault_Handler(void);
+void MemManage_Handler(void);
+void BusFault_Handler(void);
+void UsageFault_Handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRASH_DUMP_H */
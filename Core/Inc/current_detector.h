@@ -0,0 +1,115 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : current_detector.h
+  * @brief          : Fixed-point pump current dry-run / stall detector
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Fed one block-averaged current sample at a time with the block duration.
+  * A moving average (1/2^avgShift per block) is compared against a dry and a
+  * stall threshold after the inrush blanking time. A fault is reported once
+  * the average stays beyond a threshold for the hold time.
+  *
+  * Thresholds are absolute until a running current has been learned from
+  * complete fills, then relative to it. The detector depends on <stdint.h>
+  * only, so recorded or synthetic traces can be replayed on a host.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __CURRENT_DETECTOR_H
+#define __CURRENT_DETECTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Detector verdict
+  */
+typedef enum {
+  CURRENT_FAULT_NONE = 0,       // Normal (or still blanking)
+  CURRENT_FAULT_DRY,            // Current too low: running dry / no load
+  CURRENT_FAULT_STALL           // Current too high: rotor blocked
+} CurrentFault_t;
+
+/**
+  * @brief  Detector tuning
+  */
+typedef struct {
+  uint16_t dry_mA;              // Dry threshold until a nominal is learned
+  uint16_t stall_mA;            // Stall threshold until a nominal is learned
+  uint8_t  dryPercent;          // Dry below this % of the nominal
+  uint8_t  stallPercent;        // Stall above this % of the nominal
+  uint16_t blank_ms;            // Inrush blanking after start
+  uint16_t dryHold_ms;          // Time below the dry threshold before a fault
+  uint16_t stallHold_ms;        // Time above the stall threshold before a fault
+  uint8_t  avgShift;            // Moving average weight 1/2^avgShift per block
+} CurrentDetectorParams_t;
+
+/**
+  * @brief  Detector instance
+  */
+typedef struct {
+  CurrentDetectorParams_t p;
+  uint32_t avg_q8;              // Moving average, mA in Q24.8
+  uint32_t runTime_ms;          // Since CurrentDetector_Start()
+  uint32_t dryTime_ms;          // Consecutive time below the dry threshold
+  uint32_t stallTime_ms;        // Consecutive time above the stall threshold
+  uint32_t runSum_mA;           // Sum of blocks after blanking (for learning)
+  uint32_t runBlocks;
+  uint16_t nominal_mA;          // Learned running current, 0 = not yet
+  CurrentFault_t fault;         // Latched until the next start
+} CurrentDetector_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Set up a detector with no learned nominal current
+  * @param  det Detector instance
+  * @param  params Tuning
+  * @retval None
+  */
+void CurrentDetector_Init(CurrentDetector_t* det, const CurrentDetectorParams_t* params);
+
+/**
+  * @brief  Pump switched on - restart blanking and clear the fault
+  * @param  det Detector instance
+  * @retval None
+  */
+void CurrentDetector_Start(CurrentDetector_t* det);
+
+/**
+  * @brief  Feed one block-averaged current sample
+  * @param  det Detector instance
+  * @param  current_mA Mean current of the block
+  * @param  block_ms Duration of the block
+  * @retval CurrentFault_t Latched verdict
+  */
+CurrentFault_t CurrentDetector_Update(CurrentDetector_t* det, uint16_t current_mA, uint16_t block_ms);
+
+/**
+  * @brief  Blend the mean current of the finished run into the nominal
+  * @param  det Detector instance
+  * @retval None
+  * @note   Call only for runs that ended normally (tank full)
+  */
+void CurrentDetector_LearnNominal(CurrentDetector_t* det);
+
+/**
+  * @brief  Current moving average
+  * @param  det Detector instance
+  * @retval uint16_t Average in mA
+  */
+uint16_t CurrentDetector_GetAverage_mA(const CurrentDetector_t* det);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CURRENT_DETECTOR_H */
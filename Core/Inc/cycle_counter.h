@@ -0,0 +1,71 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : cycle_counter.h
+  * @brief          : DWT cycle counter helpers for latency measurement
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Thin wrappers around the Cortex-M3 DWT->CYCCNT register. Safe to call from
+  * interrupt context. At 8 MHz (HSI) the counter wraps every ~536 seconds, so
+  * only use it for intervals shorter than that.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __CYCLE_COUNTER_H
+#define __CYCLE_COUNTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+
+// Cortex-M3 exception entry: cycles from EXTI edge to first ISR instruction
+// (zero wait-state flash, no preemption in progress)
+#define CYCLE_COUNTER_IRQ_ENTRY_CYCLES  12U
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Enable the DWT cycle counter (idempotent)
+  * @param  None
+  * @retval None
+  */
+static inline void CycleCounter_Init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  if((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+    DWT->CYCCNT = 0U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+}
+
+/**
+  * @brief  Read the free-running cycle counter
+  * @param  None
+  * @retval uint32_t Core clock cycles
+  */
+static inline uint32_t CycleCounter_Now(void)
+{
+  return DWT->CYCCNT;
+}
+
+/**
+  * @brief  Convert a cycle count to microseconds at the current core clock
+  * @param  cycles Number of core clock cycles
+  * @retval uint32_t Microseconds (rounded down)
+  */
+static inline uint32_t CycleCounter_ToMicros(uint32_t cycles)
+{
+  return cycles / (SystemCoreClock / 1000000U);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CYCLE_COUNTER_H */
@@ -0,0 +1,145 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : deferred_log.h
+  * @brief          : Deferred-format logging with a compile-time string table
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * LOG_INFO("fill done in %u ms", t) never formats anything on the MCU. The
+  * format string (with file:line) is placed in the .log_strings section,
+  * which the linker script keeps in the ELF at address 0 but never loads
+  * into flash. The string's address is therefore its 16-bit message ID, a
+  * link-time constant.
+  *
+  * At run time one header word (ID, level, argument count), the HAL tick
+  * and up to four raw 32-bit arguments are reserved in a word ring with
+  * LDREX/STREX and written without disabling interrupts. That takes a few
+  * tens of cycles, so logging is safe from any ISR and can stay enabled in
+  * production. The remote monitor drains the ring as COBS frames between
+  * 0x00 delimiters (never present in the JSON lines), and
+  * Tools/log_decode.py rebuilds the text from the ELF.
+  *
+  * Arguments are printf conversions on 32-bit integers (%d %u %x %c); %s is
+  * not supported because a pointer means nothing on the host.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __DEFERRED_LOG_H
+#define __DEFERRED_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define LOG_LEVEL_DEBUG           0
+#define LOG_LEVEL_INFO            1
+#define LOG_LEVEL_WARN            2
+#define LOG_LEVEL_ERROR           3
+
+#define LOG_MAX_ARGS              4
+#define LOG_RECORD_MAX_WORDS      (2 + LOG_MAX_ARGS)          // Header, tick, arguments
+#define LOG_FRAME_MAX_BYTES       (4 * LOG_RECORD_MAX_WORDS + 1 + 1 + 2)  // + check, COBS code, delimiters
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Logging statistics
+  */
+typedef struct {
+  uint32_t written;             // Records committed to the ring
+  uint32_t dropped;             // Records refused because the ring was full
+  uint32_t highWater;           // Most ring words in use at once
+} DeferredLogStats_t;
+
+/* Exported macro ------------------------------------------------------------*/
+
+#define LOG_STR_(x)               #x
+#define LOG_STR(x)                LOG_STR_(x)
+
+// Argument count 0..4
+#define LOG_NARGS_(_0, _1, _2, _3, _4, n, ...) n
+#define LOG_NARGS(...)            LOG_NARGS_(_, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define LOG_CAT_(a, b)            a##b
+#define LOG_CAT(a, b)             LOG_CAT_(a, b)
+
+#if ENABLE_DEFERRED_LOG
+
+/**
+  * @brief  Emit one record; the string lives only in the ELF ("file:line\x1f" fmt)
+  */
+#define LOG_EMIT(level, fmt, ...)                                                       \
+  do {                                                                                  \
+    if((level) >= LOG_LEVEL_MIN) {                                                      \
+      static const char logFmt[] __attribute__((section(".log_strings"), used)) =      \
+        __FILE__ ":" LOG_STR(__LINE__) "\x1f" fmt;                                      \
+      LOG_CAT(DeferredLog_Write, LOG_NARGS(__VA_ARGS__))(                               \
+        DeferredLog_Header((uint32_t)(uintptr_t)logFmt, (level), LOG_NARGS(__VA_ARGS__)) \
+        LOG_ARGS(__VA_ARGS__));                                                         \
+    }                                                                                   \
+  } while(0)
+
+// Each argument converted to uint32_t (signed values keep their bit pattern)
+#define LOG_ARGS(...)             LOG_CAT(LOG_ARGS_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define LOG_ARGS_0()
+#define LOG_ARGS_1(a)             , (uint32_t)(a)
+#define LOG_ARGS_2(a, b)          , (uint32_t)(a), (uint32_t)(b)
+#define LOG_ARGS_3(a, b, c)       , (uint32_t)(a), (uint32_t)(b), (uint32_t)(c)
+#define LOG_ARGS_4(a, b, c, d)    , (uint32_t)(a), (uint32_t)(b), (uint32_t)(c), (uint32_t)(d)
+
+#else
+
+#define LOG_EMIT(level, fmt, ...) do { } while(0)
+
+#endif // ENABLE_DEFERRED_LOG
+
+#define LOG_DEBUG(fmt, ...)       LOG_EMIT(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)        LOG_EMIT(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)        LOG_EMIT(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...)       LOG_EMIT(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+/**
+  * @brief  Record header: valid bit, level, argument count, 16-bit string ID
+  */
+#define DeferredLog_Header(id, level, nargs)                                            \
+  (0x80000000UL | ((uint32_t)(level) << 20) | ((uint32_t)(nargs) << 16) | ((id) & 0xFFFFUL))
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Reserve and commit a record with 0-4 arguments (any context)
+  * @param  header DeferredLog_Header() value
+  * @retval None
+  */
+void DeferredLog_Write0(uint32_t header);
+void DeferredLog_Write1(uint32_t header, uint32_t a);
+void DeferredLog_Write2(uint32_t header, uint32_t a, uint32_t b);
+void DeferredLog_Write3(uint32_t header, uint32_t a, uint32_t b, uint32_t c);
+void DeferredLog_Write4(uint32_t header, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+
+/**
+  * @brief  Take the oldest committed record and encode it as a COBS frame
+  * @param  out Receives up to LOG_FRAME_MAX_BYTES bytes (0x00, COBS data, 0x00)
+  * @retval uint8_t Frame length, 0 if the ring is empty or the oldest record
+  *         is still being written
+  * @note   Single consumer (main loop)
+  */
+uint8_t DeferredLog_ReadFrame(uint8_t* out);
+
+/**
+  * @brief  Get logging statistics
+  * @param  None
+  * @retval const DeferredLogStats_t* Pointer to statistics
+  */
+const DeferredLogStats_t* DeferredLog_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DEFERRED_LOG_H */
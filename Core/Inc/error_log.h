@@ -9,9 +9,10 @@ typedef struct {
   uint32_t timestamp;
   SystemState_t stateAtError;
   uint32_t pumpCycleCount;
+  uint8_t retries;          // Automatic retries of this code before it was latched again
 } ErrorLog_t;
 
-void ErrorLog_Add(uint8_t errorCode, SystemState_t state, uint32_t cycles);
+void ErrorLog_Add(uint8_t errorCode, SystemState_t state, uint32_t cycles, uint8_t retries);
 ErrorLog_t* ErrorLog_Get(uint8_t index);
 void ErrorLog_DisplayViaLED(void);
 
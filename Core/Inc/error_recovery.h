@@ -0,0 +1,124 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : error_recovery.h
+  * @brief          : Per-error-code automatic retry with exponential backoff
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Without this module every error stays latched until someone holds the
+  * door open for ERROR_RESET_DOOR_TIME. Most errors seen in the field are
+  * transient: a pump that stalled on debris, a gallon that was not quite
+  * empty, a burst of starts that tripped the start limiter. For these the
+  * unit clears the error on its own after a backoff and tries again.
+  *
+  * A policy table gives, for each error code, the number of retries and the
+  * first backoff. Each retry doubles the backoff, up to
+  * RECOVERY_BACKOFF_MAX_MS. When the retries are used up, the error stays
+  * latched. Overflow, sensor fault, stack and leak errors never retry. A retry
+  * only happens with the door closed. A door reset works as before and also
+  * restores every retry budget.
+  *
+  * The retries used for a code are forgotten after RECOVERY_FORGET_MS
+  * without that code. A fault that comes back every few hours therefore
+  * still ends latched. The count is written to each error log entry.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __ERROR_RECOVERY_H
+#define __ERROR_RECOVERY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Recovery policy of one error code
+  */
+typedef struct {
+  uint8_t  maxRetries;          // Automatic retries before the error stays latched (0 = always latched)
+  uint32_t firstBackoff_ms;     // Wait before the first retry (doubled on every retry)
+} RecoveryPolicy_t;
+
+/**
+  * @brief  Error recovery statistics
+  */
+typedef struct {
+  uint32_t retries;             // Automatic retries since boot
+  uint32_t recovered;           // Retries followed by a fill that reached the switch
+  uint32_t exhausted;           // Errors left latched because the retry budget was used up
+  uint32_t retryIn_ms;          // Time to the next retry (0 = none scheduled)
+  uint8_t  code;                // Error code the next retry is for (ERROR_NONE = none)
+  uint8_t  used[ERROR_CODE_COUNT]; // Retries used per error code
+} ErrorRecoveryStats_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Restore every retry budget, nothing scheduled
+  * @param  None
+  * @retval None
+  */
+void ErrorRecovery_Init(void);
+
+/**
+  * @brief  An error was latched: schedule a retry if its policy has one left
+  * @param  errorCode Latched error code
+  * @retval None
+  */
+void ErrorRecovery_ErrorLatched(uint8_t errorCode);
+
+/**
+  * @brief  Whether the scheduled retry is due (takes the retry)
+  * @param  None
+  * @retval uint8_t 1 to clear the error and try again, 0 to stay in ERROR
+  * @note   Call only from the ERROR state with the door closed
+  */
+uint8_t ErrorRecovery_RetryDue(void);
+
+/**
+  * @brief  A fill reached the level switch (counts a successful retry)
+  * @param  None
+  * @retval None
+  */
+void ErrorRecovery_FillComplete(void);
+
+/**
+  * @brief  The error was reset at the door: restore every retry budget
+  * @param  None
+  * @retval None
+  */
+void ErrorRecovery_ManualReset(void);
+
+/**
+  * @brief  Retries used for an error code
+  * @param  errorCode Error code
+  * @retval uint8_t Retries used within RECOVERY_FORGET_MS
+  */
+uint8_t ErrorRecovery_GetRetries(uint8_t errorCode);
+
+/**
+  * @brief  Recovery policy of an error code
+  * @param  errorCode Error code
+  * @retval const RecoveryPolicy_t* Policy (never NULL, unknown codes are latched)
+  */
+const RecoveryPolicy_t* ErrorRecovery_GetPolicy(uint8_t errorCode);
+
+/**
+  * @brief  Get error recovery statistics (refreshes the time to the next retry)
+  * @param  None
+  * @retval const ErrorRecoveryStats_t* Pointer to statistics
+  */
+const ErrorRecoveryStats_t* ErrorRecovery_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ERROR_RECOVERY_H */
@@ -0,0 +1,149 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : fmt.h
+  * @brief          : Allocation-free integer formatting and JSON line builder
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Replaces sprintf() for telemetry. The number formatters write digits into
+  * a caller buffer and return the length (no terminator). The JSON builder
+  * appends "key":value pairs to a caller buffer, checks every append against
+  * its capacity, and ends the line with "}\r\n".
+  *
+  * Nothing here keeps state between calls, allocates or uses newlib, so it
+  * is reentrant and costs a few hundred bytes of flash. It depends on
+  * <stdint.h> only and builds unchanged on a host (Tools/fmt_bench.c).
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __FMT_H
+#define __FMT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+#define FMT_U32_MAX_LEN           10    // "4294967295"
+#define FMT_I32_MAX_LEN           11    // "-2147483648"
+#define FMT_HEX32_LEN             10    // "0x" + 8 digits
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  JSON line being built (one object, flat key/value pairs)
+  */
+typedef struct {
+  char*    buf;
+  uint16_t cap;                 // Buffer size including the terminator
+  uint16_t len;                 // Characters written so far
+  uint8_t  fields;              // Pairs written (decides the comma)
+  uint8_t  overflow;            // An append did not fit; the line is discarded
+} FmtJson_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Unsigned decimal
+  * @param  out Receives up to FMT_U32_MAX_LEN characters
+  * @param  value Value
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_U32(char* out, uint32_t value);
+
+/**
+  * @brief  Signed decimal
+  * @param  out Receives up to FMT_I32_MAX_LEN characters
+  * @param  value Value
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_I32(char* out, int32_t value);
+
+/**
+  * @brief  Hex with 0x prefix and 8 lower-case digits (as "0x%08lx")
+  * @param  out Receives FMT_HEX32_LEN characters
+  * @param  value Value
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_Hex32(char* out, uint32_t value);
+
+/**
+  * @brief  Fixed-point decimal: 3712 with 3 decimals is "3.712" (mV -> V, mL -> L)
+  * @param  out Receives up to FMT_I32_MAX_LEN + 2 characters
+  * @param  value Value in units of 10^-decimals
+  * @param  decimals Digits after the point (0-9)
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_Fixed(char* out, int32_t value, uint8_t decimals);
+
+/**
+  * @brief  Start a JSON line ("{")
+  * @param  json Builder
+  * @param  buf Output buffer
+  * @param  cap Buffer size including the terminator
+  * @retval None
+  */
+void Fmt_JsonBegin(FmtJson_t* json, char* buf, uint16_t cap);
+
+/**
+  * @brief  Append "key":"value"
+  * @param  json Builder
+  * @param  key Key (not escaped)
+  * @param  value String value (not escaped)
+  * @retval None
+  */
+void Fmt_JsonStr(FmtJson_t* json, const char* key, const char* value);
+
+/**
+  * @brief  Append "key":value (unsigned)
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value
+  * @retval None
+  */
+void Fmt_JsonU32(FmtJson_t* json, const char* key, uint32_t value);
+
+/**
+  * @brief  Append "key":value (signed)
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value
+  * @retval None
+  */
+void Fmt_JsonI32(FmtJson_t* json, const char* key, int32_t value);
+
+/**
+  * @brief  Append "key":"0x........"
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value
+  * @retval None
+  */
+void Fmt_JsonHex32(FmtJson_t* json, const char* key, uint32_t value);
+
+/**
+  * @brief  Append "key":value as a fixed-point decimal
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value in units of 10^-decimals
+  * @param  decimals Digits after the point
+  * @retval None
+  */
+void Fmt_JsonFixed(FmtJson_t* json, const char* key, int32_t value, uint8_t decimals);
+
+/**
+  * @brief  Close the line with "}\r\n" and terminate it
+  * @param  json Builder
+  * @retval uint16_t Line length, 0 if anything did not fit
+  */
+uint16_t Fmt_JsonEnd(FmtJson_t* json);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FMT_H */
@@ -0,0 +1,102 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : gallon_inventory.h
+  * @brief          : Gallon volume estimator with swap detection
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Remaining gallon volume = capacity - volume pumped since the last swap.
+  * Volumes come from the flow meter, or the pump rate estimate without one.
+  * A swap is a door-open episode of at least GALLON_SWAP_MIN_OPEN_MS whose
+  * next pump cycle brings the tank level up to full. Until the first swap
+  * (or the first "gallon empty") after power-up the inventory is unknown and
+  * never cuts a fill.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __GALLON_INVENTORY_H
+#define __GALLON_INVENTORY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+#include "pump_health.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Inventory status
+  */
+typedef struct {
+  uint8_t  known;               // 1 once a swap has been seen since boot
+  uint8_t  swapPending;         // Long door-open seen, waiting for a full fill
+  int32_t  remaining_ml;        // Estimated volume left (negative = over-pumped)
+  uint32_t pumpedSinceSwap_ml;  // Volume pumped since the swap
+  uint32_t capacity_ml;         // Learned usable gallon volume
+  uint32_t swapCount;           // Swaps detected since boot
+  uint32_t earlyCutCount;       // Dry runs cut short by the estimate
+} GallonStatus_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Reset to "unknown" with the configured capacity
+  * @param  None
+  * @retval None
+  */
+void Gallon_Init(void);
+
+/**
+  * @brief  Report a finished door-open episode
+  * @param  openDuration_ms How long the door was open
+  * @retval None
+  */
+void Gallon_DoorEpisode(uint32_t openDuration_ms);
+
+/**
+  * @brief  Account a finished pump cycle
+  * @param  volume_ml Volume the cycle delivered
+  * @param  outcome How the cycle ended
+  * @retval None
+  */
+void Gallon_RecordCycle(uint32_t volume_ml, PumpCycleOutcome_t outcome);
+
+/**
+  * @brief  Gallon ran dry (ERROR_GALLON_EMPTY), learn from it
+  * @param  cutByEstimate 1 if Gallon_IsExhausted() stopped the fill
+  * @retval None
+  */
+void Gallon_MarkEmpty(uint8_t cutByEstimate);
+
+/**
+  * @brief  Whether the running fill has pumped past what the gallon can hold
+  * @param  runtime_ms Pump on time of the running fill
+  * @param  volume_ml Volume the running fill delivered so far
+  * @retval uint8_t 1 if the fill should be stopped as a dry run
+  */
+uint8_t Gallon_IsExhausted(uint32_t runtime_ms, uint32_t volume_ml);
+
+/**
+  * @brief  Whether the gallon is running low (early warning)
+  * @param  None
+  * @retval uint8_t 1 if below GALLON_LOW_WARNING_ML
+  */
+uint8_t Gallon_IsLow(void);
+
+/**
+  * @brief  Get inventory status
+  * @param  None
+  * @retval const GallonStatus_t* Pointer to status
+  */
+const GallonStatus_t* Gallon_GetStatus(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GALLON_INVENTORY_H */
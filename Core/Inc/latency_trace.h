@@ -0,0 +1,142 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : latency_trace.h
+  * @brief          : Sensor edge to actuator latency tracing
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Each sensor edge that happens while the pump runs gets a timestamp and a
+  * correlation ID. When the pump-off it causes is executed (from the ISR
+  * cutoff or from the state machine) the latency is added to a per-path
+  * log-scale histogram, from which p50/p99/max can be read.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __LATENCY_TRACE_H
+#define __LATENCY_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Traced sensor -> actuator paths
+  */
+typedef enum {
+  LATENCY_PATH_DOOR_OPEN = 0,   // Door opened  -> pump off
+  LATENCY_PATH_TANK_FULL,       // Tank full    -> pump off
+  LATENCY_PATH_OVERFLOW,        // Overflow     -> pump off
+  LATENCY_PATH_COUNT
+} LatencyPath_t;
+
+/**
+  * @brief  Trace event types
+  */
+typedef enum {
+  TRACE_EVENT_EDGE = 0,         // Sensor edge timestamped
+  TRACE_EVENT_ACTUATE,          // Pump switched off for a pending edge
+  TRACE_EVENT_STATE             // State change (arg = new state)
+} TraceEventType_t;
+
+/**
+  * @brief  Trace event record
+  */
+typedef struct {
+  uint32_t timestamp;           // Cycle counter at event
+  uint16_t correlationId;       // Edge that caused it (0 = none)
+  uint8_t  type;                // TraceEventType_t
+  uint8_t  arg;                 // LatencyPath_t or SystemState_t
+} TraceEvent_t;
+
+/**
+  * @brief  Latency summary for one path
+  */
+typedef struct {
+  uint32_t count;               // Samples recorded
+  uint32_t p50_us;              // Median (bucket upper bound)
+  uint32_t p99_us;              // 99th percentile (bucket upper bound)
+  uint32_t max_us;              // Exact worst case
+} LatencySummary_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define LATENCY_TRACE_EVENTS      16    // Event ring size (power of two)
+#define LATENCY_HIST_BUCKETS      48    // 2 buckets per octave, 1 us .. ~16 s
+#define LATENCY_TRACE_STALE_US    10000000UL  // Drop edges never resolved within 10 s
+
+/* Exported macro ------------------------------------------------------------*/
+
+// Timestamp source. A host simulation can override both before including.
+#ifndef LATENCY_TRACE_NOW
+  #include "cycle_counter.h"
+  #define LATENCY_TRACE_NOW()           CycleCounter_Now()
+  #define LATENCY_TRACE_TO_US(ticks)    CycleCounter_ToMicros(ticks)
+#endif
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Clear histograms, pending edges and event ring
+  * @param  None
+  * @retval None
+  */
+void LatencyTrace_Init(void);
+
+/**
+  * @brief  Timestamp a sensor edge (ISR safe)
+  * @note   Only the oldest unresolved edge per path is kept, so bounces do
+  *         not shorten the measured latency.
+  * @param  path Path the edge starts
+  * @param  timestamp LATENCY_TRACE_NOW() value of the edge
+  * @retval uint16_t Correlation ID assigned (0 if an edge was already pending)
+  */
+uint16_t LatencyTrace_MarkEdge(LatencyPath_t path, uint32_t timestamp);
+
+/**
+  * @brief  Close the pending edge of a path at the pump-off it caused (ISR safe)
+  * @param  path Path being completed
+  * @retval uint16_t Correlation ID completed (0 if nothing was pending)
+  */
+uint16_t LatencyTrace_MarkActuator(LatencyPath_t path);
+
+/**
+  * @brief  Record a state change attributed to the last completed edge
+  * @param  newState State entered (SystemState_t)
+  * @retval None
+  */
+void LatencyTrace_MarkState(uint8_t newState);
+
+/**
+  * @brief  Get p50/p99/max summary for a path
+  * @param  path Path to summarize
+  * @param  summary Output
+  * @retval None
+  */
+void LatencyTrace_GetSummary(LatencyPath_t path, LatencySummary_t* summary);
+
+/**
+  * @brief  Copy the most recent trace events, newest last
+  * @param  out Output array
+  * @param  maxEvents Capacity of out
+  * @retval uint8_t Number of events copied
+  */
+uint8_t LatencyTrace_GetRecentEvents(TraceEvent_t* out, uint8_t maxEvents);
+
+/**
+  * @brief  Get short path name (for telemetry)
+  * @param  path Path
+  * @retval const char* Name string
+  */
+const char* LatencyTrace_GetPathName(LatencyPath_t path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LATENCY_TRACE_H */
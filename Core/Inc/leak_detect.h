@@ -0,0 +1,125 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : leak_detect.h
+  * @brief          : Idle leak detection from unexplained drains in quiet hours
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * A leak in the tank or its plumbing looks like consumption: the level
+  * switch reads "not full" and the unit refills. Each refill is slow enough
+  * to pass the rapid-cycle checks, so nothing stops it. This module looks
+  * for drains that nothing explains.
+  *
+  * A drain is the level switch dropping after a fill that ended at the
+  * switch. It is idle if the door has not been opened since that fill. Its
+  * interval is the time from the end of the fill to the drain.
+  *
+  * An hour-of-day profile counts drains in 24 one-hour slots, averaged over
+  * days. A slot is quiet when it and its two neighbours together stay below
+  * LEAK_QUIET_X16: nobody normally drinks around that hour. Taking the
+  * neighbours in keeps a slot with occasional glasses from reading quiet
+  * just because it happened to see none lately.
+  *
+  * Idle drains in quiet slots build a baseline histogram of intervals in
+  * log2 minute bins. The histogram starts from LEAK_PRIOR_COUNT samples in
+  * its top bin, because a quiet hour normally sees no drain at all.
+  *
+  * An idle drain in a quiet slot whose interval falls at or below the
+  * LEAK_ALPHA_PERMIL percentile of the baseline is suspicious. It is held
+  * back from the baseline and the profile. LEAK_CONFIRM_DRAINS suspicious
+  * drains in a row raise ERROR_LEAK. A drain that is not suspicious, or any
+  * drain in a busy slot, ends the streak. The held drains are then learned
+  * as normal. Door activity ends the streak and discards them. A drain
+  * that follows the baseline is suspicious with a probability of at most
+  * ALPHA, so false alarms per quiet drain stay near ALPHA^CONFIRM.
+  * Tools/leak_sim.py measures both rates on simulated consumption.
+  *
+  * Nothing is reported for the first LEAK_LEARN_HOURS. There is no wall
+  * clock, so slots count hours since boot: a reset shifts the profile until
+  * it has re-learned. A leak that is already present at install is learned
+  * as normal. State: 24 slot bytes, 12 bin bytes, LEAK_CONFIRM_DRAINS held
+  * bins.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __LEAK_DETECT_H
+#define __LEAK_DETECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Leak detection statistics
+  */
+typedef struct {
+  uint32_t drains;              // Drains to refill level since boot
+  uint32_t idleDrains;          // ... without door activity since the fill ended at the switch
+  uint32_t quietDrains;         // ... of those, in a quiet slot after learning (compared with the baseline)
+  uint32_t suspicious;          // ... of those, at or below the LEAK_ALPHA_PERMIL percentile
+  uint32_t alarms;              // ERROR_LEAK raised
+  uint32_t lastInterval_min;    // Interval of the latest idle drain
+  uint32_t threshold_min;       // Quiet drains sooner than this after a fill are suspicious (0 = none)
+  uint16_t learnHoursLeft;      // Hours until alarms are possible
+  uint8_t  streak;              // Suspicious drains in the open streak
+  uint8_t  quietSlots;          // Hour slots currently quiet (of 24)
+  uint8_t  slot;                // Slot of the running hour (hours since boot, mod 24)
+} LeakDetectStats_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Empty profile and baseline, learning from now
+  * @param  None
+  * @retval None
+  */
+void LeakDetect_Init(void);
+
+/**
+  * @brief  Roll the hour slot and fold its drains into the profile
+  * @param  None
+  * @retval None
+  * @note   Main loop context
+  */
+void LeakDetect_Process(void);
+
+/**
+  * @brief  A fill ended at the level switch (starts the next interval)
+  * @param  None
+  * @retval None
+  */
+void LeakDetect_FillFull(void);
+
+/**
+  * @brief  The door was opened (the next drain is explained)
+  * @param  None
+  * @retval None
+  */
+void LeakDetect_DoorActivity(void);
+
+/**
+  * @brief  The tank drained from full to refill level
+  * @param  None
+  * @retval uint8_t 1 if this drain confirms a suspected leak (raise ERROR_LEAK)
+  */
+uint8_t LeakDetect_Drained(void);
+
+/**
+  * @brief  Get leak detection statistics (refreshes threshold and quiet slots)
+  * @param  None
+  * @retval const LeakDetectStats_t* Pointer to statistics
+  */
+const LeakDetectStats_t* LeakDetect_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LEAK_DETECT_H */
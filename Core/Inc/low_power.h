@@ -0,0 +1,90 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : low_power.h
+  * @brief          : STOP mode deep sleep for Water Dispenser Control
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * In IDLE and FULL the MCU enters STOP mode with the regulator in low-power
+  * mode. It wakes on any sensor EXTI edge or on an RTC alarm (LSI clocked)
+  * that keeps the IWDG fed, then restores the clock tree and TIM4 timebase.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __LOW_POWER_H
+#define __LOW_POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+#include "state_machine.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Deep sleep statistics
+  */
+typedef struct {
+  uint32_t wakeCount;             // Total wakes from STOP
+  uint32_t alarmWakeCount;        // Of which RTC housekeeping wakes
+  uint32_t lastWakeToDecision_us; // Wake -> next state machine decision
+  uint32_t maxWakeToDecision_us;  // Worst case seen
+  uint32_t sleptMs[2];            // Time in STOP   [0] = IDLE, [1] = FULL
+  uint32_t awakeMs[2];            // Time running   [0] = IDLE, [1] = FULL
+} LowPowerStats_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Configure RTC (LSI, 1 ms counter) and its alarm wake-up line
+  * @param  None
+  * @retval None
+  */
+void LowPower_Init(void);
+
+/**
+  * @brief  Enter STOP mode if the state allows it (call once per loop tick)
+  * @param  state Current state machine state
+  * @retval uint8_t 1 if the MCU slept and has just woken, 0 otherwise
+  */
+uint8_t LowPower_Idle(SystemState_t state);
+
+/**
+  * @brief  Snapshot sensor inputs and record wake-to-decision latency
+  * @note   Call right after StateMachine_Process
+  * @param  None
+  * @retval None
+  */
+void LowPower_MarkDecision(void);
+
+/**
+  * @brief  Estimated average MCU current in a state from the sleep ratio
+  * @param  state STATE_IDLE or STATE_FULL
+  * @retval uint32_t Estimated current in uA (0 for other states)
+  */
+uint32_t LowPower_GetEstimatedCurrent_uA(SystemState_t state);
+
+/**
+  * @brief  Get deep sleep statistics
+  * @param  None
+  * @retval const LowPowerStats_t* Pointer to statistics
+  */
+const LowPowerStats_t* LowPower_GetStats(void);
+
+/**
+  * @brief  RTC alarm interrupt handler body (call from RTC_Alarm_IRQHandler)
+  * @param  None
+  * @retval None
+  */
+void LowPower_RtcAlarmISR(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LOW_POWER_H */
@@ -0,0 +1,130 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : mem_pool.h
+  * @brief          : Fixed-block static pools and RAM footprint report
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The firmware does not use the newlib heap: _sbrk() traps (see sysmem.c),
+  * so a stray malloc() or a libc call that allocates shows up as a crash
+  * record pointing at the caller instead of slowly eating the stack.
+  *
+  * Storage that would otherwise be allocated on demand comes from pools
+  * declared with MEM_POOL_DEFINE(): a static array of fixed-size blocks with
+  * a free mask. Capacity is checked at compile time, alloc/free are O(1)
+  * and ISR-safe, and every pool keeps a high-water mark and a failure count
+  * for the memory report.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __MEM_POOL_H
+#define __MEM_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define MEM_POOL_MAX_BLOCKS       32    // One bit per block in the free mask
+#define MEM_POOL_MAX_POOLS        4     // Pools listed in the memory report
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Fixed-block pool (declare with MEM_POOL_DEFINE)
+  */
+typedef struct {
+  const char* name;             // Short name for the report
+  uint8_t* storage;             // blockCount * blockSize bytes
+  uint16_t blockSize;
+  uint8_t  blockCount;
+  uint8_t  used;                // Blocks allocated now
+  uint8_t  highWater;           // Most blocks ever allocated at once
+  uint32_t freeMask;            // Bit n set = block n free
+  uint32_t failures;            // Allocations refused because the pool was empty
+} MemPool_t;
+
+/**
+  * @brief  Static RAM footprint (from linker symbols)
+  */
+typedef struct {
+  uint32_t data;                // .data bytes
+  uint32_t bss;                 // .bss bytes
+  uint32_t noinit;              // .noinit bytes
+  uint32_t heap;                // Heap reserved by the linker script
+  uint32_t stack;               // Stack reserved by the linker script
+  uint32_t free;                // RAM not claimed by any of the above
+  uint32_t pooled;              // Bytes of .bss held by registered pools
+} MemFootprint_t;
+
+/* Exported macro ------------------------------------------------------------*/
+
+/**
+  * @brief  Define a static pool of `count` blocks of `type`
+  * @note   Use at file scope; register it with MemPool_Register() at init
+  */
+#define MEM_POOL_DEFINE(pool, type, count)                                          \
+  _Static_assert((count) >= 1 && (count) <= MEM_POOL_MAX_BLOCKS,                    \
+                 "Pool " #pool " must have 1 to 32 blocks");                 \
+  _Static_assert(sizeof(type) <= 0xFFFFU, "Pool " #pool " block too large");        \
+  static type pool##_storage[(count)] __attribute__((aligned(4)));                  \
+  static MemPool_t pool = {                                                         \
+    #pool, (uint8_t*)pool##_storage, (uint16_t)sizeof(type), (uint8_t)(count),      \
+    0, 0, ((count) == 32 ? 0xFFFFFFFFUL : ((1UL << (count)) - 1UL)), 0              \
+  }
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Add a pool to the memory report
+  * @param  pool Pool defined with MEM_POOL_DEFINE
+  * @retval None
+  */
+void MemPool_Register(MemPool_t* pool);
+
+/**
+  * @brief  Take one block
+  * @param  pool Pool
+  * @retval void* Block, NULL if the pool is exhausted (counted as a failure)
+  */
+void* MemPool_Alloc(MemPool_t* pool);
+
+/**
+  * @brief  Return a block taken with MemPool_Alloc
+  * @param  pool Pool the block came from
+  * @param  block Block (NULL is ignored)
+  * @retval None
+  */
+void MemPool_Free(MemPool_t* pool, void* block);
+
+/**
+  * @brief  Registered pool by index (for reports)
+  * @param  index 0 .. MemPool_GetCount() - 1
+  * @retval const MemPool_t* Pool, NULL if out of range
+  */
+const MemPool_t* MemPool_Get(uint8_t index);
+
+/**
+  * @brief  Number of registered pools
+  * @param  None
+  * @retval uint8_t Count
+  */
+uint8_t MemPool_GetCount(void);
+
+/**
+  * @brief  Static RAM footprint
+  * @param  fp Receives the footprint
+  * @retval None
+  */
+void MemPool_GetFootprint(MemFootprint_t* fp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MEM_POOL_H */
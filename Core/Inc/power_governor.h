@@ -0,0 +1,153 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : power_governor.h
+  * @brief          : Battery-aware operating profiles (normal / eco / critical)
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The filtered battery voltage selects a profile. Each profile fixes the
+  * core clock, LED duty, telemetry rate, pump starts per hour and the states
+  * allowed to enter STOP mode. Profiles change only after a threshold has
+  * held for POWER_SWITCH_DWELL_MS, and entry and exit thresholds are apart,
+  * so the sag from a pump start cannot toggle them.
+  *
+  * Door, level and overflow handling is the same in every profile: the
+  * sensor EXTI lines wake STOP mode and the ISR pump cutoff is untouched.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __POWER_GOVERNOR_H
+#define __POWER_GOVERNOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+#include "state_machine.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Operating profiles, in order of decreasing power
+  */
+typedef enum {
+  POWER_PROFILE_NORMAL = 0,
+  POWER_PROFILE_ECO,
+  POWER_PROFILE_CRITICAL,
+  POWER_PROFILE_COUNT
+} PowerProfileId_t;
+
+/**
+  * @brief  Profile settings
+  */
+typedef struct {
+  const char* name;
+  uint32_t ahbDivider;          // RCC_SYSCLK_DIVx: HSI 8 MHz / x
+  uint8_t  ledDutyPercent;      // Share of POWER_LED_PERIOD_MS the LEDs may be lit
+  uint32_t telemetryInterval;   // Status frame period in ms, 0 = off
+  uint8_t  pumpStartsPerHour;   // 0 = unlimited
+  uint8_t  sleepStates;         // Bit per SystemState_t allowed into STOP mode
+} PowerProfile_t;
+
+/**
+  * @brief  Governor statistics
+  */
+typedef struct {
+  uint16_t filtered_mV;         // Battery voltage after the governor's filter
+  uint32_t switchCount;         // Profile changes since boot
+  uint32_t refusedStarts;       // Pump starts held back by the hourly budget
+  uint32_t timeInProfile_s[POWER_PROFILE_COUNT];
+} PowerGovStats_t;
+
+/* Exported macro ------------------------------------------------------------*/
+#define POWER_SLEEP_STATE(state)  (1U << (state))
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Start in the normal profile
+  * @param  None
+  * @retval None
+  */
+void PowerGov_Init(void);
+
+/**
+  * @brief  Re-evaluate the profile from the battery voltage (main loop)
+  * @param  None
+  * @retval None
+  */
+void PowerGov_Process(void);
+
+/**
+  * @brief  Active profile
+  * @param  None
+  * @retval PowerProfileId_t Profile id
+  */
+PowerProfileId_t PowerGov_GetProfileId(void);
+
+/**
+  * @brief  Active profile settings
+  * @param  None
+  * @retval const PowerProfile_t* Pointer to settings
+  */
+const PowerProfile_t* PowerGov_GetProfile(void);
+
+/**
+  * @brief  Whether a state may enter STOP mode in the active profile
+  * @param  state Current state
+  * @retval uint8_t 1 if allowed
+  */
+uint8_t PowerGov_SleepAllowed(SystemState_t state);
+
+/**
+  * @brief  Whether the hourly pump start budget has room for one more
+  * @param  None
+  * @retval uint8_t 1 if a pump start is allowed
+  */
+uint8_t PowerGov_PumpStartAllowed(void);
+
+/**
+  * @brief  Count a pump start against the hourly budget
+  * @param  None
+  * @retval None
+  */
+void PowerGov_NotePumpStart(void);
+
+/**
+  * @brief  Blank the LEDs outside the profile's duty window
+  * @param  None
+  * @retval None
+  * @note   Call right after StateMachine_UpdateLEDs()
+  */
+void PowerGov_FilterLeds(void);
+
+/**
+  * @brief  About to enter STOP mode: LEDs off unless the profile runs at full duty
+  * @param  None
+  * @retval None
+  */
+void PowerGov_EnterSleep(void);
+
+/**
+  * @brief  Re-apply the profile clock after SystemClock_Config() (STOP wake)
+  * @param  None
+  * @retval None
+  */
+void PowerGov_RestoreClock(void);
+
+/**
+  * @brief  Get governor statistics
+  * @param  None
+  * @retval const PowerGovStats_t* Pointer to statistics
+  */
+const PowerGovStats_t* PowerGov_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __POWER_GOVERNOR_H */
@@ -0,0 +1,88 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : pump_current.h
+  * @brief          : Pump motor current monitoring (dry run / stall)
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Converts the pump current ADC blocks from adc_sampler to mA and runs them
+  * through the current detector while the pump is on. A pump running dry
+  * draws clearly less than its running current, a blocked rotor much more.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __PUMP_CURRENT_H
+#define __PUMP_CURRENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+#include "current_detector.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Pump current status
+  */
+typedef struct {
+  uint16_t avg_mA;              // Moving average while running, last block otherwise
+  uint16_t nominal_mA;          // Learned running current, 0 = not yet
+  CurrentFault_t fault;         // Verdict for the running (or last) fill
+  uint32_t dryTrips;            // Dry-run faults since boot
+  uint32_t stallTrips;          // Stall faults since boot
+} PumpCurrentStatus_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Set up the detector (sampling is started by AdcSampler_Init)
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_Init(void);
+
+/**
+  * @brief  Feed queued ADC blocks to the detector (main loop)
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_Process(void);
+
+/**
+  * @brief  Pump switched on - restart inrush blanking
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_Start(void);
+
+/**
+  * @brief  Fill ended with the tank full - learn the running current
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_FillComplete(void);
+
+/**
+  * @brief  Detector verdict for the running fill
+  * @param  None
+  * @retval CurrentFault_t CURRENT_FAULT_NONE unless dry or stalled
+  */
+CurrentFault_t PumpCurrent_GetFault(void);
+
+/**
+  * @brief  Get pump current status
+  * @param  None
+  * @retval const PumpCurrentStatus_t* Pointer to status
+  */
+const PumpCurrentStatus_t* PumpCurrent_GetStatus(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PUMP_CURRENT_H */
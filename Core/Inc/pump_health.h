@@ -0,0 +1,89 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : pump_health.h
+  * @brief          : Trend-based pump health model (integer only)
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * A wearing pump (or clogging filter) fills the tank more slowly every time.
+  * The model fits a least-squares line through the last PUMP_HEALTH_WINDOW
+  * complete fill durations and extrapolates when a fill will reach
+  * PUMP_NORMAL_FILL_TIME - the point where the firmware starts reporting a
+  * false "gallon empty". Error rate over the last 100 cycles and the duty
+  * cycle history add to the score. No floating point, O(window) per cycle.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __PUMP_HEALTH_H
+#define __PUMP_HEALTH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  How a pump cycle ended
+  */
+typedef enum {
+  PUMP_CYCLE_FULL = 0,          // Tank reached full - duration is a valid sample
+  PUMP_CYCLE_INTERRUPTED,       // Stopped early (door) - no duration sample
+  PUMP_CYCLE_ERROR              // Ended in an error - counts toward error rate
+} PumpCycleOutcome_t;
+
+/**
+  * @brief  Health report (recomputed after every cycle)
+  */
+typedef struct {
+  uint8_t  score;               // 0-100 (100 = perfect health)
+  uint16_t daysToFailure;       // Predicted days left, PUMP_HEALTH_DAYS_NONE if no trend
+  int32_t  trend_ms_per_fill;   // Least-squares slope of fill duration
+  uint32_t fitDuration_ms;      // Fitted duration of the latest fill
+  uint8_t  errorsPer100;        // Errors in the last 100 cycles
+  uint8_t  avgDutyPercent;      // Mean duty cycle over the trend window
+  uint8_t  samples;             // Fill durations in the trend window
+} PumpHealthReport_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define PUMP_HEALTH_WINDOW        16      // Fills in the trend fit
+#define PUMP_HEALTH_MIN_SAMPLES   4       // Fills before a trend is trusted
+#define PUMP_HEALTH_ERROR_WINDOW  100     // Cycles in the error rate
+#define PUMP_HEALTH_DAYS_NONE     0xFFFF  // Not degrading / not enough data
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Clear history
+  * @param  None
+  * @retval None
+  */
+void PumpHealth_Init(void);
+
+/**
+  * @brief  Record a finished pump cycle and recompute the report
+  * @param  runtime_ms Pump on time of the cycle
+  * @param  dutyPercent Duty cycle over the current window (0-100)
+  * @param  outcome How the cycle ended
+  * @retval None
+  */
+void PumpHealth_RecordCycle(uint32_t runtime_ms, uint8_t dutyPercent,
+                            PumpCycleOutcome_t outcome);
+
+/**
+  * @brief  Get the current health report
+  * @param  None
+  * @retval const PumpHealthReport_t* Pointer to report
+  */
+const PumpHealthReport_t* PumpHealth_GetReport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PUMP_HEALTH_H */
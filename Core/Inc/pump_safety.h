@@ -0,0 +1,92 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : pump_safety.h
+  * @brief          : Interrupt-level pump cutoff for Water Dispenser Control
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The level (EXTI1) and overflow (EXTI2) interrupts switch the pump off with
+  * a single GPIO register write and latch the cause. The state machine picks
+  * the latch up on its next pass and performs the normal state transition.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __PUMP_SAFETY_H
+#define __PUMP_SAFETY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  ISR cutoff statistics
+  */
+typedef struct {
+  uint32_t cutoffCount;         // Cutoffs performed while the pump was running
+  uint32_t lastLatency_us;      // Edge to pump-off latency of last cutoff (us)
+  uint32_t maxLatency_us;       // Worst edge to pump-off latency seen (us)
+} PumpSafetyStats_t;
+
+/* Exported constants --------------------------------------------------------*/
+
+// Latched cutoff sources (bit mask)
+#define PUMP_CUTOFF_NONE        0x00
+#define PUMP_CUTOFF_LEVEL       0x01    // Tank full edge on WATER_LIMIT
+#define PUMP_CUTOFF_OVERFLOW    0x02    // Overflow edge on OVERFLOW_SENSOR
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Initialize pump safety layer (enables DWT cycle counter)
+  * @param  None
+  * @retval None
+  */
+void PumpSafety_Init(void);
+
+/**
+  * @brief  Level sensor edge handler (call first thing in EXTI1 ISR)
+  * @param  entryCycles DWT cycle count read on ISR entry
+  * @retval None
+  */
+void PumpSafety_LevelEdgeISR(uint32_t entryCycles);
+
+/**
+  * @brief  Overflow sensor edge handler (call first thing in EXTI2 ISR)
+  * @param  entryCycles DWT cycle count read on ISR entry
+  * @retval None
+  */
+void PumpSafety_OverflowEdgeISR(uint32_t entryCycles);
+
+/**
+  * @brief  Switch pump on unless an ISR cutoff is latched (atomic)
+  * @param  None
+  * @retval uint8_t 1 if pump was switched on, 0 if refused
+  */
+uint8_t PumpSafety_PumpOn(void);
+
+/**
+  * @brief  Read and clear latched cutoff sources (call from state machine)
+  * @param  None
+  * @retval uint8_t PUMP_CUTOFF_xxx bit mask
+  */
+uint8_t PumpSafety_TakeLatched(void);
+
+/**
+  * @brief  Get ISR cutoff statistics
+  * @param  None
+  * @retval const PumpSafetyStats_t* Pointer to statistics
+  */
+const PumpSafetyStats_t* PumpSafety_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PUMP_SAFETY_H */
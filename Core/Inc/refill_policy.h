@@ -0,0 +1,113 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : refill_policy.h
+  * @brief          : Hysteresis refill policy that batches small top-ups
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The WATER_LIMIT switch reports "not full" as soon as one glass has been
+  * poured. Without a policy every glass starts the pump. This layer keeps
+  * the state machine in IDLE while the tank is below the switch, and lets a
+  * refill start when one of these is true:
+  *
+  * - No fill has finished since boot, so the level is unknown.
+  * - The low probe (ENABLE_LOW_PROBE) is dry.
+  * - The estimated volume consumed since the last fill reaches
+  *   REFILL_BATCH_ML.
+  * - REFILL_MAX_DEFER_MS has passed since the last fill. This bounds how
+  *   long the tank can be left low.
+  *
+  * Nothing measures what is poured out, so consumption is estimated. A fill
+  * that ends at the switch after a previous fill that also ended there puts
+  * back exactly what was drunk in between. Its volume divided by that gap is
+  * the consumption rate. The rate rises quickly and decays slowly, so the
+  * estimate errs towards refilling early.
+  *
+  * A door close still refills at once (WAIT_SETTLE is not gated). The user
+  * is at the unit, and a gallon swap is confirmed by the fill after it.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __REFILL_POLICY_H
+#define __REFILL_POLICY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Why a refill was allowed to start
+  */
+typedef enum {
+  REFILL_REASON_NONE = 0,       // Still waiting
+  REFILL_REASON_NO_HISTORY,     // No fill finished since boot
+  REFILL_REASON_LOW_PROBE,      // Low probe dry
+  REFILL_REASON_VOLUME,         // Estimated consumption reached REFILL_BATCH_ML
+  REFILL_REASON_TIME,           // REFILL_MAX_DEFER_MS since the last fill
+  REFILL_REASON_COUNT
+} RefillReason_t;
+
+/**
+  * @brief  Refill policy statistics
+  */
+typedef struct {
+  uint32_t rate_mlh;                    // Learned consumption rate (ml per hour, 0 = not learned)
+  uint32_t consumed_ml;                 // Estimated consumption since the last fill
+  uint32_t lastDefer_ms;                // How long the last refill was held back after the tank went low
+  uint32_t maxDefer_ms;                 // Longest hold-back since boot
+  uint32_t byReason[REFILL_REASON_COUNT]; // Refills started per reason
+  uint8_t  lastReason;                  // RefillReason_t of the last refill
+} RefillPolicyStats_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Configure the low probe input, forget the fill history
+  * @param  None
+  * @retval None
+  */
+void RefillPolicy_Init(void);
+
+/**
+  * @brief  Whether a refill should start now
+  * @param  None
+  * @retval uint8_t 1 to refill, 0 to keep waiting
+  * @note   Call only while the tank reads not full
+  */
+uint8_t RefillPolicy_RefillDue(void);
+
+/**
+  * @brief  Record a finished fill and learn the consumption rate from it
+  * @param  volume_ml Volume pumped by the fill
+  * @param  runtime_ms Pump on time of the fill
+  * @param  full 1 if the fill ended at the level switch
+  * @retval None
+  */
+void RefillPolicy_FillDone(uint32_t volume_ml, uint32_t runtime_ms, uint8_t full);
+
+/**
+  * @brief  Reason name (for reports)
+  * @param  reason RefillReason_t
+  * @retval const char* Name string
+  */
+const char* RefillPolicy_GetReasonName(uint8_t reason);
+
+/**
+  * @brief  Get refill policy statistics (refreshes the consumption estimate)
+  * @param  None
+  * @retval const RefillPolicyStats_t* Pointer to statistics
+  */
+const RefillPolicyStats_t* RefillPolicy_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __REFILL_POLICY_H */
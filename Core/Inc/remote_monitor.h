@@ -2,6 +2,7 @@
 #define REMOTE_MONITOR_H
 
 #include "main.h"
+#include "config.h"
 
 // Define this in config.h to enable
 #ifndef ENABLE_REMOTE_MONITOR
@@ -10,5 +11,13 @@
 
 void Remote_Init(void);
 void Remote_SendStatus(void);
+void Remote_SendLatencyReport(void);
+void Remote_SendPowerReport(void);
+void Remote_SendCrashReport(void);
+void Remote_SendMemoryReport(void);
+void Remote_SendSupervisorReport(void);
+void Remote_SendLog(void);
+void Remote_SendFormatBenchmark(void);
+void Remote_ClockChanged(void);
 
 #endif // REMOTE_MONITOR_H
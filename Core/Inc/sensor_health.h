@@ -0,0 +1,153 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : sensor_health.h
+  * @brief          : Sensor input health: adaptive debounce, chatter, stuck level
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Every EXTI edge of the door, level and overflow inputs passes through
+  * SensorHealth_EdgeISR() before the debounce check. Edges closer together
+  * than SENSOR_DEBOUNCE_MAX_MS form one bounce burst. The burst length feeds
+  * a per-input bounce estimate that rises halfway towards a longer burst
+  * and decays by 1/8 towards a shorter one. Each input's debounce window is
+  * twice its estimate, clamped to SENSOR_DEBOUNCE_MIN_MS..MAX_MS. A worn
+  * switch therefore gets a longer window, and a clean one reacts sooner.
+  *
+  * The same window gives Sensors_IsDoorClosed() and Sensors_IsTankEmpty()
+  * their debounce. "Closed" and "empty" are only reported once the input
+  * has been quiet for one window. "Open" and "full" are reported at once,
+  * so debouncing never delays stopping the pump.
+  *
+  * Two faults raise ERROR_SENSOR_FAULT:
+  *
+  * - Chatter: more than SENSOR_CHATTER_EDGES edges per minute on one input,
+  *   for SENSOR_CHATTER_MINUTES minutes in a row.
+  * - Stuck level switch: SENSOR_STUCK_FILLS fills in a row that ran at least
+  *   SENSOR_STUCK_MIN_RUN_MS with water available and saw no level edge.
+  *   The state machine decides whether water was available (a swapped or
+  *   not yet empty gallon) and reports the fill as a sensor fault instead of
+  *   an empty gallon or a pump timeout.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __SENSOR_HEALTH_H
+#define __SENSOR_HEALTH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Monitored sensor inputs (one EXTI line each)
+  */
+typedef enum {
+  SENSOR_INPUT_DOOR = 0,        // Door switch (EXTI0)
+  SENSOR_INPUT_LEVEL,           // Water level switch (EXTI1)
+  SENSOR_INPUT_OVERFLOW,        // Overflow sensor (EXTI2)
+  SENSOR_INPUT_COUNT
+} SensorInput_t;
+
+/**
+  * @brief  Health statistics of one input
+  */
+typedef struct {
+  uint32_t edges;               // Raw edges since boot, bounces included
+  uint32_t edgesLastMinute;     // Raw edges in the last full minute
+  uint32_t rejected;            // Edges dropped inside the debounce window
+  uint16_t bounce_ms;           // Bounce estimate
+  uint16_t maxBounce_ms;        // Longest bounce burst seen (capped at SENSOR_DEBOUNCE_MAX_MS)
+  uint16_t window_ms;           // Current debounce window
+  uint8_t  chatterMinutes;      // Consecutive minutes above SENSOR_CHATTER_EDGES
+  uint8_t  score;               // Health score 0..100
+} SensorInputStats_t;
+
+/**
+  * @brief  Sensor health statistics
+  */
+typedef struct {
+  SensorInputStats_t input[SENSOR_INPUT_COUNT];
+  uint8_t  stuckFills;          // Fills in a row without the level switch moving
+  uint8_t  lastFaultInput;      // SensorInput_t of the last fault (SENSOR_INPUT_COUNT = none)
+  uint32_t faults;              // Sensor faults raised since boot
+} SensorHealthStats_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Reset the estimates, windows at SENSOR_DEBOUNCE_INIT_MS
+  * @param  None
+  * @retval None
+  */
+void SensorHealth_Init(void);
+
+/**
+  * @brief  Count an EXTI edge and apply the input's debounce window (ISR context)
+  * @param  input Input the edge came from
+  * @param  now HAL tick
+  * @retval uint8_t 1 if the edge is outside the window, 0 if it is a bounce
+  */
+uint8_t SensorHealth_EdgeISR(SensorInput_t input, uint32_t now);
+
+/**
+  * @brief  Whether an input has had no edge for one debounce window
+  * @param  input Input to check
+  * @retval uint8_t 1 if quiet, 0 if it is still bouncing
+  */
+uint8_t SensorHealth_IsQuiet(SensorInput_t input);
+
+/**
+  * @brief  Fold finished bounce bursts, count edges per minute, raise chatter faults
+  * @param  None
+  * @retval None
+  * @note   Main loop context
+  */
+void SensorHealth_Process(void);
+
+/**
+  * @brief  A fill started
+  * @param  waterExpected 1 if the gallon should have water for this fill
+  * @retval None
+  */
+void SensorHealth_FillStart(uint8_t waterExpected);
+
+/**
+  * @brief  Whether the level switch is stuck if the running fill ends without water at the switch
+  * @param  runtime_ms Pump on time of the running fill
+  * @retval uint8_t 1 to stop the fill as a sensor fault
+  */
+uint8_t SensorHealth_LevelStuck(uint32_t runtime_ms);
+
+/**
+  * @brief  A fill ended: update the stuck level count
+  * @param  runtime_ms Pump on time of the fill
+  * @param  complete 0 if the door cut the fill short
+  * @retval None
+  */
+void SensorHealth_FillDone(uint32_t runtime_ms, uint8_t complete);
+
+/**
+  * @brief  Input name (for reports)
+  * @param  input SensorInput_t
+  * @retval const char* Name string
+  */
+const char* SensorHealth_GetInputName(uint8_t input);
+
+/**
+  * @brief  Get sensor health statistics (refreshes the scores)
+  * @param  None
+  * @retval const SensorHealthStats_t* Pointer to statistics
+  */
+const SensorHealthStats_t* SensorHealth_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SENSOR_HEALTH_H */
@@ -87,7 +87,7 @@ GPIO_PinState Sensors_ReadWaterLevelRaw(void);
 GPIO_PinState Sensors_DebouncedRead(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
 
 /**
-  * @brief  Test all sensors (for diagnostics)
+  * @brief  Test door and level inputs for chatter over 50 ms (for diagnostics)
   * @param  None
   * @retval uint8_t Test result: 0 = all OK, error code otherwise
   */
@@ -0,0 +1,105 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : seqlock.h
+  * @brief          : Sequence counter for lock-free consistent snapshots
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * One writer bumps the sequence to odd before touching the protected data
+  * and back to even afterwards. Readers copy the data and retry if the
+  * sequence was odd or changed meanwhile. Neither side masks interrupts.
+  *
+  * A reader that preempts the writer (ISR reading main-loop data) can never
+  * see an even sequence until it returns, so readers bound their retries.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __SEQLOCK_H
+#define __SEQLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Sequence lock (single writer)
+  */
+typedef struct {
+  volatile uint32_t sequence;   // Odd while a write is in progress
+  uint8_t depth;                // Writer nesting, only the outermost bumps
+} SeqLock_t;
+
+/* Exported constants --------------------------------------------------------*/
+#define SEQLOCK_READ_RETRIES    4     // Attempts before a reader gives up
+
+/* Exported macro ------------------------------------------------------------*/
+
+// Memory barrier. A host build can override it before including.
+#ifndef SEQLOCK_BARRIER
+  #include "main.h"
+  #define SEQLOCK_BARRIER()     __DMB()
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Start modifying the protected data (writer only, nestable)
+  * @param  lock Sequence lock
+  * @retval None
+  */
+static inline void SeqLock_WriteBegin(SeqLock_t* lock)
+{
+  if(lock->depth++ == 0U) {
+    lock->sequence++;
+    SEQLOCK_BARRIER();
+  }
+}
+
+/**
+  * @brief  Finish modifying the protected data (writer only)
+  * @param  lock Sequence lock
+  * @retval None
+  */
+static inline void SeqLock_WriteEnd(SeqLock_t* lock)
+{
+  if(--lock->depth == 0U) {
+    SEQLOCK_BARRIER();
+    lock->sequence++;
+  }
+}
+
+/**
+  * @brief  Sample the sequence before copying
+  * @param  lock Sequence lock
+  * @retval uint32_t Sequence value to pass to SeqLock_ReadRetry()
+  */
+static inline uint32_t SeqLock_ReadBegin(const SeqLock_t* lock)
+{
+  uint32_t start = lock->sequence;
+  SEQLOCK_BARRIER();
+  return start;
+}
+
+/**
+  * @brief  Check whether the copy just made may be torn
+  * @param  lock Sequence lock
+  * @param  start Value returned by SeqLock_ReadBegin()
+  * @retval uint8_t 1 if the copy must be discarded, 0 if consistent
+  */
+static inline uint8_t SeqLock_ReadRetry(const SeqLock_t* lock, uint32_t start)
+{
+  SEQLOCK_BARRIER();
+  return ((start & 1U) != 0U) || (lock->sequence != start);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SEQLOCK_H */
@@ -0,0 +1,78 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : stack_monitor.h
+  * @brief          : Stack painting high-water mark and early overflow warning
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Reset_Handler (startup_stm32f103c8tx.s) paints every word from the end of
+  * .noinit / heap (_end) up to the initial stack pointer with
+  * STACK_PAINT_PATTERN. The stack grows down into that region and overwrites
+  * the paint. Its lowest overwritten word is the high-water mark.
+  *
+  * StackMonitor_Process() runs from the main loop and checks at most
+  * STACK_SCAN_WORDS words per call, walking up from the heap top, so one
+  * full pass over ~14 KB takes a few dozen loop iterations and never stalls
+  * the loop. When the untouched paint left above the heap falls below
+  * STACK_WARN_HEADROOM, ERROR_STACK_LOW is raised once, before the stack can
+  * reach .bss and corrupt the state machine.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __STACK_MONITOR_H
+#define __STACK_MONITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported constants --------------------------------------------------------*/
+#define STACK_PAINT_PATTERN       0xA5A5A5A5U   // Must match Reset_Handler
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Stack and heap peaks
+  */
+typedef struct {
+  uint32_t stackPeak;           // Deepest stack use seen (bytes below _estack)
+  uint32_t stackReserved;       // _Min_Stack_Size from the linker script
+  uint32_t heapPeak;            // Heap grown by _sbrk (0 in the allocation-free build)
+  uint32_t headroom;            // Untouched paint between heap top and the stack
+  uint32_t passes;              // Completed scans (each one refreshes the values above)
+  uint8_t  warned;              // ERROR_STACK_LOW has been raised
+} StackMonitorStats_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Start the incremental scan over the painted region
+  * @param  None
+  * @retval None
+  */
+void StackMonitor_Init(void);
+
+/**
+  * @brief  Scan the next STACK_SCAN_WORDS words, raise the early warning (main loop)
+  * @param  None
+  * @retval None
+  */
+void StackMonitor_Process(void);
+
+/**
+  * @brief  Get stack and heap peaks
+  * @param  None
+  * @retval const StackMonitorStats_t* Pointer to statistics
+  */
+const StackMonitorStats_t* StackMonitor_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STACK_MONITOR_H */
@@ -0,0 +1,96 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : start_limiter.h
+  * @brief          : Token-bucket pump start limiter and start history
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Every pump start takes one token from a bucket that holds at most
+  * START_BURST tokens and regains START_REFILL_PER_HOUR tokens per hour.
+  * Normal use, even a burst of refills, never empties the bucket. A pump
+  * that starts again and again (a level sensor chattering around its
+  * threshold, a leak draining the tank) empties it within START_BURST
+  * starts. Then ERROR_RAPID_CYCLING is raised. How long each run lasted does
+  * not matter, only how often the pump starts.
+  *
+  * The tick of each start goes into a ring of the last START_HISTORY starts.
+  * The starts within the last hour are counted by expiring ring entries
+  * from the oldest end. Each entry expires once, so the count costs O(1)
+  * per query (amortized). The bucket limits starts to START_BURST +
+  * START_REFILL_PER_HOUR in any hour, and the ring is at least that long, so
+  * the count is exact.
+  *
+  * After a warm restart the bucket starts with a single token. A fault that
+  * resets the MCU on each fill therefore cannot short-cycle the pump.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __START_LIMITER_H
+#define __START_LIMITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Start limiter statistics
+  */
+typedef struct {
+  uint32_t starts;              // Pump starts since boot
+  uint32_t refused;             // Start requests refused with an empty bucket
+  uint32_t startsLastHour;      // Starts within the sliding last hour
+  uint32_t lastInterval_ms;     // Time between the last two starts
+  uint32_t minInterval_ms;      // Shortest time between two starts since boot (0 = fewer than two)
+  uint32_t tokens_x100;         // Tokens left, in hundredths
+} StartLimiterStats_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Fill the bucket (one token after a warm restart), clear the history
+  * @param  None
+  * @retval None
+  * @note   Call after WarmRestart_Init()
+  */
+void StartLimiter_Init(void);
+
+/**
+  * @brief  Whether the bucket has a token for one more pump start
+  * @param  None
+  * @retval uint8_t 1 if a start is allowed, 0 if the pump is cycling too often
+  */
+uint8_t StartLimiter_StartAllowed(void);
+
+/**
+  * @brief  Take a token and record the start in the history
+  * @param  None
+  * @retval None
+  */
+void StartLimiter_NoteStart(void);
+
+/**
+  * @brief  Tick of a recent pump start
+  * @param  age 0 = latest start, 1 = the one before, ...
+  * @retval uint32_t HAL tick, 0 if the history does not go back that far
+  */
+uint32_t StartLimiter_GetStart(uint8_t age);
+
+/**
+  * @brief  Get start limiter statistics (refreshes tokens and the hourly count)
+  * @param  None
+  * @retval const StartLimiterStats_t* Pointer to statistics
+  */
+const StartLimiterStats_t* StartLimiter_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __START_LIMITER_H */
@@ -41,7 +41,7 @@ typedef enum {
   */
 typedef struct {
   uint32_t totalPumpRunTime;    // Total accumulated pump runtime (ms)
-  uint32_t pumpCycleCount;      // Number of pump cycles since boot
+  uint32_t pumpCycleCount;      // Number of pump cycles (since first boot with a checkpoint)
   uint32_t lastFillDuration;    // Duration of last fill cycle (ms)
   uint32_t totalSystemUptime;   // Total time powered on
   uint32_t pumpAverageRuntime;  // Average per cycle
@@ -50,6 +50,9 @@ typedef struct {
   uint8_t  pumpHealthScore;     // 0-100 health metric
   uint32_t errorCount;          // Total error count
   uint8_t  lastErrorCode;       // Last error code
+  uint32_t lastSettleSaved;     // PUMP_STARTUP_DELAY minus the last settle phase (ms)
+  uint32_t totalSettleSaved;    // Settle time saved over all settle phases (ms)
+  uint32_t settleCount;         // Settle phases completed
 } SystemStats_t;
 
 /**
@@ -110,11 +113,36 @@ uint8_t StateMachine_GetErrorCode(void);
 
 /**
   * @brief  Get system statistics
+  * @note   Live data - only safe from the main loop between
+  *         StateMachine_Process() calls. Other readers use the snapshot.
   * @param  None
   * @retval SystemStats_t* Pointer to statistics structure
   */
 SystemStats_t* StateMachine_GetStats(void);
 
+/**
+  * @brief  Copy system statistics without tearing (lock-free, ISR safe)
+  * @param  out Destination for the snapshot
+  * @retval uint8_t 1 if out holds a consistent copy, 0 if the writer stayed
+  *         busy for every attempt (caller preempted it)
+  */
+uint8_t StateMachine_GetStatsSnapshot(SystemStats_t* out);
+
+/**
+  * @brief  Carry lifetime counters over from a power-fail checkpoint
+  * @param  saved Counters from the last checkpoint (cycles, runtime, errors)
+  * @retval None
+  */
+void StateMachine_RestoreStats(const SystemStats_t* saved);
+
+/**
+  * @brief  Resume the context saved before a watchdog or software reset
+  * @note   Call after StateMachine_Init() and Checkpoint_Init()
+  * @param  None
+  * @retval uint8_t 1 if resumed (warm restart), 0 on a cold start
+  */
+uint8_t StateMachine_Resume(void);
+
 /**
   * @brief  Force reset error state
   * @param  None
@@ -122,6 +150,14 @@ SystemStats_t* StateMachine_GetStats(void);
   */
 void StateMachine_ResetError(void);
 
+/**
+  * @brief  Latch an error detected outside the state handlers (pump off, ERROR state)
+  * @param  errorCode Error to latch
+  * @retval None
+  * @note   Main loop context only; ignored if an error is already latched
+  */
+void StateMachine_RaiseError(uint8_t errorCode);
+
 /**
   * @brief  Get state name string (for debugging)
   * @param  state State to get name for
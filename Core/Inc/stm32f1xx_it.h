@@ -47,10 +47,6 @@ extern "C" {
 
 /* Exported functions prototypes ---------------------------------------------*/
 void NMI_Handler(void);
-void HardFault_Handler(void);
-void MemManage_Handler(void);
-void BusFault_Handler(void);
-void UsageFault_Handler(void);
 void SVC_Handler(void);
 void DebugMon_Handler(void);
 void PendSV_Handler(void);
@@ -60,6 +56,10 @@ void EXTI1_IRQHandler(void);
 void EXTI2_IRQHandler(void);
 void TIM4_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void RTC_Alarm_IRQHandler(void);
+void DMA1_Channel1_IRQHandler(void);
+void PVD_IRQHandler(void);
+void WWDG_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -0,0 +1,162 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : supervisor.h
+  * @brief          : Task check-in watchdog supervisor, window watchdog and reset history
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Each main loop task checks in after it has run. The IWDG is refreshed
+  * only once every task has checked in since the previous refresh, so a
+  * task that stops being called resets the MCU even while the loop itself
+  * keeps spinning. A check-in later than the task's deadline is counted as
+  * a miss, and the gap is tracked against the worst seen.
+  *
+  * The WWDG is refreshed once per control pass, as soon as its window is
+  * open (SUP_WWDG_MIN_MS after the last refresh). A pass that follows the
+  * previous one more closely, e.g. after a blocking report, refreshes on a
+  * later loop turn. No control pass for SUP_WWDG_TIMEOUT_MS (blocked too
+  * long) resets the MCU. Before that reset, the early-wakeup interrupt
+  * switches the pump off and records it.
+  *
+  * Every boot adds the RCC_CSR reset cause to a history in .noinit RAM,
+  * which survives all resets except power loss. It also keeps the tasks
+  * that had not checked in when a watchdog fired.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __SUPERVISOR_H
+#define __SUPERVISOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+#include "warm_restart.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Supervised main loop tasks (one check-in bit each)
+  */
+typedef enum {
+  SUP_TASK_CONTROL = 0,         // Sensors, state machine, LEDs (every loop interval)
+  SUP_TASK_HOUSEKEEPING,        // Checkpoint re-arm, power governor, stack scan
+  SUP_TASK_IO,                  // Telemetry and log drain (every loop pass)
+  SUP_TASK_COUNT
+} SupervisorTask_t;
+
+/**
+  * @brief  Per-task check-in statistics
+  */
+typedef struct {
+  uint32_t deadline_ms;         // Longest allowed gap between check-ins
+  uint32_t lastCheckIn;         // HAL tick of the last check-in
+  uint32_t maxGap_ms;           // Longest gap seen since boot
+  uint32_t misses;              // Check-ins later than the deadline
+} SupervisorTaskStats_t;
+
+/**
+  * @brief  Reset history kept in .noinit RAM
+  */
+typedef struct {
+  uint32_t magic;
+  uint32_t boots;                           // Boots since the last power-on
+  uint16_t causeCount[RESET_CAUSE_COUNT];   // Boots per reset cause
+  uint8_t  lastCause;                       // ResetCause_t of this boot
+  uint8_t  starved;                         // Tasks not checked in when the last watchdog fired
+  uint8_t  late;                            // Tasks past their deadline at that time
+  uint8_t  wwdgEarly;                       // The last WWDG reset went through the early-wakeup interrupt
+  uint32_t check;                           // Checksum of the fields above
+  // Live copies, updated while running and taken over at the next boot
+  uint8_t  pending;
+  uint8_t  pendingLate;
+  uint8_t  pendingEarly;
+} SupervisorHistory_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Record the reset cause, start task deadlines and the WWDG
+  * @param  None
+  * @retval None
+  * @note   Call after WarmRestart_Init() and the other inits, before the
+  *         startup LED sequence
+  */
+void Supervisor_Init(void);
+
+/**
+  * @brief  Report that a task has run
+  * @param  task Task
+  * @retval None
+  */
+void Supervisor_CheckIn(SupervisorTask_t task);
+
+/**
+  * @brief  Count deadline misses, refresh the IWDG when all tasks checked
+  *         in and the WWDG once per control pass (every main loop pass)
+  * @param  None
+  * @retval None
+  */
+void Supervisor_Process(void);
+
+/**
+  * @brief  Restart deadlines after a gap in which the tasks could not run
+  *         (STOP mode, supervised delay)
+  * @param  None
+  * @retval None
+  */
+void Supervisor_Resync(void);
+
+/**
+  * @brief  Blocking delay that keeps both watchdogs fed
+  * @param  ms Delay in milliseconds
+  * @retval None
+  * @note   Only for bounded LED sequences (startup, diagnostics); tasks are
+  *         not supervised meanwhile
+  */
+void Supervisor_Delay(uint32_t ms);
+
+/**
+  * @brief  Recompute the WWDG prescaler and window after a PCLK1 change
+  * @param  None
+  * @retval None
+  */
+void Supervisor_ClockChanged(void);
+
+/**
+  * @brief  WWDG early-wakeup interrupt: pump off, record, let the reset happen
+  * @param  None
+  * @retval None
+  */
+void Supervisor_WwdgISR(void);
+
+/**
+  * @brief  Task statistics
+  * @param  task Task
+  * @retval const SupervisorTaskStats_t* Pointer to statistics
+  */
+const SupervisorTaskStats_t* Supervisor_GetTask(SupervisorTask_t task);
+
+/**
+  * @brief  Task name (for reports)
+  * @param  task Task
+  * @retval const char* Name string
+  */
+const char* Supervisor_GetTaskName(SupervisorTask_t task);
+
+/**
+  * @brief  Reset history including this boot
+  * @param  None
+  * @retval const SupervisorHistory_t* Pointer to the history
+  */
+const SupervisorHistory_t* Supervisor_GetHistory(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SUPERVISOR_H */
@@ -0,0 +1,85 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : timebase.h
+  * @brief          : Lightweight TIM4 tick and sub-tick time reads
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The HAL tick path (TIM4_IRQHandler -> HAL_TIM_IRQHandler -> callback ->
+  * HAL_IncTick) tests every TIM flag on each interrupt. Only the update
+  * interrupt is ever enabled on TIM4, so the minimal ISR clears UIF and
+  * advances uwTick. With TICK_PERIOD_MS = 10 the tick interrupts 100 times a
+  * second and HAL_GetTick() still has 1 ms resolution from the TIM4 counter.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Tick cost report (cycles measured once at init)
+  */
+typedef struct {
+  uint32_t tickRateHz;          // Active tick interrupt rate
+  uint32_t halIsrCycles;        // HAL_TIM_IRQHandler path, entry/exit included
+  uint32_t fastIsrCycles;       // Minimal path, entry/exit included
+  uint32_t baselineCyclesPerSec;// Original: HAL path at 1 kHz
+  uint32_t activeCyclesPerSec;  // Current configuration
+} TimebaseStats_t;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Minimal tick ISR body (call first in TIM4_IRQHandler)
+  * @note   Clear first: the write to SR needs a few cycles to reach the
+  *         peripheral before exception return, or the ISR tail-chains again.
+  * @param  None
+  * @retval None
+  */
+static inline void Timebase_TickISR(void)
+{
+  TIM4->SR = (uint32_t)~TIM_SR_UIF;
+  uwTick += uwTickFreq;
+}
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Apply TICK_PERIOD_MS and measure both tick paths
+  * @note   Call right after SystemClock_Config()
+  * @param  None
+  * @retval None
+  */
+void Timebase_Init(void);
+
+/**
+  * @brief  Microsecond timestamp from uwTick and the TIM4 counter (ISR safe)
+  * @note   Wraps every ~71 minutes - use for short intervals only
+  * @param  None
+  * @retval uint32_t Microseconds
+  */
+uint32_t Timebase_GetMicros(void);
+
+/**
+  * @brief  Get tick cost report
+  * @param  None
+  * @retval const TimebaseStats_t* Pointer to statistics
+  */
+const TimebaseStats_t* Timebase_GetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __TIMEBASE_H */
@@ -2,6 +2,7 @@
 #define USAGE_STATS_H
 
 #include "main.h"
+#include "config.h"
 
 // Define this in config.h to enable
 #ifndef ENABLE_USAGE_STATS
@@ -9,13 +10,14 @@
 #endif
 
 typedef struct {
-  uint32_t totalLitersPumped; // Estimated
+  uint32_t totalLitersPumped; // Flow meter if fitted, else estimated
   uint32_t totalFills;
   uint32_t totalRuntimeSec;
 } UsageStats_t;
 
 void UsageStats_Init(void);
-void UsageStats_Update(uint32_t fillDurationMs);
+void UsageStats_Update(uint32_t fillDurationMs, uint32_t volumeMl);
 UsageStats_t* UsageStats_Get(void);
+void UsageStats_Restore(const UsageStats_t* saved);
 
 #endif // USAGE_STATS_H
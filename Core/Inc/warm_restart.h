@@ -0,0 +1,109 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : warm_restart.h
+  * @brief          : Reset cause and warm-restart context in backup registers
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The state machine context (state, error, pump hold-off and the cycle
+  * and runtime counters) is packed into the ten 16-bit BKP data
+  * registers with a checksum on every state change. The backup domain keeps
+  * them across system resets.
+  *
+  * At boot the RCC_CSR reset flags decide: after a watchdog or software
+  * reset the context is resumed, so COOLDOWN / ERROR protection and pump
+  * interval survive. After power-on or a reset button press it is discarded.
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef __WARM_RESTART_H
+#define __WARM_RESTART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "config.h"
+#include "state_machine.h"
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+  * @brief  Reset cause from RCC_CSR, most specific flag first
+  */
+typedef enum {
+  RESET_CAUSE_POWER_ON = 0,     // POR/PDR - VDD was lost
+  RESET_CAUSE_PIN,              // NRST pin only (reset button, debugger)
+  RESET_CAUSE_IWDG,             // Independent watchdog
+  RESET_CAUSE_WWDG,             // Window watchdog
+  RESET_CAUSE_SOFTWARE,         // NVIC_SystemReset()
+  RESET_CAUSE_LOW_POWER,        // Illegal STOP/STANDBY entry
+  RESET_CAUSE_COUNT
+} ResetCause_t;
+
+/**
+  * @brief  State machine context kept across a warm restart
+  */
+typedef struct {
+  SystemState_t state;          // State at the last change
+  uint8_t  errorCode;           // Current error code
+  uint8_t  lastErrorCode;
+  uint32_t holdoff_ms;          // Time left before the pump may start again
+  uint32_t pumpCycleCount;
+  uint32_t totalPumpRunTime;    // ms
+  uint16_t errorCount;          // Saturates at 0xFFFF
+} WarmContext_t;
+
+/* Exported functions prototypes ---------------------------------------------*/
+
+/**
+  * @brief  Latch and clear the reset flags, decide warm or cold start
+  * @param  None
+  * @retval None
+  * @note   Call once, right after HAL_Init()
+  */
+void WarmRestart_Init(void);
+
+/**
+  * @brief  Reset cause latched at boot
+  * @param  None
+  * @retval ResetCause_t Reset cause
+  */
+ResetCause_t WarmRestart_GetResetCause(void);
+
+/**
+  * @brief  Reset cause name (for reports)
+  * @param  cause Reset cause
+  * @retval const char* Name string
+  */
+const char* WarmRestart_GetResetCauseName(ResetCause_t cause);
+
+/**
+  * @brief  Whether this boot resumes a valid context
+  * @param  None
+  * @retval uint8_t 1 for a warm restart
+  */
+uint8_t WarmRestart_IsWarm(void);
+
+/**
+  * @brief  Unpack the saved context
+  * @param  ctx Receives the context
+  * @retval uint8_t 1 on a warm restart with a valid context, 0 otherwise
+  */
+uint8_t WarmRestart_Load(WarmContext_t* ctx);
+
+/**
+  * @brief  Pack the context into the backup registers (every state change)
+  * @param  ctx Context to save
+  * @retval None
+  */
+void WarmRestart_Save(const WarmContext_t* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WARM_RESTART_H */
@@ -0,0 +1,351 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : adc_sampler.c
+  * @brief          : Timer-triggered ADC1 sampling into a circular DMA buffer
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "adc_sampler.h"
+#include "seqlock.h"
+
+/* Private define ------------------------------------------------------------*/
+#define ADC_SAMPLER_USED      (ENABLE_PUMP_CURRENT || ENABLE_BATTERY_MONITOR)
+
+#define HALF_LEN              (ADC_SAMPLER_BLOCK * ADC_CH_COUNT)
+#define BUFFER_LEN            (HALF_LEN * 2U)
+#define QUEUE_MASK            (ADC_SAMPLER_QUEUE - 1U)
+
+// Sample time codes at 4 MHz ADC clock
+#define ADC_SMP_28_5          0x3U          // 7 us: low impedance current sensor
+#define ADC_SMP_71_5          0x6U          // 18 us: divider, VREFINT, temp sensor (>= 17.1 us)
+#define ADC_EXTSEL_TIM3_TRGO  ADC_CR2_EXTSEL_2
+
+#define OVERSAMPLE_SHIFT      4U            // 256 samples -> 4 extra bits
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  uint8_t channel;                          // ADC input number
+  uint8_t sampleTime;                       // SMPx code
+} SequenceSlot_t;
+
+/* Private variables ---------------------------------------------------------*/
+static uint32_t overruns = 0;
+
+#if ADC_SAMPLER_USED
+
+// Scan sequence in AdcChannel_t order
+static const SequenceSlot_t sequence[ADC_CH_COUNT] = {
+  { 3,  ADC_SMP_28_5 },                     // ADC_CH_PUMP_CURRENT: PA3
+  { 4,  ADC_SMP_71_5 },                     // ADC_CH_BATTERY: PA4
+  { 17, ADC_SMP_71_5 },                     // ADC_CH_VREFINT
+  { 16, ADC_SMP_71_5 },                     // ADC_CH_TEMP
+};
+
+static volatile uint16_t dmaBuffer[BUFFER_LEN];
+static volatile uint16_t queue[ADC_SAMPLER_QUEUE][ADC_CH_COUNT];
+static volatile uint8_t queueHead = 0;      // Written by the DMA ISR only
+static volatile uint8_t queueTail = 0;      // Written by the main loop only
+
+static uint32_t decimateSum[ADC_CH_COUNT];  // DMA ISR only
+static uint8_t decimateBlocks = 0;
+static uint16_t oversampled[ADC_CH_COUNT];  // Published by the ISR under seqLock
+static SeqLock_t oversampledLock;
+
+/* Private function prototypes -----------------------------------------------*/
+static void ReduceHalf(const volatile uint16_t* half);
+static uint8_t ReadPair(AdcChannel_t ch, uint16_t* value, uint16_t* vref);
+static void StartTrigger(void);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Configure TIM3, ADC1 and DMA1 channel 1 and start sampling
+  * @param  None
+  * @retval None
+  */
+void AdcSampler_Init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+  __HAL_RCC_ADC1_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  __HAL_RCC_TIM3_CLK_ENABLE();
+
+  GPIO_InitStruct.Pin = GPIO_PIN_3 | GPIO_PIN_4;
+  GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+  // ADC clock = PCLK2 / 2 = 4 MHz (max 14 MHz)
+  RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_ADCPRE) | RCC_CFGR_ADCPRE_DIV2;
+
+  // Sequence and sample times
+  ADC1->SQR1 = (uint32_t)(ADC_CH_COUNT - 1U) << ADC_SQR1_L_Pos;
+  ADC1->SQR2 = 0;
+  ADC1->SQR3 = 0;
+  for(uint32_t i = 0; i < ADC_CH_COUNT; i++) {
+    uint32_t ch = sequence[i].channel;
+    uint32_t smp = sequence[i].sampleTime;
+    if(i < 6U) {
+      ADC1->SQR3 |= ch << (5U * i);
+    } else {
+      ADC1->SQR2 |= ch << (5U * (i - 6U));
+    }
+    if(ch < 10U) {
+      ADC1->SMPR2 |= smp << (3U * ch);
+    } else {
+      ADC1->SMPR1 |= smp << (3U * (ch - 10U));
+    }
+  }
+  ADC1->CR1 = (ADC_CH_COUNT > 1U) ? ADC_CR1_SCAN : 0U;
+
+  // Power up (with VREFINT and temp sensor) and calibrate before DMA requests are enabled
+  ADC1->CR2 = ADC_CR2_ADON | ADC_CR2_TSVREFE;
+  for(volatile uint32_t i = 0; i < 16U; i++) { }   // tSTAB >= 1 us
+  ADC1->CR2 |= ADC_CR2_RSTCAL;
+  while(ADC1->CR2 & ADC_CR2_RSTCAL) { }
+  ADC1->CR2 |= ADC_CR2_CAL;
+  while(ADC1->CR2 & ADC_CR2_CAL) { }
+
+  // DMA1 channel 1: ADC1->DR -> dmaBuffer, 16-bit, circular, both halves
+  DMA1_Channel1->CCR = 0;
+  DMA1_Channel1->CPAR = (uint32_t)&ADC1->DR;
+  DMA1_Channel1->CMAR = (uint32_t)dmaBuffer;
+  DMA1_Channel1->CNDTR = BUFFER_LEN;
+  DMA1_Channel1->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_PSIZE_0 | DMA_CCR_MSIZE_0 |
+                       DMA_CCR_HTIE | DMA_CCR_TCIE | DMA_CCR_TEIE;
+  DMA1->IFCR = DMA_IFCR_CGIF1;
+  HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+  DMA1_Channel1->CCR |= DMA_CCR_EN;
+
+  // Conversions start on TIM3 TRGO. Changing other CR2 bits with ADON
+  // already set does not start a conversion.
+  ADC1->CR2 |= ADC_EXTSEL_TIM3_TRGO | ADC_CR2_EXTTRIG | ADC_CR2_DMA;
+
+  StartTrigger();
+}
+
+/**
+  * @brief  Retune the sample trigger after a core clock change
+  * @param  None
+  * @retval None
+  */
+void AdcSampler_ClockChanged(void)
+{
+  StartTrigger();
+}
+
+/**
+  * @brief  Take the oldest queued block
+  * @param  means Receives one mean (raw 12-bit counts) per channel
+  * @retval uint8_t 1 if a block was taken, 0 if the queue is empty
+  */
+uint8_t AdcSampler_PopBlock(uint16_t means[ADC_CH_COUNT])
+{
+  uint8_t tail = queueTail;
+
+  if(tail == queueHead) {
+    return 0;
+  }
+
+  for(uint32_t i = 0; i < ADC_CH_COUNT; i++) {
+    means[i] = queue[tail & QUEUE_MASK][i];
+  }
+  queueTail = (uint8_t)(tail + 1U);
+  return 1;
+}
+
+/**
+  * @brief  Latest oversampled value of a channel (O(1), non-blocking)
+  * @param  ch Channel
+  * @retval uint16_t 16-bit result (0..ADC_OVERSAMPLED_FS), 0 before the first
+  */
+uint16_t AdcSampler_GetOversampled(AdcChannel_t ch)
+{
+  return oversampled[ch];
+}
+
+/**
+  * @brief  Pin voltage of a channel, ratiometric to VREFINT
+  * @param  ch Channel
+  * @retval uint16_t Millivolts, 0 before the first oversampled result
+  */
+uint16_t AdcSampler_GetMillivolts(AdcChannel_t ch)
+{
+  uint16_t value, vref;
+
+  if(!ReadPair(ch, &value, &vref)) {
+    return 0;
+  }
+  // V = counts / counts(VREFINT) * VREFINT: independent of VDDA
+  return (uint16_t)(((uint32_t)value * ADC_VREFINT_MV) / vref);
+}
+
+/**
+  * @brief  Analog supply voltage derived from VREFINT
+  * @param  None
+  * @retval uint16_t Millivolts, 0 before the first oversampled result
+  */
+uint16_t AdcSampler_GetVdda_mV(void)
+{
+  uint16_t vref = oversampled[ADC_CH_VREFINT];
+
+  if(vref == 0U) {
+    return 0;
+  }
+  return (uint16_t)((ADC_OVERSAMPLED_FS * ADC_VREFINT_MV) / vref);
+}
+
+/**
+  * @brief  Die temperature from the internal sensor (typical V25 / slope)
+  * @param  None
+  * @retval int16_t Tenths of a degree Celsius
+  */
+int16_t AdcSampler_GetChipTemp_dC(void)
+{
+  uint16_t value, vref;
+
+  if(!ReadPair(ADC_CH_TEMP, &value, &vref)) {
+    return 0;
+  }
+
+  // Sensor voltage in uV, then T = 25 C + (V25 - Vsense) / slope
+  int32_t vsense_uV = (int32_t)(((uint64_t)value * ADC_VREFINT_MV * 1000U) / vref);
+  int32_t delta_uV = ((int32_t)ADC_TEMP_V25_MV * 1000) - vsense_uV;
+  return (int16_t)(250 + (delta_uV * 10) / (int32_t)ADC_TEMP_SLOPE_UV_PER_C);
+}
+
+/**
+  * @brief  Blocks dropped because the main loop fell behind
+  * @param  None
+  * @retval uint32_t Overrun count
+  */
+uint32_t AdcSampler_GetOverruns(void)
+{
+  return overruns;
+}
+
+/**
+  * @brief  DMA1 channel 1 half/full transfer handler
+  * @param  None
+  * @retval None
+  */
+void AdcSampler_DmaISR(void)
+{
+  uint32_t flags = DMA1->ISR;
+
+  // Both pending means this ISR ran late: the first half is the older one
+  if(flags & DMA_ISR_HTIF1) {
+    DMA1->IFCR = DMA_IFCR_CHTIF1;
+    ReduceHalf(&dmaBuffer[0]);
+  }
+  if(flags & DMA_ISR_TCIF1) {
+    DMA1->IFCR = DMA_IFCR_CTCIF1;
+    ReduceHalf(&dmaBuffer[HALF_LEN]);
+  }
+  if(flags & DMA_ISR_TEIF1) {
+    // Channel was disabled by hardware - restart it
+    DMA1->IFCR = DMA_IFCR_CGIF1;
+    DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+    DMA1_Channel1->CNDTR = BUFFER_LEN;
+    DMA1_Channel1->CCR |= DMA_CCR_EN;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Reduce one half buffer: accumulate the oversampled result and
+  *         queue the per-channel block means
+  */
+static void ReduceHalf(const volatile uint16_t* half)
+{
+  uint32_t sum[ADC_CH_COUNT] = {0};
+
+  for(uint32_t n = 0; n < ADC_SAMPLER_BLOCK; n++) {
+    for(uint32_t i = 0; i < ADC_CH_COUNT; i++) {
+      sum[i] += *half++;
+    }
+  }
+
+  // Oversample: 256 samples summed, >> 4 keeps 16 significant bits
+  for(uint32_t i = 0; i < ADC_CH_COUNT; i++) {
+    decimateSum[i] += sum[i];
+  }
+  if(++decimateBlocks >= ADC_SAMPLER_DECIMATE) {
+    SeqLock_WriteBegin(&oversampledLock);
+    for(uint32_t i = 0; i < ADC_CH_COUNT; i++) {
+      oversampled[i] = (uint16_t)(decimateSum[i] >> OVERSAMPLE_SHIFT);
+      decimateSum[i] = 0;
+    }
+    SeqLock_WriteEnd(&oversampledLock);
+    decimateBlocks = 0;
+  }
+
+  #if ENABLE_PUMP_CURRENT
+  // Only the pump current detector consumes blocks
+  uint8_t head = queueHead;
+  if((uint8_t)(head - queueTail) >= ADC_SAMPLER_QUEUE) {
+    overruns++;       // Keep the older blocks: the consumer owns the tail
+    return;
+  }
+  for(uint32_t i = 0; i < ADC_CH_COUNT; i++) {
+    queue[head & QUEUE_MASK][i] = (uint16_t)((sum[i] + (ADC_SAMPLER_BLOCK / 2U)) / ADC_SAMPLER_BLOCK);
+  }
+  queueHead = (uint8_t)(head + 1U);
+  #endif
+}
+
+/**
+  * @brief  Consistent copy of a channel and VREFINT from the same result
+  */
+static uint8_t ReadPair(AdcChannel_t ch, uint16_t* value, uint16_t* vref)
+{
+  for(uint8_t attempt = 0; attempt < SEQLOCK_READ_RETRIES; attempt++) {
+    uint32_t start = SeqLock_ReadBegin(&oversampledLock);
+    *value = oversampled[ch];
+    *vref = oversampled[ADC_CH_VREFINT];
+    if(!SeqLock_ReadRetry(&oversampledLock, start)) {
+      return (*vref != 0U);
+    }
+  }
+  return 0;
+}
+
+/**
+  * @brief  TIM3: 1 MHz count, update (TRGO) at ADC_SAMPLE_RATE_HZ
+  */
+static void StartTrigger(void)
+{
+  uint32_t timClock = HAL_RCC_GetPCLK1Freq();
+
+  if((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1) {
+    timClock *= 2U;
+  }
+  TIM3->CR1 = 0;
+  TIM3->PSC = (timClock / 1000000U) - 1U;
+  TIM3->ARR = (1000000U / ADC_SAMPLE_RATE_HZ) - 1U;
+  TIM3->CR2 = TIM_CR2_MMS_1;                      // MMS = 010: update -> TRGO
+  TIM3->EGR = TIM_EGR_UG;
+  TIM3->CR1 = TIM_CR1_CEN;
+}
+
+#else
+
+// Stubs if disabled
+void AdcSampler_Init(void) {}
+void AdcSampler_ClockChanged(void) {}
+uint8_t AdcSampler_PopBlock(uint16_t means[ADC_CH_COUNT]) { return 0; }
+uint16_t AdcSampler_GetOversampled(AdcChannel_t ch) { return 0; }
+uint16_t AdcSampler_GetMillivolts(AdcChannel_t ch) { return 0; }
+uint16_t AdcSampler_GetVdda_mV(void) { return 0; }
+int16_t AdcSampler_GetChipTemp_dC(void) { return 0; }
+uint32_t AdcSampler_GetOverruns(void) { return overruns; }
+void AdcSampler_DmaISR(void) {}
+
+#endif // ADC_SAMPLER_USED
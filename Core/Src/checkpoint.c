@@ -0,0 +1,300 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : checkpoint.c
+  * @brief          : Power-fail checkpoint of lifetime counters to flash
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "checkpoint.h"
+#include "state_machine.h"
+#include "usage_stats.h"
+#include "cycle_counter.h"
+#include "deferred_log.h"
+
+/* Private typedef -----------------------------------------------------------*/
+
+/**
+  * @brief  One flash slot (32 bytes, programmed as 16 half-words)
+  */
+typedef struct {
+  uint16_t magic;               // Commit marker, programmed last
+  uint16_t flush_us;            // Time to program the payload, programmed second to last
+  uint32_t pumpCycleCount;
+  uint32_t totalPumpRunTime;    // ms
+  uint32_t errorCount;
+  uint32_t litersPumped;
+  uint32_t fills;
+  uint32_t runtimeSec;
+  uint8_t  lastErrorCode;
+  uint8_t  sequence;
+  uint16_t check;               // Fletcher checksum over the payload
+} CheckpointRecord_t;
+
+/* Private define ------------------------------------------------------------*/
+#define CHECKPOINT_MAGIC        0xC4EDU
+#define RECORD_HALFWORDS        (sizeof(CheckpointRecord_t) / 2U)
+#define PAYLOAD_FIRST           2U                          // After magic and flush_us
+#define PAYLOAD_HALFWORDS       (RECORD_HALFWORDS - PAYLOAD_FIRST - 1U)
+#define CHECKPOINT_SLOTS        (FLASH_PAGE_SIZE / sizeof(CheckpointRecord_t))
+#define SLOT(n)                 ((const CheckpointRecord_t*)(CHECKPOINT_FLASH_ADDR + (n) * sizeof(CheckpointRecord_t)))
+#define COMMIT_HALFWORDS        2U                          // flush_us and magic, not in flush_us
+#define FLASH_TPROG_MAX_US      70U                         // Half-word program time (datasheet max)
+
+/* Private variables ---------------------------------------------------------*/
+static CheckpointStatus_t status;
+
+#if ENABLE_POWER_FAIL_CHECKPOINT
+
+static uint8_t nextSlot = 0;
+static volatile uint8_t armed = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t Checksum(const CheckpointRecord_t* rec);
+static uint8_t SlotErased(uint32_t n);
+static const CheckpointRecord_t* ScanPage(void);
+static void ErasePage(void);
+static void ProgramHalfWord(uint32_t addr, uint16_t value);
+static void Flush(uint32_t startCycles);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Restore the newest checkpoint, prepare a free slot and arm the PVD
+  * @param  None
+  * @retval None
+  * @note   Call after StateMachine_Init() - it overwrites the zeroed counters
+  */
+void Checkpoint_Init(void)
+{
+  PWR_PVDTypeDef pvd = {0};
+  const CheckpointRecord_t* rec = ScanPage();
+
+  if(rec != NULL) {
+    SystemStats_t saved = {0};
+    UsageStats_t usage;
+
+    saved.pumpCycleCount = rec->pumpCycleCount;
+    saved.totalPumpRunTime = rec->totalPumpRunTime;
+    saved.errorCount = rec->errorCount;
+    saved.lastErrorCode = rec->lastErrorCode;
+    StateMachine_RestoreStats(&saved);
+
+    usage.totalLitersPumped = rec->litersPumped;
+    usage.totalFills = rec->fills;
+    usage.totalRuntimeSec = rec->runtimeSec;
+    UsageStats_Restore(&usage);
+
+    status.restored = 1;
+    status.sequence = rec->sequence;
+    status.lastFlush_us = rec->flush_us;
+    status.overBudget = (rec->flush_us + COMMIT_HALFWORDS * FLASH_TPROG_MAX_US) > CHECKPOINT_BUDGET_US;
+    LOG_INFO("checkpoint %u restored: %u cycles, flush %u us", rec->sequence, rec->pumpCycleCount, rec->flush_us);
+  }
+
+  // Erasing stalls flash reads for ~20 ms: only ever done here, never on the way down
+  if(nextSlot >= CHECKPOINT_SLOTS) {
+    ErasePage();
+  }
+  status.freeSlots = (uint8_t)(CHECKPOINT_SLOTS - nextSlot);
+
+  // PVD output rises when VDD falls below the threshold
+  __HAL_RCC_PWR_CLK_ENABLE();
+  pvd.PVDLevel = CHECKPOINT_PVD_LEVEL;
+  pvd.Mode = PWR_PVD_MODE_IT_RISING;
+  HAL_PWR_ConfigPVD(&pvd);
+  HAL_PWR_EnablePVD();
+  armed = ((PWR->CSR & PWR_CSR_PVDO) == 0U);
+
+  // Same top priority as the overflow cutoff: nothing may delay the flush
+  HAL_NVIC_SetPriority(PVD_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(PVD_IRQn);
+}
+
+/**
+  * @brief  Re-arm the flush once VDD is back above the PVD threshold (main loop)
+  * @param  None
+  * @retval None
+  */
+void Checkpoint_Process(void)
+{
+  if(!armed && (PWR->CSR & PWR_CSR_PVDO) == 0U) {
+    armed = 1;
+  }
+}
+
+/**
+  * @brief  PVD interrupt handler - write the checkpoint record
+  * @param  None
+  * @retval None
+  */
+void Checkpoint_PvdISR(void)
+{
+  uint32_t start = CycleCounter_Now();
+
+  __HAL_PWR_PVD_EXTI_CLEAR_FLAG();
+
+  // One record per power-down; a supply that recovers re-arms from the main loop
+  if(armed && (PWR->CSR & PWR_CSR_PVDO)) {
+    armed = 0;
+    Flush(start);
+  }
+}
+
+/**
+  * @brief  Get checkpoint status
+  * @param  None
+  * @retval const CheckpointStatus_t* Pointer to status
+  */
+const CheckpointStatus_t* Checkpoint_GetStatus(void)
+{
+  return &status;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Fletcher-16 over the payload half-words
+  */
+static uint16_t Checksum(const CheckpointRecord_t* rec)
+{
+  const uint16_t* hw = (const uint16_t*)rec;
+  uint32_t a = 0xFFU;
+  uint32_t b = 0xFFU;
+
+  for(uint32_t i = PAYLOAD_FIRST; i < PAYLOAD_FIRST + PAYLOAD_HALFWORDS; i++) {
+    a = (a + hw[i]) % 0xFFU;
+    b = (b + a) % 0xFFU;
+  }
+  return (uint16_t)((b << 8) | a);
+}
+
+/**
+  * @brief  Whether every half-word of a slot reads erased
+  */
+static uint8_t SlotErased(uint32_t n)
+{
+  const uint16_t* hw = (const uint16_t*)SLOT(n);
+
+  for(uint32_t i = 0; i < RECORD_HALFWORDS; i++) {
+    if(hw[i] != 0xFFFFU) return 0;
+  }
+  return 1;
+}
+
+/**
+  * @brief  Find the first free slot after the last used one
+  * @retval Newest valid record, NULL if there is none
+  */
+static const CheckpointRecord_t* ScanPage(void)
+{
+  const CheckpointRecord_t* newest = NULL;
+
+  nextSlot = 0;
+  for(uint32_t n = 0; n < CHECKPOINT_SLOTS; n++) {
+    const CheckpointRecord_t* rec = SLOT(n);
+    if(SlotErased(n)) continue;
+    nextSlot = (uint8_t)(n + 1U);
+    // A record torn by the brownout fails here and the one before it stays newest
+    if(rec->magic == CHECKPOINT_MAGIC && rec->check == Checksum(rec)) {
+      newest = rec;
+    }
+  }
+  return newest;
+}
+
+/**
+  * @brief  Erase the checkpoint page (boot only)
+  */
+static void ErasePage(void)
+{
+  FLASH_EraseInitTypeDef eraseInit = {0};
+  uint32_t pageError;
+
+  eraseInit.TypeErase = FLASH_TYPEERASE_PAGES;
+  eraseInit.PageAddress = CHECKPOINT_FLASH_ADDR;
+  eraseInit.NbPages = 1;
+
+  HAL_FLASH_Unlock();
+  HAL_FLASHEx_Erase(&eraseInit, &pageError);
+  HAL_FLASH_Lock();
+  nextSlot = 0;
+}
+
+/**
+  * @brief  Program one half-word by register (no HAL tick timeout in the PVD ISR)
+  */
+static void ProgramHalfWord(uint32_t addr, uint16_t value)
+{
+  FLASH->CR |= FLASH_CR_PG;
+  *(volatile uint16_t*)addr = value;
+  while(FLASH->SR & FLASH_SR_BSY) { }
+  FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPRTERR;
+  FLASH->CR &= ~FLASH_CR_PG;
+}
+
+/**
+  * @brief  Build the record and program it into the next pre-erased slot
+  */
+static void Flush(uint32_t startCycles)
+{
+  CheckpointRecord_t rec;
+  SystemStats_t stats;
+  const UsageStats_t* usage = UsageStats_Get();
+
+  if(nextSlot >= CHECKPOINT_SLOTS) {
+    status.skipped++;
+    return;
+  }
+
+  // Main loop preempted mid-update: a torn copy still beats losing everything
+  if(!StateMachine_GetStatsSnapshot(&stats)) {
+    stats = *StateMachine_GetStats();
+  }
+
+  rec.magic = CHECKPOINT_MAGIC;
+  rec.pumpCycleCount = stats.pumpCycleCount;
+  rec.totalPumpRunTime = stats.totalPumpRunTime;
+  rec.errorCount = stats.errorCount;
+  rec.lastErrorCode = stats.lastErrorCode;
+  rec.litersPumped = usage ? usage->totalLitersPumped : 0U;
+  rec.fills = usage ? usage->totalFills : 0U;
+  rec.runtimeSec = usage ? usage->totalRuntimeSec : 0U;
+  rec.sequence = (uint8_t)(status.sequence + 1U);
+  rec.check = Checksum(&rec);
+
+  const uint16_t* hw = (const uint16_t*)&rec;
+  uint32_t addr = (uint32_t)SLOT(nextSlot);
+
+  if(FLASH->CR & FLASH_CR_LOCK) {
+    FLASH->KEYR = FLASH_KEY1;
+    FLASH->KEYR = FLASH_KEY2;
+  }
+
+  for(uint32_t i = PAYLOAD_FIRST; i < RECORD_HALFWORDS; i++) {
+    ProgramHalfWord(addr + 2U * i, hw[i]);
+  }
+  uint32_t us = CycleCounter_ToMicros(CycleCounter_Now() - startCycles);
+  ProgramHalfWord(addr + 2U, (uint16_t)(us > 0xFFFFU ? 0xFFFFU : us));
+  ProgramHalfWord(addr, CHECKPOINT_MAGIC);
+  FLASH->CR |= FLASH_CR_LOCK;
+
+  nextSlot++;
+  status.freeSlots = (uint8_t)(CHECKPOINT_SLOTS - nextSlot);
+  status.sequence = rec.sequence;
+  status.lastFlush_us = (uint16_t)(us > 0xFFFFU ? 0xFFFFU : us);
+  status.flushes++;
+}
+
+#else
+
+// Stubs if disabled - counters start from zero at every boot
+void Checkpoint_Init(void) {}
+void Checkpoint_Process(void) {}
+void Checkpoint_PvdISR(void) {}
+const CheckpointStatus_t* Checkpoint_GetStatus(void) { return &status; }
+
+#endif // ENABLE_POWER_FAIL_CHECKPOINT
@@ -0,0 +1,283 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : crash_dump.c
+  * @brief          : Fault capture in .noinit RAM with post-mortem report
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "crash_dump.h"
+#include "state_machine.h"
+#include "deferred_log.h"
+
+/* Private define ------------------------------------------------------------*/
+#define CRASH_MAGIC             0xDEADC0DEU
+#define CRASH_SLOT_SIZE         128U                        // Record rounded up to a power of two
+#define CRASH_SLOTS             (FLASH_PAGE_SIZE / CRASH_SLOT_SIZE)
+#define CRASH_SLOT(n)           ((const CrashRecord_t*)(CRASH_FLASH_ADDR + (n) * CRASH_SLOT_SIZE))
+#define RECORD_WORDS            (sizeof(CrashRecord_t) / 4U)
+#define FRAME_WORDS             8U                          // r0-r3, r12, lr, pc, xPSR
+#define RAM_START               SRAM_BASE
+#define RAM_END                 ((uint32_t)&_estack)        // Top of RAM per the linker script
+#define FAULT_STACK_WORDS       64U                         // 256 bytes, the capture path is a few calls deep
+#define XPSR_STACK_ALIGN        (1UL << 9)                  // Frame was padded to 8 bytes
+
+_Static_assert(sizeof(CrashRecord_t) <= CRASH_SLOT_SIZE, "crash record overruns its flash slot");
+
+/* Private variables ---------------------------------------------------------*/
+extern uint32_t _estack;                // Linker script symbol
+
+static const char* const faultNames[CRASH_FAULT_COUNT] = {
+  "hard", "memmanage", "bus", "usage"
+};
+
+#if ENABLE_CRASH_DUMP
+
+// Survives the reset: the startup code neither copies nor zeroes .noinit
+static CrashRecord_t crash __attribute__((section(".noinit")));
+
+// Capture runs here, not on the faulting MSP: after a stack overflow that
+// one is exhausted, and pushing onto it again would fault inside the fault
+static uint32_t faultStack[FAULT_STACK_WORDS] __attribute__((section(".noinit"), aligned(8)));
+
+static const CrashRecord_t* last = NULL;
+static uint8_t isNew = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Checksum(const CrashRecord_t* rec);
+static uint8_t RecordValid(const CrashRecord_t* rec);
+static uint8_t SlotErased(uint32_t n);
+static uint32_t ScanPage(void);
+static const CrashRecord_t* Persist(const CrashRecord_t* rec, uint32_t slot);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Enable the configurable fault handlers, persist a pending record
+  * @param  None
+  * @retval None
+  * @note   Call early, before anything that could fault
+  */
+void CrashDump_Init(void)
+{
+  uint32_t nextSlot = ScanPage();
+
+  // Without these, every fault escalates to HardFault and CFSR is all we learn
+  SCB->SHCSR |= SCB_SHCSR_USGFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_MEMFAULTENA_Msk;
+
+  if(RecordValid(&crash)) {
+    crash.sequence = (last != NULL) ? (uint8_t)(last->sequence + 1U) : 1U;
+    crash.check = Checksum(&crash);
+    const CrashRecord_t* stored = Persist(&crash, nextSlot);
+    last = RecordValid(stored) ? stored : last;
+    isNew = 1;
+    LOG_ERROR("crash %u: fault %u pc 0x%08x cfsr 0x%08x", crash.sequence, crash.fault, crash.pc, crash.cfsr);
+  }
+  // Consumed: a later reset for another reason must not report it again
+  crash.magic = 0;
+}
+
+/**
+  * @brief  Newest crash record (from this reset or from flash)
+  * @param  None
+  * @retval const CrashRecord_t* Record, NULL if none is stored
+  */
+const CrashRecord_t* CrashDump_GetLast(void)
+{
+  return last;
+}
+
+/**
+  * @brief  Whether the last reset was caused by a captured fault
+  * @param  None
+  * @retval uint8_t 1 if the record was captured just before this boot
+  */
+uint8_t CrashDump_IsNew(void)
+{
+  return isNew;
+}
+
+/**
+  * @brief  Common fault entry, called from the naked handlers
+  * @param  frame Stacked exception frame (r0-r3, r12, lr, pc, xPSR)
+  * @param  excReturn EXC_RETURN value from LR
+  * @param  fault Fault handler id
+  * @retval None (resets the MCU)
+  */
+void CrashDump_Capture(uint32_t* frame, uint32_t excReturn, uint32_t fault)
+{
+  uint32_t* regs = &crash.r0;
+
+  // Pump off before anything else: the record is a bonus, the cutoff is not
+  PUMP_OFF_ISR();
+
+  // A stack overflow can leave SP outside RAM: keep the fault registers at least
+  if((uint32_t)frame >= RAM_START && (uint32_t)frame <= RAM_END - FRAME_WORDS * 4U) {
+    for(uint32_t i = 0; i < FRAME_WORDS; i++) {
+      regs[i] = frame[i];
+    }
+    crash.sp = (uint32_t)frame + FRAME_WORDS * 4U + ((frame[7] & XPSR_STACK_ALIGN) ? 4U : 0U);
+  } else {
+    for(uint32_t i = 0; i < FRAME_WORDS; i++) {
+      regs[i] = 0;
+    }
+    crash.sp = (uint32_t)frame;
+  }
+
+  crash.magic = CRASH_MAGIC;
+  crash.excReturn = excReturn;
+  crash.cfsr = SCB->CFSR;
+  crash.hfsr = SCB->HFSR;
+  crash.bfar = SCB->BFAR;
+  crash.mmfar = SCB->MMFAR;
+  crash.tick = HAL_GetTick();
+  crash.fault = (uint8_t)fault;
+  crash.state = (uint8_t)StateMachine_GetState();
+  crash.eventCount = LatencyTrace_GetRecentEvents(crash.events, CRASH_TRACE_EVENTS);
+  crash.sequence = 0;                     // Assigned when persisted
+  crash.check = Checksum(&crash);
+
+  __DSB();
+  NVIC_SystemReset();
+}
+
+/**
+  * @brief  Fault entry points: pick the active stack, move MSP to the fault
+  *         stack and hand over to C
+  * @note   Naked so nothing is pushed before the frame pointer is taken.
+  *         Capture never returns, so the old MSP is not kept.
+  */
+#define CRASH_HANDLER(name, id)                               \
+  __attribute__((naked)) void name(void)                      \
+  {                                                           \
+    __asm volatile(                                           \
+      "tst   lr, #4            \n"                            \
+      "ite   eq                \n"                            \
+      "mrseq r0, msp           \n"                            \
+      "mrsne r0, psp           \n"                            \
+      "mov   r1, lr            \n"                            \
+      "movs  r2, %0            \n"                            \
+      "ldr   r3, =%c1          \n"                            \
+      "mov   sp, r3            \n"                            \
+      "b     CrashDump_Capture \n"                            \
+      : : "i" (id), "i" (&faultStack[FAULT_STACK_WORDS]));    \
+  }
+
+CRASH_HANDLER(HardFault_Handler,  CRASH_FAULT_HARD)
+CRASH_HANDLER(MemManage_Handler,  CRASH_FAULT_MEMMANAGE)
+CRASH_HANDLER(BusFault_Handler,   CRASH_FAULT_BUS)
+CRASH_HANDLER(UsageFault_Handler, CRASH_FAULT_USAGE)
+
+#else
+
+// Stubs if disabled - faults halt as the CubeMX handlers did (IWDG resets)
+void CrashDump_Init(void) {}
+const CrashRecord_t* CrashDump_GetLast(void) { return NULL; }
+uint8_t CrashDump_IsNew(void) { return 0; }
+void CrashDump_Capture(uint32_t* frame, uint32_t excReturn, uint32_t fault) { while(1) { } }
+void HardFault_Handler(void) { while(1) { } }
+void MemManage_Handler(void) { while(1) { } }
+void BusFault_Handler(void) { while(1) { } }
+void UsageFault_Handler(void) { while(1) { } }
+
+#endif // ENABLE_CRASH_DUMP
+
+/**
+  * @brief  Fault name (for reports)
+  * @param  fault Fault handler id
+  * @retval const char* Name string
+  */
+const char* CrashDump_GetFaultName(CrashFault_t fault)
+{
+  return (fault < CRASH_FAULT_COUNT) ? faultNames[fault] : "unknown";
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+#if ENABLE_CRASH_DUMP
+
+/**
+  * @brief  Additive checksum over every word but the checksum
+  */
+static uint32_t Checksum(const CrashRecord_t* rec)
+{
+  const uint32_t* w = (const uint32_t*)rec;
+  uint32_t sum = 0x5A5A5A5AU;
+
+  for(uint32_t i = 0; i < RECORD_WORDS - 1U; i++) {
+    sum += w[i] ^ (i + 1U);             // Position-dependent, so swapped words fail
+  }
+  return sum;
+}
+
+/**
+  * @brief  Magic and checksum both match
+  */
+static uint8_t RecordValid(const CrashRecord_t* rec)
+{
+  return (rec->magic == CRASH_MAGIC && rec->check == Checksum(rec));
+}
+
+/**
+  * @brief  Whether every word of a slot reads erased
+  */
+static uint8_t SlotErased(uint32_t n)
+{
+  const uint32_t* w = (const uint32_t*)CRASH_SLOT(n);
+
+  for(uint32_t i = 0; i < RECORD_WORDS; i++) {
+    if(w[i] != 0xFFFFFFFFU) return 0;
+  }
+  return 1;
+}
+
+/**
+  * @brief  Load the newest stored record
+  * @retval First free slot after the last used one (CRASH_SLOTS if full)
+  */
+static uint32_t ScanPage(void)
+{
+  uint32_t nextSlot = 0;
+
+  for(uint32_t n = 0; n < CRASH_SLOTS; n++) {
+    if(SlotErased(n)) continue;
+    nextSlot = n + 1U;
+    // A slot torn by a reset mid-write fails here and is skipped
+    if(RecordValid(CRASH_SLOT(n))) {
+      last = CRASH_SLOT(n);
+    }
+  }
+  return nextSlot;
+}
+
+/**
+  * @brief  Append the record to the crash page, erasing it first when full
+  * @retval Slot the record was written to
+  */
+static const CrashRecord_t* Persist(const CrashRecord_t* rec, uint32_t slot)
+{
+  const uint32_t* w = (const uint32_t*)rec;
+
+  HAL_FLASH_Unlock();
+  if(slot >= CRASH_SLOTS) {
+    FLASH_EraseInitTypeDef eraseInit = {0};
+    uint32_t pageError;
+
+    eraseInit.TypeErase = FLASH_TYPEERASE_PAGES;
+    eraseInit.PageAddress = CRASH_FLASH_ADDR;
+    eraseInit.NbPages = 1;
+    HAL_FLASHEx_Erase(&eraseInit, &pageError);
+    slot = 0;
+  }
+  // Magic is word 0 but goes last, so a reset mid-write leaves the slot unused
+  for(uint32_t i = RECORD_WORDS; i-- > 0U; ) {
+    HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, (uint32_t)CRASH_SLOT(slot) + 4U * i, w[i]);
+  }
+  HAL_FLASH_Lock();
+  return CRASH_SLOT(slot);
+}
+
+#endif // ENABLE_CRASH_DUMP
@@ -0,0 +1,154 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : current_detector.c
+  * @brief          : Fixed-point pump current dry-run / stall detector
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "current_detector.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static uint16_t DryThreshold(const CurrentDetector_t* det);
+static uint16_t StallThreshold(const CurrentDetector_t* det);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Set up a detector with no learned nominal current
+  * @param  det Detector instance
+  * @param  params Tuning
+  * @retval None
+  */
+void CurrentDetector_Init(CurrentDetector_t* det, const CurrentDetectorParams_t* params)
+{
+  det->p = *params;
+  det->nominal_mA = 0;
+  CurrentDetector_Start(det);
+}
+
+/**
+  * @brief  Pump switched on - restart blanking and clear the fault
+  * @param  det Detector instance
+  * @retval None
+  */
+void CurrentDetector_Start(CurrentDetector_t* det)
+{
+  det->avg_q8 = 0;
+  det->runTime_ms = 0;
+  det->dryTime_ms = 0;
+  det->stallTime_ms = 0;
+  det->runSum_mA = 0;
+  det->runBlocks = 0;
+  det->fault = CURRENT_FAULT_NONE;
+}
+
+/**
+  * @brief  Feed one block-averaged current sample
+  * @param  det Detector instance
+  * @param  current_mA Mean current of the block
+  * @param  block_ms Duration of the block
+  * @retval CurrentFault_t Latched verdict
+  */
+CurrentFault_t CurrentDetector_Update(CurrentDetector_t* det, uint16_t current_mA, uint16_t block_ms)
+{
+  uint32_t sample_q8 = (uint32_t)current_mA << 8;
+
+  // Seed with the first block so the average does not ramp up from zero
+  if(det->runTime_ms == 0U) {
+    det->avg_q8 = sample_q8;
+  } else {
+    det->avg_q8 = det->avg_q8 - (det->avg_q8 >> det->p.avgShift) + (sample_q8 >> det->p.avgShift);
+  }
+  det->runTime_ms += block_ms;
+
+  // Inrush, or already decided
+  if(det->runTime_ms <= det->p.blank_ms || det->fault != CURRENT_FAULT_NONE) {
+    return det->fault;
+  }
+
+  det->runSum_mA += current_mA;
+  det->runBlocks++;
+
+  uint16_t avg = CurrentDetector_GetAverage_mA(det);
+
+  if(avg < DryThreshold(det)) {
+    det->dryTime_ms += block_ms;
+  } else {
+    det->dryTime_ms = 0;
+  }
+
+  if(avg > StallThreshold(det)) {
+    det->stallTime_ms += block_ms;
+  } else {
+    det->stallTime_ms = 0;
+  }
+
+  if(det->stallTime_ms >= det->p.stallHold_ms) {
+    det->fault = CURRENT_FAULT_STALL;
+  } else if(det->dryTime_ms >= det->p.dryHold_ms) {
+    det->fault = CURRENT_FAULT_DRY;
+  }
+
+  return det->fault;
+}
+
+/**
+  * @brief  Blend the mean current of the finished run into the nominal
+  * @param  det Detector instance
+  * @retval None
+  * @note   Call only for runs that ended normally (tank full)
+  */
+void CurrentDetector_LearnNominal(CurrentDetector_t* det)
+{
+  if(det->runBlocks == 0U || det->fault != CURRENT_FAULT_NONE) {
+    return;
+  }
+
+  uint32_t mean = det->runSum_mA / det->runBlocks;
+
+  // First good fill sets it, later fills move it by 1/4 (wear, voltage)
+  if(det->nominal_mA == 0U) {
+    det->nominal_mA = (uint16_t)mean;
+  } else {
+    det->nominal_mA = (uint16_t)(((uint32_t)det->nominal_mA * 3U + mean) / 4U);
+  }
+}
+
+/**
+  * @brief  Current moving average
+  * @param  det Detector instance
+  * @retval uint16_t Average in mA
+  */
+uint16_t CurrentDetector_GetAverage_mA(const CurrentDetector_t* det)
+{
+  return (uint16_t)((det->avg_q8 + 128U) >> 8);
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Dry threshold: relative once a nominal is known
+  */
+static uint16_t DryThreshold(const CurrentDetector_t* det)
+{
+  if(det->nominal_mA == 0U) {
+    return det->p.dry_mA;
+  }
+  return (uint16_t)(((uint32_t)det->nominal_mA * det->p.dryPercent) / 100U);
+}
+
+/**
+  * @brief  Stall threshold: relative once a nominal is known
+  */
+static uint16_t StallThreshold(const CurrentDetector_t* det)
+{
+  if(det->nominal_mA == 0U) {
+    return det->p.stall_mA;
+  }
+  uint32_t threshold = ((uint32_t)det->nominal_mA * det->p.stallPercent) / 100U;
+  return (threshold > 0xFFFFU) ? 0xFFFFU : (uint16_t)threshold;
+}
@@ -0,0 +1,275 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : deferred_log.c
+  * @brief          : Lock-free binary log ring and COBS frame encoder
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "deferred_log.h"
+
+/* Private define ------------------------------------------------------------*/
+#define LOG_RING_MASK             (LOG_RING_WORDS - 1U)
+#define LOG_HEADER_VALID          0x80000000UL
+
+_Static_assert((LOG_RING_WORDS & (LOG_RING_WORDS - 1)) == 0, "LOG_RING_WORDS must be a power of two");
+_Static_assert(LOG_RING_WORDS >= LOG_RECORD_MAX_WORDS, "LOG_RING_WORDS must hold the largest record");
+
+/* Private macro -------------------------------------------------------------*/
+#define LOG_NARGS_OF(header)      (((header) >> 16) & 0xFU)
+
+/* Private variables ---------------------------------------------------------*/
+static DeferredLogStats_t stats;
+
+#if ENABLE_DEFERRED_LOG
+
+// Free-running word indices: head is claimed by producers, tail by the reader.
+// A zero header word marks a slot that is free or still being written.
+static uint32_t ring[LOG_RING_WORDS];
+static volatile uint32_t ringHead;
+static volatile uint32_t ringTail;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Reserve(uint32_t words);
+static void Commit(uint32_t head, uint32_t header, const uint32_t* args, uint32_t nargs);
+static void AtomicAdd(volatile uint32_t* value, uint32_t n);
+static void AtomicMax(volatile uint32_t* value, uint32_t candidate);
+static uint8_t CobsEncode(const uint8_t* in, uint8_t len, uint8_t* out);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Reserve and commit a record without arguments (any context)
+  * @param  header DeferredLog_Header() value
+  * @retval None
+  */
+void DeferredLog_Write0(uint32_t header)
+{
+  uint32_t head = Reserve(2);
+  if(head != UINT32_MAX) {
+    Commit(head, header, 0, 0);
+  }
+}
+
+/**
+  * @brief  Reserve and commit a record with one argument (any context)
+  * @param  header DeferredLog_Header() value
+  * @param  a Argument
+  * @retval None
+  */
+void DeferredLog_Write1(uint32_t header, uint32_t a)
+{
+  uint32_t head = Reserve(3);
+  if(head != UINT32_MAX) {
+    Commit(head, header, &a, 1);
+  }
+}
+
+/**
+  * @brief  Reserve and commit a record with two arguments (any context)
+  * @param  header DeferredLog_Header() value
+  * @param  a, b Arguments
+  * @retval None
+  */
+void DeferredLog_Write2(uint32_t header, uint32_t a, uint32_t b)
+{
+  uint32_t args[2] = { a, b };
+  uint32_t head = Reserve(4);
+  if(head != UINT32_MAX) {
+    Commit(head, header, args, 2);
+  }
+}
+
+/**
+  * @brief  Reserve and commit a record with three arguments (any context)
+  * @param  header DeferredLog_Header() value
+  * @param  a, b, c Arguments
+  * @retval None
+  */
+void DeferredLog_Write3(uint32_t header, uint32_t a, uint32_t b, uint32_t c)
+{
+  uint32_t args[3] = { a, b, c };
+  uint32_t head = Reserve(5);
+  if(head != UINT32_MAX) {
+    Commit(head, header, args, 3);
+  }
+}
+
+/**
+  * @brief  Reserve and commit a record with four arguments (any context)
+  * @param  header DeferredLog_Header() value
+  * @param  a, b, c, d Arguments
+  * @retval None
+  */
+void DeferredLog_Write4(uint32_t header, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+  uint32_t args[4] = { a, b, c, d };
+  uint32_t head = Reserve(6);
+  if(head != UINT32_MAX) {
+    Commit(head, header, args, 4);
+  }
+}
+
+/**
+  * @brief  Take the oldest committed record and encode it as a COBS frame
+  * @param  out Receives up to LOG_FRAME_MAX_BYTES bytes (0x00, COBS data, 0x00)
+  * @retval uint8_t Frame length, 0 if the ring is empty or the oldest record
+  *         is still being written
+  */
+uint8_t DeferredLog_ReadFrame(uint8_t* out)
+{
+  uint8_t raw[4 * LOG_RECORD_MAX_WORDS + 1];
+  uint32_t tail = ringTail;
+  uint32_t header;
+  uint32_t words;
+  uint8_t len = 0;
+  uint8_t check = 0;
+  uint8_t n;
+
+  if(tail == ringHead) {
+    return 0;
+  }
+  header = ring[tail & LOG_RING_MASK];
+  if((header & LOG_HEADER_VALID) == 0U) {
+    return 0;                                       // Reserved, not committed yet
+  }
+  __DMB();                                          // Header seen before the payload is read
+
+  // Little-endian words, then a byte that makes the frame sum to zero
+  words = 2U + LOG_NARGS_OF(header);
+  for(uint32_t i = 0; i < words; i++) {
+    uint32_t* slot = &ring[(tail + i) & LOG_RING_MASK];
+    uint32_t w = *slot;
+    *slot = 0;                                      // Any word may be a future header
+    for(uint8_t b = 0; b < 4U; b++) {
+      raw[len] = (uint8_t)(w >> (8U * b));
+      check = (uint8_t)(check + raw[len]);
+      len++;
+    }
+  }
+  raw[len++] = (uint8_t)(0U - check);
+
+  __DMB();                                          // Slots cleared before they are handed back
+  ringTail = tail + words;
+
+  out[0] = 0x00;
+  n = CobsEncode(raw, len, &out[1]);
+  out[1U + n] = 0x00;
+  return (uint8_t)(n + 2U);
+}
+
+/**
+  * @brief  Get logging statistics
+  * @param  None
+  * @retval const DeferredLogStats_t* Pointer to statistics
+  */
+const DeferredLogStats_t* DeferredLog_GetStats(void)
+{
+  return &stats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Claim words at the head, UINT32_MAX (and a drop) if the ring is full
+  */
+static uint32_t Reserve(uint32_t words)
+{
+  uint32_t head;
+  uint32_t used;
+
+  // An interrupt between LDREX and STREX clears the monitor, so the loser retries
+  do {
+    head = __LDREXW((volatile uint32_t*)&ringHead);
+    used = head - ringTail + words;
+    if(used > LOG_RING_WORDS) {
+      __CLREX();
+      AtomicAdd(&stats.dropped, 1);
+      return UINT32_MAX;
+    }
+  } while(__STREXW(head + words, (volatile uint32_t*)&ringHead) != 0U);
+
+  AtomicMax(&stats.highWater, used);
+  return head;
+}
+
+/**
+  * @brief  Fill a reserved record; the header goes last and publishes it
+  */
+static void Commit(uint32_t head, uint32_t header, const uint32_t* args, uint32_t nargs)
+{
+  ring[(head + 1U) & LOG_RING_MASK] = HAL_GetTick();
+  for(uint32_t i = 0; i < nargs; i++) {
+    ring[(head + 2U + i) & LOG_RING_MASK] = args[i];
+  }
+  __DMB();
+  ring[head & LOG_RING_MASK] = header | LOG_HEADER_VALID;
+  AtomicAdd(&stats.written, 1);
+}
+
+/**
+  * @brief  value += n from any context
+  */
+static void AtomicAdd(volatile uint32_t* value, uint32_t n)
+{
+  uint32_t v;
+
+  do {
+    v = __LDREXW(value);
+  } while(__STREXW(v + n, value) != 0U);
+}
+
+/**
+  * @brief  value = max(value, candidate) from any context
+  */
+static void AtomicMax(volatile uint32_t* value, uint32_t candidate)
+{
+  uint32_t v;
+
+  do {
+    v = __LDREXW(value);
+    if(v >= candidate) {
+      __CLREX();
+      return;
+    }
+  } while(__STREXW(candidate, value) != 0U);
+}
+
+/**
+  * @brief  Consistent Overhead Byte Stuffing: out has no 0x00, len + 1 bytes for len < 254
+  */
+static uint8_t CobsEncode(const uint8_t* in, uint8_t len, uint8_t* out)
+{
+  uint8_t code = 1;
+  uint8_t codeAt = 0;
+  uint8_t n = 1;
+
+  for(uint8_t i = 0; i < len; i++) {
+    if(in[i] == 0x00) {
+      out[codeAt] = code;
+      codeAt = n++;
+      code = 1;
+    } else {
+      out[n++] = in[i];
+      code++;
+    }
+  }
+  out[codeAt] = code;
+  return n;
+}
+
+#else
+
+// Stubs if disabled - LOG_* expand to nothing, these only keep the API linkable
+void DeferredLog_Write0(uint32_t header) {}
+void DeferredLog_Write1(uint32_t header, uint32_t a) {}
+void DeferredLog_Write2(uint32_t header, uint32_t a, uint32_t b) {}
+void DeferredLog_Write3(uint32_t header, uint32_t a, uint32_t b, uint32_t c) {}
+void DeferredLog_Write4(uint32_t header, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {}
+uint8_t DeferredLog_ReadFrame(uint8_t* out) { return 0; }
+const DeferredLogStats_t* DeferredLog_GetStats(void) { return &stats; }
+
+#endif // ENABLE_DEFERRED_LOG
@@ -3,18 +3,21 @@
 
 #define MAX_ERROR_LOG 10
 
+_Static_assert(MAX_ERROR_LOG >= 1 && MAX_ERROR_LOG <= 255, "MAX_ERROR_LOG must fit the uint8_t ring index");
+
 static ErrorLog_t errorLog[MAX_ERROR_LOG];
 static uint8_t errorLogIndex = 0;
 
 /**
   * @brief  Log error to persistent storage (RAM buffer for now)
   */
-void ErrorLog_Add(uint8_t errorCode, SystemState_t state, uint32_t cycles)
+void ErrorLog_Add(uint8_t errorCode, SystemState_t state, uint32_t cycles, uint8_t retries)
 {
   errorLog[errorLogIndex].errorCode = errorCode;
   errorLog[errorLogIndex].timestamp = HAL_GetTick();
   errorLog[errorLogIndex].stateAtError = state;
   errorLog[errorLogIndex].pumpCycleCount = cycles;
+  errorLog[errorLogIndex].retries = retries;
   
   errorLogIndex = (errorLogIndex + 1) % MAX_ERROR_LOG;
   
@@ -0,0 +1,203 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : error_recovery.c
+  * @brief          : Per-error-code automatic retry with exponential backoff
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "error_recovery.h"
+#include "deferred_log.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+_Static_assert(ERROR_LEAK < ERROR_CODE_COUNT, "ERROR_CODE_COUNT must cover every error code");
+_Static_assert(RECOVERY_PUMP_TIMEOUT_RETRIES <= 255 && RECOVERY_RAPID_CYCLING_RETRIES <= 255 &&
+               RECOVERY_GALLON_EMPTY_RETRIES <= 255 && RECOVERY_PUMP_STALL_RETRIES <= 255,
+               "RECOVERY_*_RETRIES must fit in 8 bits");
+
+/* Private variables ---------------------------------------------------------*/
+static ErrorRecoveryStats_t stats;
+
+// Codes without an entry (overflow, sensor fault, stack low, leak) are always
+// latched. They point at hardware that a retry would only stress further.
+static const RecoveryPolicy_t policies[ERROR_CODE_COUNT] = {
+  [ERROR_PUMP_TIMEOUT]  = { RECOVERY_PUMP_TIMEOUT_RETRIES,  RECOVERY_PUMP_TIMEOUT_BACKOFF_MS },
+  [ERROR_RAPID_CYCLING] = { RECOVERY_RAPID_CYCLING_RETRIES, RECOVERY_RAPID_CYCLING_BACKOFF_MS },
+  [ERROR_GALLON_EMPTY]  = { RECOVERY_GALLON_EMPTY_RETRIES,  RECOVERY_GALLON_EMPTY_BACKOFF_MS },
+  [ERROR_PUMP_STALL]    = { RECOVERY_PUMP_STALL_RETRIES,    RECOVERY_PUMP_STALL_BACKOFF_MS },
+};
+
+static const RecoveryPolicy_t latched = { 0, 0 };
+
+#if ENABLE_AUTO_RECOVERY
+
+static uint32_t lastSeen[ERROR_CODE_COUNT];   // HAL tick each code was last latched
+static uint32_t retryAt;                      // HAL tick of the scheduled retry
+static uint8_t awaitingFill;                  // A retry ran, no fill has reached the switch since
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Backoff(const RecoveryPolicy_t* policy, uint8_t used);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Restore every retry budget, nothing scheduled
+  * @param  None
+  * @retval None
+  */
+void ErrorRecovery_Init(void)
+{
+  memset(stats.used, 0, sizeof(stats.used));
+  stats.code = ERROR_NONE;
+  awaitingFill = 0;
+}
+
+/**
+  * @brief  An error was latched: schedule a retry if its policy has one left
+  * @param  errorCode Latched error code
+  * @retval None
+  */
+void ErrorRecovery_ErrorLatched(uint8_t errorCode)
+{
+  uint32_t now = HAL_GetTick();
+  const RecoveryPolicy_t* policy = ErrorRecovery_GetPolicy(errorCode);
+  uint32_t backoff;
+
+  // The retry before this error, if any, did not help
+  stats.code = ERROR_NONE;
+  awaitingFill = 0;
+
+  if(errorCode >= ERROR_CODE_COUNT) {
+    return;
+  }
+
+  // A code that stayed away long enough starts with a full budget again
+  if(stats.used[errorCode] > 0 && (now - lastSeen[errorCode]) >= RECOVERY_FORGET_MS) {
+    stats.used[errorCode] = 0;
+  }
+  lastSeen[errorCode] = now;
+
+  if(stats.used[errorCode] >= policy->maxRetries) {
+    if(policy->maxRetries > 0) {
+      stats.exhausted++;
+      LOG_WARN("error %u stays latched: %u retries used", errorCode, stats.used[errorCode]);
+    }
+    return;
+  }
+
+  backoff = Backoff(policy, stats.used[errorCode]);
+  retryAt = now + backoff;
+  stats.code = errorCode;
+  LOG_INFO("error %u: retry %u of %u in %u s", errorCode, stats.used[errorCode] + 1U,
+           policy->maxRetries, backoff / 1000U);
+}
+
+/**
+  * @brief  Whether the scheduled retry is due (takes the retry)
+  * @param  None
+  * @retval uint8_t 1 to clear the error and try again, 0 to stay in ERROR
+  */
+uint8_t ErrorRecovery_RetryDue(void)
+{
+  uint8_t code = stats.code;
+
+  if(code == ERROR_NONE || (int32_t)(HAL_GetTick() - retryAt) < 0) {
+    return 0;
+  }
+
+  stats.code = ERROR_NONE;
+  stats.used[code]++;
+  stats.retries++;
+  awaitingFill = 1;
+  LOG_WARN("error %u cleared automatically, retry %u", code, stats.used[code]);
+  return 1;
+}
+
+/**
+  * @brief  A fill reached the level switch (counts a successful retry)
+  * @param  None
+  * @retval None
+  */
+void ErrorRecovery_FillComplete(void)
+{
+  if(awaitingFill) {
+    awaitingFill = 0;
+    stats.recovered++;
+  }
+}
+
+/**
+  * @brief  The error was reset at the door: restore every retry budget
+  * @param  None
+  * @retval None
+  */
+void ErrorRecovery_ManualReset(void)
+{
+  ErrorRecovery_Init();
+}
+
+/**
+  * @brief  Retries used for an error code
+  * @param  errorCode Error code
+  * @retval uint8_t Retries used within RECOVERY_FORGET_MS
+  */
+uint8_t ErrorRecovery_GetRetries(uint8_t errorCode)
+{
+  return (errorCode < ERROR_CODE_COUNT) ? stats.used[errorCode] : 0;
+}
+
+/**
+  * @brief  Recovery policy of an error code
+  * @param  errorCode Error code
+  * @retval const RecoveryPolicy_t* Policy (never NULL, unknown codes are latched)
+  */
+const RecoveryPolicy_t* ErrorRecovery_GetPolicy(uint8_t errorCode)
+{
+  return (errorCode < ERROR_CODE_COUNT) ? &policies[errorCode] : &latched;
+}
+
+/**
+  * @brief  Get error recovery statistics (refreshes the time to the next retry)
+  * @param  None
+  * @retval const ErrorRecoveryStats_t* Pointer to statistics
+  */
+const ErrorRecoveryStats_t* ErrorRecovery_GetStats(void)
+{
+  int32_t left = (int32_t)(retryAt - HAL_GetTick());
+
+  stats.retryIn_ms = (stats.code != ERROR_NONE && left > 0) ? (uint32_t)left : 0;
+  return &stats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  First backoff doubled once per retry used, capped at RECOVERY_BACKOFF_MAX_MS
+  */
+static uint32_t Backoff(const RecoveryPolicy_t* policy, uint8_t used)
+{
+  uint32_t backoff = policy->firstBackoff_ms;
+
+  while(used-- > 0 && backoff < RECOVERY_BACKOFF_MAX_MS) {
+    backoff *= 2U;
+  }
+  return (backoff > RECOVERY_BACKOFF_MAX_MS) ? RECOVERY_BACKOFF_MAX_MS : backoff;
+}
+
+#else
+
+// Stubs if disabled - every error stays latched until the door reset
+void ErrorRecovery_Init(void) {}
+void ErrorRecovery_ErrorLatched(uint8_t errorCode) {}
+uint8_t ErrorRecovery_RetryDue(void) { return 0; }
+void ErrorRecovery_FillComplete(void) {}
+void ErrorRecovery_ManualReset(void) {}
+uint8_t ErrorRecovery_GetRetries(uint8_t errorCode) { return 0; }
+const RecoveryPolicy_t* ErrorRecovery_GetPolicy(uint8_t errorCode) { return &latched; }
+const ErrorRecoveryStats_t* ErrorRecovery_GetStats(void) { return &stats; }
+
+#endif // ENABLE_AUTO_RECOVERY
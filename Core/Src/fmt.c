@@ -0,0 +1,291 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : fmt.c
+  * @brief          : Allocation-free integer formatting and JSON line builder
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "fmt.h"
+
+/* Private variables ---------------------------------------------------------*/
+static const char hexDigits[16] = {
+  '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void Append(FmtJson_t* json, const char* text, uint16_t n);
+static void AppendKey(FmtJson_t* json, const char* key);
+static uint16_t StrLen(const char* s);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Unsigned decimal
+  * @param  out Receives up to FMT_U32_MAX_LEN characters
+  * @param  value Value
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_U32(char* out, uint32_t value)
+{
+  char tmp[FMT_U32_MAX_LEN];
+  uint8_t n = 0;
+
+  // Least significant digit first; /10 becomes a multiply-high on Cortex-M3
+  do {
+    uint32_t q = value / 10U;
+    tmp[n++] = (char)('0' + (value - q * 10U));
+    value = q;
+  } while(value != 0U);
+
+  for(uint8_t i = 0; i < n; i++) {
+    out[i] = tmp[n - 1U - i];
+  }
+  return n;
+}
+
+/**
+  * @brief  Signed decimal
+  * @param  out Receives up to FMT_I32_MAX_LEN characters
+  * @param  value Value
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_I32(char* out, int32_t value)
+{
+  if(value < 0) {
+    out[0] = '-';
+    return (uint8_t)(1U + Fmt_U32(out + 1, 0U - (uint32_t)value));   // INT32_MIN safe
+  }
+  return Fmt_U32(out, (uint32_t)value);
+}
+
+/**
+  * @brief  Hex with 0x prefix and 8 lower-case digits (as "0x%08lx")
+  * @param  out Receives FMT_HEX32_LEN characters
+  * @param  value Value
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_Hex32(char* out, uint32_t value)
+{
+  out[0] = '0';
+  out[1] = 'x';
+  for(uint8_t i = 0; i < 8U; i++) {
+    out[2U + i] = hexDigits[(value >> (28U - 4U * i)) & 0xFU];
+  }
+  return FMT_HEX32_LEN;
+}
+
+/**
+  * @brief  Fixed-point decimal: 3712 with 3 decimals is "3.712" (mV -> V, mL -> L)
+  * @param  out Receives up to FMT_I32_MAX_LEN + 2 characters
+  * @param  value Value in units of 10^-decimals
+  * @param  decimals Digits after the point (0-9)
+  * @retval uint8_t Characters written
+  */
+uint8_t Fmt_Fixed(char* out, int32_t value, uint8_t decimals)
+{
+  char digits[FMT_U32_MAX_LEN];
+  uint32_t magnitude = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+  uint8_t n = 0;
+  uint8_t len;
+
+  if(decimals == 0U) {
+    return Fmt_I32(out, value);
+  }
+  if(decimals > 9U) {
+    decimals = 9U;
+  }
+
+  if(value < 0) {
+    out[n++] = '-';
+  }
+  len = Fmt_U32(digits, magnitude);
+
+  // Integer part, "0" if the value is below one unit: 5 -> "0.005"
+  if(len > decimals) {
+    for(uint8_t i = 0; i < len - decimals; i++) {
+      out[n++] = digits[i];
+    }
+  } else {
+    out[n++] = '0';
+  }
+  out[n++] = '.';
+
+  // Fraction, zero-padded on the left
+  for(uint8_t i = decimals; i > 0U; i--) {
+    out[n++] = (i > len) ? '0' : digits[len - i];
+  }
+  return n;
+}
+
+/**
+  * @brief  Start a JSON line ("{")
+  * @param  json Builder
+  * @param  buf Output buffer
+  * @param  cap Buffer size including the terminator
+  * @retval None
+  */
+void Fmt_JsonBegin(FmtJson_t* json, char* buf, uint16_t cap)
+{
+  json->buf = buf;
+  json->cap = cap;
+  json->len = 0;
+  json->fields = 0;
+  json->overflow = 0;
+  Append(json, "{", 1);
+}
+
+/**
+  * @brief  Append "key":"value"
+  * @param  json Builder
+  * @param  key Key (not escaped)
+  * @param  value String value (not escaped)
+  * @retval None
+  */
+void Fmt_JsonStr(FmtJson_t* json, const char* key, const char* value)
+{
+  AppendKey(json, key);
+  Append(json, "\"", 1);
+  Append(json, value, StrLen(value));
+  Append(json, "\"", 1);
+}
+
+/**
+  * @brief  Append "key":value (unsigned)
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value
+  * @retval None
+  */
+void Fmt_JsonU32(FmtJson_t* json, const char* key, uint32_t value)
+{
+  AppendKey(json, key);
+  // Format in place when the widest value fits, no copy
+  if(!json->overflow && (uint32_t)json->len + FMT_U32_MAX_LEN < json->cap) {
+    json->len = (uint16_t)(json->len + Fmt_U32(json->buf + json->len, value));
+  } else {
+    char tmp[FMT_U32_MAX_LEN];
+    Append(json, tmp, Fmt_U32(tmp, value));
+  }
+}
+
+/**
+  * @brief  Append "key":value (signed)
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value
+  * @retval None
+  */
+void Fmt_JsonI32(FmtJson_t* json, const char* key, int32_t value)
+{
+  char tmp[FMT_I32_MAX_LEN];
+
+  AppendKey(json, key);
+  Append(json, tmp, Fmt_I32(tmp, value));
+}
+
+/**
+  * @brief  Append "key":"0x........"
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value
+  * @retval None
+  */
+void Fmt_JsonHex32(FmtJson_t* json, const char* key, uint32_t value)
+{
+  char tmp[FMT_HEX32_LEN];
+
+  AppendKey(json, key);
+  Append(json, "\"", 1);
+  Append(json, tmp, Fmt_Hex32(tmp, value));
+  Append(json, "\"", 1);
+}
+
+/**
+  * @brief  Append "key":value as a fixed-point decimal
+  * @param  json Builder
+  * @param  key Key
+  * @param  value Value in units of 10^-decimals
+  * @param  decimals Digits after the point
+  * @retval None
+  */
+void Fmt_JsonFixed(FmtJson_t* json, const char* key, int32_t value, uint8_t decimals)
+{
+  char tmp[FMT_I32_MAX_LEN + 2];
+
+  AppendKey(json, key);
+  Append(json, tmp, Fmt_Fixed(tmp, value, decimals));
+}
+
+/**
+  * @brief  Close the line with "}\r\n" and terminate it
+  * @param  json Builder
+  * @retval uint16_t Line length, 0 if anything did not fit
+  */
+uint16_t Fmt_JsonEnd(FmtJson_t* json)
+{
+  Append(json, "}\r\n", 3);
+  if(json->overflow) {
+    return 0;
+  }
+  json->buf[json->len] = '\0';
+  return json->len;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Copy n characters if they fit with room for the terminator
+  */
+static void Append(FmtJson_t* json, const char* text, uint16_t n)
+{
+  if(json->overflow || (uint32_t)json->len + n >= json->cap) {
+    json->overflow = 1;
+    return;
+  }
+  for(uint16_t i = 0; i < n; i++) {
+    json->buf[json->len++] = text[i];
+  }
+}
+
+/**
+  * @brief  Separator and "key": in one bounds check
+  */
+static void AppendKey(FmtJson_t* json, const char* key)
+{
+  uint16_t keyLen = StrLen(key);
+  uint16_t sep = (json->fields++ != 0U) ? 1U : 0U;
+  char* out;
+
+  if(json->overflow || (uint32_t)json->len + sep + keyLen + 3U >= json->cap) {
+    json->overflow = 1;
+    return;
+  }
+  out = json->buf + json->len;
+  if(sep) {
+    *out++ = ',';
+  }
+  *out++ = '"';
+  for(uint16_t i = 0; i < keyLen; i++) {
+    *out++ = key[i];
+  }
+  *out++ = '"';
+  *out++ = ':';
+  json->len = (uint16_t)(out - json->buf);
+}
+
+/**
+  * @brief  strlen without pulling in libc
+  */
+static uint16_t StrLen(const char* s)
+{
+  uint16_t n = 0;
+
+  while(s[n] != '\0') {
+    n++;
+  }
+  return n;
+}
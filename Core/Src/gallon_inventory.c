@@ -0,0 +1,173 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : gallon_inventory.c
+  * @brief          : Gallon volume estimator with swap detection
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "gallon_inventory.h"
+
+/* Private define ------------------------------------------------------------*/
+#define CAPACITY_MIN_ML     (GALLON_CAPACITY_ML / 2)
+#define CAPACITY_MAX_ML     ((GALLON_CAPACITY_ML * 3) / 2)
+
+/* Private variables ---------------------------------------------------------*/
+static GallonStatus_t gallon;
+
+#if ENABLE_GALLON_ESTIMATOR
+
+static uint32_t lastCycle_ml = 0;   // Volume of the most recent cycle
+
+/* Private function prototypes -----------------------------------------------*/
+static void StartNewGallon(uint32_t alreadyPumped_ml);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Reset to "unknown" with the configured capacity
+  * @param  None
+  * @retval None
+  */
+void Gallon_Init(void)
+{
+  gallon.known = 0;
+  gallon.swapPending = 0;
+  gallon.capacity_ml = GALLON_CAPACITY_ML;
+  gallon.pumpedSinceSwap_ml = 0;
+  gallon.remaining_ml = GALLON_CAPACITY_ML;
+  gallon.swapCount = 0;
+  gallon.earlyCutCount = 0;
+}
+
+/**
+  * @brief  Report a finished door-open episode
+  * @param  openDuration_ms How long the door was open
+  * @retval None
+  */
+void Gallon_DoorEpisode(uint32_t openDuration_ms)
+{
+  // Lifting a 19 L jug out and a new one in takes longer than a glance inside
+  if(openDuration_ms >= GALLON_SWAP_MIN_OPEN_MS) {
+    gallon.swapPending = 1;
+  }
+}
+
+/**
+  * @brief  Account a finished pump cycle
+  * @param  volume_ml Volume the cycle delivered
+  * @param  outcome How the cycle ended
+  * @retval None
+  */
+void Gallon_RecordCycle(uint32_t volume_ml, PumpCycleOutcome_t outcome)
+{
+  lastCycle_ml = volume_ml;
+
+  if(outcome == PUMP_CYCLE_FULL &&
+     (gallon.swapPending || (gallon.known && gallon.remaining_ml <= 0))) {
+    // Level came up after a long door-open: new gallon. A full fill while the
+    // estimate says empty also proves water - a swap that was missed.
+    if(gallon.swapPending) gallon.swapCount++;
+    StartNewGallon(lastCycle_ml);
+    return;
+  }
+
+  if(outcome == PUMP_CYCLE_ERROR) {
+    gallon.swapPending = 0;     // No level change - it was not a swap
+  }
+
+  gallon.pumpedSinceSwap_ml += lastCycle_ml;
+  gallon.remaining_ml = (int32_t)gallon.capacity_ml - (int32_t)gallon.pumpedSinceSwap_ml;
+}
+
+/**
+  * @brief  Gallon ran dry (ERROR_GALLON_EMPTY), learn from it
+  * @param  cutByEstimate 1 if Gallon_IsExhausted() stopped the fill
+  * @retval None
+  */
+void Gallon_MarkEmpty(uint8_t cutByEstimate)
+{
+  if(cutByEstimate) {
+    gallon.earlyCutCount++;
+  } else if(gallon.known) {
+    // Ran dry somewhere in the last fill: what came before it is a lower
+    // bound of the real volume. Blend it in slowly.
+    uint32_t delivered = gallon.pumpedSinceSwap_ml - lastCycle_ml;
+    uint32_t learned = ((gallon.capacity_ml * 3U) + delivered) / 4U;
+
+    if(learned < CAPACITY_MIN_ML) learned = CAPACITY_MIN_ML;
+    if(learned > CAPACITY_MAX_ML) learned = CAPACITY_MAX_ML;
+    gallon.capacity_ml = learned;
+  }
+
+  // Empty is a known level even before the first swap was seen
+  gallon.known = 1;
+  gallon.swapPending = 0;
+  gallon.pumpedSinceSwap_ml = gallon.capacity_ml;
+  gallon.remaining_ml = 0;
+}
+
+/**
+  * @brief  Whether the running fill has pumped past what the gallon can hold
+  * @param  runtime_ms Pump on time of the running fill
+  * @param  volume_ml Volume the running fill delivered so far
+  * @retval uint8_t 1 if the fill should be stopped as a dry run
+  */
+uint8_t Gallon_IsExhausted(uint32_t runtime_ms, uint32_t volume_ml)
+{
+  if(!gallon.known || runtime_ms < GALLON_DRY_RUN_MIN_MS) {
+    return 0;
+  }
+
+  int32_t left = gallon.remaining_ml - (int32_t)volume_ml;
+  return (left < -(int32_t)GALLON_ESTIMATE_MARGIN_ML);
+}
+
+/**
+  * @brief  Whether the gallon is running low (early warning)
+  * @param  None
+  * @retval uint8_t 1 if below GALLON_LOW_WARNING_ML
+  */
+uint8_t Gallon_IsLow(void)
+{
+  return gallon.known && (gallon.remaining_ml < (int32_t)GALLON_LOW_WARNING_ML);
+}
+
+/**
+  * @brief  Get inventory status
+  * @param  None
+  * @retval const GallonStatus_t* Pointer to status
+  */
+const GallonStatus_t* Gallon_GetStatus(void)
+{
+  return &gallon;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Restart integration for a fresh gallon
+  */
+static void StartNewGallon(uint32_t alreadyPumped_ml)
+{
+  gallon.known = 1;
+  gallon.swapPending = 0;
+  gallon.pumpedSinceSwap_ml = alreadyPumped_ml;
+  gallon.remaining_ml = (int32_t)gallon.capacity_ml - (int32_t)alreadyPumped_ml;
+}
+
+#else
+
+// Stubs if disabled
+void Gallon_Init(void) {}
+void Gallon_DoorEpisode(uint32_t openDuration_ms) {}
+void Gallon_RecordCycle(uint32_t volume_ml, PumpCycleOutcome_t outcome) {}
+void Gallon_MarkEmpty(uint8_t cutByEstimate) {}
+uint8_t Gallon_IsExhausted(uint32_t runtime_ms, uint32_t volume_ml) { return 0; }
+uint8_t Gallon_IsLow(void) { return 0; }
+const GallonStatus_t* Gallon_GetStatus(void) { return &gallon; }
+
+#endif // ENABLE_GALLON_ESTIMATOR
@@ -22,6 +22,7 @@
 #include "gpio.h"
 
 /* USER CODE BEGIN 0 */
+#include "config.h"
 
 /* USER CODE END 0 */
 
@@ -69,7 +70,7 @@ void MX_GPIO_Init(void)
 
   /*Configure GPIO pins : DOOR_SW_Pin WATER_LIMIT_Pin OVERFLOW_SENSOR_Pin */
   GPIO_InitStruct.Pin = DOOR_SW_Pin|WATER_LIMIT_Pin|OVERFLOW_SENSOR_Pin;
-  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_NOPULL;
   HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
 
@@ -110,4 +111,34 @@ void MX_GPIO_Init(void)
 
 /* USER CODE BEGIN 2 */
 
+/**
+  * @brief  Give the overflow input (PA2) a defined level, or park it when not fitted
+  * @note   Call right after MX_GPIO_Init(). The generated code leaves PA2 a
+  *         floating both-edge EXTI input at priority 0. Without a sensor it
+  *         would storm the highest-priority IRQ and keep the unit out of STOP.
+  * @param  None
+  * @retval None
+  */
+void GPIO_OverflowInput_Init(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  GPIO_InitStruct.Pin = OVERFLOW_SENSOR_Pin;
+
+  #if ENABLE_OVERFLOW_SENSOR
+  // Pull towards the idle level so a broken wire reads "no overflow"
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
+  GPIO_InitStruct.Pull = OVERFLOW_SENSOR_PULL;
+  HAL_GPIO_Init(OVERFLOW_SENSOR_GPIO_Port, &GPIO_InitStruct);
+  #else
+  // Not fitted: EXTI2 masked, pin analog like the other unused pins
+  HAL_NVIC_DisableIRQ(EXTI2_IRQn);
+  HAL_GPIO_DeInit(OVERFLOW_SENSOR_GPIO_Port, OVERFLOW_SENSOR_Pin);
+  GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+  HAL_GPIO_Init(OVERFLOW_SENSOR_GPIO_Port, &GPIO_InitStruct);
+  __HAL_GPIO_EXTI_CLEAR_IT(OVERFLOW_SENSOR_Pin);
+  HAL_NVIC_ClearPendingIRQ(EXTI2_IRQn);
+  #endif
+}
+
 /* USER CODE END 2 */
@@ -0,0 +1,285 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : latency_trace.c
+  * @brief          : Sensor edge to actuator latency tracing
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "latency_trace.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  uint32_t timestamp;           // Edge timestamp
+  uint16_t correlationId;       // ID handed out for the edge
+  uint8_t  valid;               // 1 while waiting for the actuator
+} PendingEdge_t;
+
+typedef struct {
+  uint16_t bucket[LATENCY_HIST_BUCKETS];
+  uint32_t count;
+  uint32_t max_us;
+} LatencyHistogram_t;
+
+/* Private define ------------------------------------------------------------*/
+_Static_assert((LATENCY_TRACE_EVENTS & (LATENCY_TRACE_EVENTS - 1)) == 0 && LATENCY_TRACE_EVENTS <= 128,
+               "LATENCY_TRACE_EVENTS must be a power of two that fits the uint8_t ring index");
+
+/* Private macro -------------------------------------------------------------*/
+#define ENTER_CRITICAL()  uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define EXIT_CRITICAL()   __set_PRIMASK(primask)
+
+/* Private variables ---------------------------------------------------------*/
+static PendingEdge_t pending[LATENCY_PATH_COUNT];
+static LatencyHistogram_t histogram[LATENCY_PATH_COUNT];
+static TraceEvent_t events[LATENCY_TRACE_EVENTS];
+static uint8_t eventHead = 0;
+static uint8_t eventCount = 0;
+static uint16_t nextCorrelationId = 1;
+static uint16_t lastCompletedId = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static void PushEvent(uint32_t timestamp, uint16_t id, uint8_t type, uint8_t arg);
+static uint8_t BucketIndex(uint32_t us);
+static uint32_t BucketUpperBound(uint8_t index);
+static void HistogramAdd(LatencyHistogram_t* h, uint32_t us);
+static uint32_t HistogramPercentile(const LatencyHistogram_t* h, uint8_t percent);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Clear histograms, pending edges and event ring
+  * @param  None
+  * @retval None
+  */
+void LatencyTrace_Init(void)
+{
+  for(int p = 0; p < LATENCY_PATH_COUNT; p++) {
+    pending[p].valid = 0;
+    for(int b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+      histogram[p].bucket[b] = 0;
+    }
+    histogram[p].count = 0;
+    histogram[p].max_us = 0;
+  }
+  eventHead = 0;
+  eventCount = 0;
+  lastCompletedId = 0;
+}
+
+/**
+  * @brief  Timestamp a sensor edge
+  * @param  path Path the edge starts
+  * @param  timestamp LATENCY_TRACE_NOW() value of the edge
+  * @retval uint16_t Correlation ID assigned (0 if an edge was already pending)
+  */
+uint16_t LatencyTrace_MarkEdge(LatencyPath_t path, uint32_t timestamp)
+{
+  uint16_t id = 0;
+
+  ENTER_CRITICAL();
+  PendingEdge_t* edge = &pending[path];
+
+  // Keep the oldest edge unless it was never resolved (pump already off)
+  if(!edge->valid ||
+     LATENCY_TRACE_TO_US(timestamp - edge->timestamp) > LATENCY_TRACE_STALE_US) {
+    id = nextCorrelationId++;
+    if(nextCorrelationId == 0) nextCorrelationId = 1;
+
+    edge->timestamp = timestamp;
+    edge->correlationId = id;
+    edge->valid = 1;
+    PushEvent(timestamp, id, TRACE_EVENT_EDGE, (uint8_t)path);
+  }
+  EXIT_CRITICAL();
+
+  return id;
+}
+
+/**
+  * @brief  Close the pending edge of a path at the pump-off it caused
+  * @param  path Path being completed
+  * @retval uint16_t Correlation ID completed (0 if nothing was pending)
+  */
+uint16_t LatencyTrace_MarkActuator(LatencyPath_t path)
+{
+  uint32_t now = LATENCY_TRACE_NOW();
+  uint16_t id = 0;
+
+  ENTER_CRITICAL();
+  PendingEdge_t* edge = &pending[path];
+
+  if(edge->valid) {
+    id = edge->correlationId;
+    edge->valid = 0;
+    lastCompletedId = id;
+    HistogramAdd(&histogram[path], LATENCY_TRACE_TO_US(now - edge->timestamp));
+    PushEvent(now, id, TRACE_EVENT_ACTUATE, (uint8_t)path);
+  }
+  EXIT_CRITICAL();
+
+  return id;
+}
+
+/**
+  * @brief  Record a state change attributed to the last completed edge
+  * @param  newState State entered
+  * @retval None
+  */
+void LatencyTrace_MarkState(uint8_t newState)
+{
+  uint32_t now = LATENCY_TRACE_NOW();
+
+  ENTER_CRITICAL();
+  PushEvent(now, lastCompletedId, TRACE_EVENT_STATE, newState);
+  lastCompletedId = 0;
+  EXIT_CRITICAL();
+}
+
+/**
+  * @brief  Get p50/p99/max summary for a path
+  * @param  path Path to summarize
+  * @param  summary Output
+  * @retval None
+  */
+void LatencyTrace_GetSummary(LatencyPath_t path, LatencySummary_t* summary)
+{
+  LatencyHistogram_t snapshot;
+
+  ENTER_CRITICAL();
+  snapshot = histogram[path];
+  EXIT_CRITICAL();
+
+  summary->count = snapshot.count;
+  summary->max_us = snapshot.max_us;
+  summary->p50_us = HistogramPercentile(&snapshot, 50);
+  summary->p99_us = HistogramPercentile(&snapshot, 99);
+}
+
+/**
+  * @brief  Copy the most recent trace events, newest last
+  * @param  out Output array
+  * @param  maxEvents Capacity of out
+  * @retval uint8_t Number of events copied
+  */
+uint8_t LatencyTrace_GetRecentEvents(TraceEvent_t* out, uint8_t maxEvents)
+{
+  uint8_t n;
+
+  ENTER_CRITICAL();
+  n = (eventCount < maxEvents) ? eventCount : maxEvents;
+  uint8_t start = (uint8_t)(eventHead - n) & (LATENCY_TRACE_EVENTS - 1);
+  for(uint8_t i = 0; i < n; i++) {
+    out[i] = events[(start + i) & (LATENCY_TRACE_EVENTS - 1)];
+  }
+  EXIT_CRITICAL();
+
+  return n;
+}
+
+/**
+  * @brief  Get short path name
+  * @param  path Path
+  * @retval const char* Name string
+  */
+const char* LatencyTrace_GetPathName(LatencyPath_t path)
+{
+  switch(path)
+  {
+    case LATENCY_PATH_DOOR_OPEN: return "door";
+    case LATENCY_PATH_TANK_FULL: return "full";
+    case LATENCY_PATH_OVERFLOW:  return "ovf";
+    default:                     return "?";
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Append an event to the ring (caller holds the critical section)
+  */
+static void PushEvent(uint32_t timestamp, uint16_t id, uint8_t type, uint8_t arg)
+{
+  TraceEvent_t* e = &events[eventHead];
+
+  e->timestamp = timestamp;
+  e->correlationId = id;
+  e->type = type;
+  e->arg = arg;
+
+  eventHead = (eventHead + 1) & (LATENCY_TRACE_EVENTS - 1);
+  if(eventCount < LATENCY_TRACE_EVENTS) eventCount++;
+}
+
+/**
+  * @brief  Map a latency to its bucket: 2 buckets per power of two
+  */
+static uint8_t BucketIndex(uint32_t us)
+{
+  if(us < 2) return 0;
+
+  uint8_t msb = 31 - __builtin_clz(us);
+  uint8_t index = (msb * 2) + ((us >> (msb - 1)) & 1);
+
+  return (index < LATENCY_HIST_BUCKETS) ? index : (LATENCY_HIST_BUCKETS - 1);
+}
+
+/**
+  * @brief  Largest latency that falls into a bucket
+  */
+static uint32_t BucketUpperBound(uint8_t index)
+{
+  uint8_t msb = index / 2;
+
+  if(msb == 0) return 1;
+  if(index & 1) return (2UL << msb) - 1;
+  return (1UL << msb) + (1UL << (msb - 1)) - 1;
+}
+
+/**
+  * @brief  Add a sample, halving all buckets when one would saturate
+  */
+static void HistogramAdd(LatencyHistogram_t* h, uint32_t us)
+{
+  uint8_t index = BucketIndex(us);
+
+  if(h->bucket[index] == 0xFFFF) {
+    for(int b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+      h->bucket[b] >>= 1;
+    }
+  }
+  h->bucket[index]++;
+  h->count++;
+
+  if(us > h->max_us) {
+    h->max_us = us;
+  }
+}
+
+/**
+  * @brief  Percentile estimate (bucket upper bound, capped at exact max)
+  */
+static uint32_t HistogramPercentile(const LatencyHistogram_t* h, uint8_t percent)
+{
+  uint32_t total = 0;
+  for(int b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+    total += h->bucket[b];
+  }
+  if(total == 0) return 0;
+
+  uint32_t target = (total * percent + 99) / 100;
+  uint32_t cumulative = 0;
+
+  for(uint8_t b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+    cumulative += h->bucket[b];
+    if(cumulative >= target) {
+      uint32_t bound = BucketUpperBound(b);
+      return (bound < h->max_us) ? bound : h->max_us;
+    }
+  }
+
+  return h->max_us;
+}
@@ -0,0 +1,285 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : leak_detect.c
+  * @brief          : Idle leak detection from unexplained drains in quiet hours
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "leak_detect.h"
+#include "deferred_log.h"
+#include <string.h>
+
+/* Private define ------------------------------------------------------------*/
+#define MS_PER_MINUTE             60000UL
+#define MS_PER_HOUR               3600000UL
+#define HOUR_SLOTS                24U
+#define INTERVAL_BINS             12U     // log2 minutes: bin k holds 2^(k-1)..2^k-1, the top bin 17 h and up
+#define BASELINE_HALVE_AT         240U    // Halve the bins here, older drains fade and counts fit 8 bits
+#define SLOT_MAX                  255U
+
+/* Private variables ---------------------------------------------------------*/
+static LeakDetectStats_t stats;
+
+#if ENABLE_LEAK_DETECT
+
+static uint8_t activity[HOUR_SLOTS];        // Drains per hour x16, averaged over days
+static uint8_t bins[INTERVAL_BINS];         // Baseline: idle drain intervals in quiet slots
+static uint16_t binTotal;
+static uint8_t held[LEAK_CONFIRM_DRAINS];   // Bins of the suspicious drains in the streak
+static uint8_t hourDrains;                  // Drains counted in the running hour
+static uint16_t hoursSeen;                  // Capped at LEAK_LEARN_HOURS
+static uint32_t hourStart;
+static uint32_t fillEnd;                    // HAL tick the last fill reached the switch
+static uint8_t idle;                        // A fill ended at the switch, no door activity since
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t IsQuiet(uint8_t slot);
+static uint8_t Bin(uint32_t minutes);
+static uint16_t Percentile(uint8_t bin);
+static void Learn(uint8_t bin);
+static void EndStreak(uint8_t learn);
+static void CountDrain(void);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Empty profile and baseline, learning from now
+  * @param  None
+  * @retval None
+  */
+void LeakDetect_Init(void)
+{
+  memset(activity, 0, sizeof(activity));
+  memset(bins, 0, sizeof(bins));
+  binTotal = 0;
+  hourDrains = 0;
+  hoursSeen = 0;
+  hourStart = HAL_GetTick();
+  idle = 0;
+  stats.slot = 0;
+  stats.streak = 0;
+}
+
+/**
+  * @brief  Roll the hour slot and fold its drains into the profile
+  * @param  None
+  * @retval None
+  */
+void LeakDetect_Process(void)
+{
+  uint32_t now = HAL_GetTick();
+  uint32_t level;
+
+  while((now - hourStart) >= MS_PER_HOUR) {
+    hourStart += MS_PER_HOUR;
+
+    // The first day sets the profile, later days move it by 1/8
+    level = activity[stats.slot];
+    if(hoursSeen < HOUR_SLOTS) {
+      level = (uint32_t)hourDrains * 16U;
+    } else {
+      level = level - (level + 7U) / 8U + (uint32_t)hourDrains * 2U;
+    }
+    activity[stats.slot] = (uint8_t)((level > SLOT_MAX) ? SLOT_MAX : level);
+
+    hourDrains = 0;
+    stats.slot = (uint8_t)((stats.slot + 1U) % HOUR_SLOTS);
+    if(hoursSeen < LEAK_LEARN_HOURS) {
+      hoursSeen++;
+    }
+  }
+}
+
+/**
+  * @brief  A fill ended at the level switch (starts the next interval)
+  * @param  None
+  * @retval None
+  */
+void LeakDetect_FillFull(void)
+{
+  fillEnd = HAL_GetTick();
+  idle = 1;
+}
+
+/**
+  * @brief  The door was opened (the next drain is explained)
+  * @param  None
+  * @retval None
+  */
+void LeakDetect_DoorActivity(void)
+{
+  idle = 0;
+  EndStreak(0);                 // Someone was at the unit, the held drains prove nothing
+}
+
+/**
+  * @brief  The tank drained from full to refill level
+  * @param  None
+  * @retval uint8_t 1 if this drain confirms a suspected leak (raise ERROR_LEAK)
+  */
+uint8_t LeakDetect_Drained(void)
+{
+  uint8_t bin;
+
+  stats.drains++;
+  if(!idle) {
+    CountDrain();               // Door activity or no fill since boot
+    return 0;
+  }
+  idle = 0;
+  stats.idleDrains++;
+  stats.lastInterval_min = (HAL_GetTick() - fillEnd) / MS_PER_MINUTE;
+
+  // Busy hour (or still learning): consumption explains it and ends the quiet stretch
+  if(hoursSeen < LEAK_LEARN_HOURS || !IsQuiet(stats.slot)) {
+    EndStreak(1);
+    CountDrain();
+    return 0;
+  }
+
+  stats.quietDrains++;
+  bin = Bin(stats.lastInterval_min);
+  if(Percentile(bin) > LEAK_ALPHA_PERMIL) {
+    EndStreak(1);
+    Learn(bin);
+    CountDrain();
+    return 0;
+  }
+
+  stats.suspicious++;
+  held[stats.streak++] = bin;
+  if(stats.streak < LEAK_CONFIRM_DRAINS) {
+    LOG_INFO("leak: drain %u min after fill, %u of %u", stats.lastInterval_min,
+             stats.streak, LEAK_CONFIRM_DRAINS);
+    return 0;
+  }
+
+  // Confirmed: the held drains never reach the baseline or the profile
+  stats.streak = 0;
+  stats.alarms++;
+  LOG_WARN("leak suspected: %u quiet drains, last %u min after fill", LEAK_CONFIRM_DRAINS,
+           stats.lastInterval_min);
+  return 1;
+}
+
+/**
+  * @brief  Get leak detection statistics (refreshes threshold and quiet slots)
+  * @param  None
+  * @retval const LeakDetectStats_t* Pointer to statistics
+  */
+const LeakDetectStats_t* LeakDetect_GetStats(void)
+{
+  uint8_t quiet = 0;
+
+  for(uint8_t i = 0; i < HOUR_SLOTS; i++) {
+    quiet += IsQuiet(i);
+  }
+  stats.quietSlots = quiet;
+  stats.learnHoursLeft = (uint16_t)(LEAK_LEARN_HOURS - hoursSeen);
+
+  // Upper edge of the highest suspicious bin
+  stats.threshold_min = 0;
+  for(uint8_t b = 0; b < INTERVAL_BINS && Percentile(b) <= LEAK_ALPHA_PERMIL; b++) {
+    stats.threshold_min = 1UL << b;
+  }
+  return &stats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Whether a slot and both its neighbours are below LEAK_QUIET_X16 together
+  */
+static uint8_t IsQuiet(uint8_t slot)
+{
+  uint16_t sum = (uint16_t)activity[(slot + HOUR_SLOTS - 1U) % HOUR_SLOTS] + activity[slot] +
+                 activity[(slot + 1U) % HOUR_SLOTS];
+
+  return (sum < LEAK_QUIET_X16) ? 1 : 0;
+}
+
+/**
+  * @brief  log2 minute bin of an interval
+  */
+static uint8_t Bin(uint32_t minutes)
+{
+  uint8_t bin = 0;
+
+  while(minutes > 0U && bin < (INTERVAL_BINS - 1U)) {
+    minutes >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+/**
+  * @brief  Share of the baseline (prior included) at or below a bin, in permil
+  */
+static uint16_t Percentile(uint8_t bin)
+{
+  uint32_t below = 0;
+
+  for(uint8_t b = 0; b <= bin; b++) {
+    below += bins[b];
+  }
+  if(bin == (INTERVAL_BINS - 1U)) {
+    below += LEAK_PRIOR_COUNT;
+  }
+  return (uint16_t)((below * 1000U) / ((uint32_t)binTotal + LEAK_PRIOR_COUNT));
+}
+
+/**
+  * @brief  Add an interval to the baseline, halving it when full
+  */
+static void Learn(uint8_t bin)
+{
+  bins[bin]++;
+  if(++binTotal < BASELINE_HALVE_AT) {
+    return;
+  }
+  binTotal = 0;
+  for(uint8_t b = 0; b < INTERVAL_BINS; b++) {
+    bins[b] /= 2U;
+    binTotal += bins[b];
+  }
+}
+
+/**
+  * @brief  Close the suspicious streak, learning its drains as normal or dropping them
+  */
+static void EndStreak(uint8_t learn)
+{
+  if(learn) {
+    for(uint8_t i = 0; i < stats.streak; i++) {
+      Learn(held[i]);
+      CountDrain();
+    }
+  }
+  stats.streak = 0;
+}
+
+/**
+  * @brief  Count a drain towards the running hour of the profile
+  */
+static void CountDrain(void)
+{
+  if(hourDrains < SLOT_MAX) {
+    hourDrains++;
+  }
+}
+
+#else
+
+// Stubs if disabled - drains are not watched, a leak only shows as refills
+void LeakDetect_Init(void) {}
+void LeakDetect_Process(void) {}
+void LeakDetect_FillFull(void) {}
+void LeakDetect_DoorActivity(void) {}
+uint8_t LeakDetect_Drained(void) { stats.drains++; return 0; }
+const LeakDetectStats_t* LeakDetect_GetStats(void) { return &stats; }
+
+#endif // ENABLE_LEAK_DETECT
@@ -0,0 +1,276 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : low_power.c
+  * @brief          : STOP mode deep sleep for Water Dispenser Control
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "low_power.h"
+#include "cycle_counter.h"
+#include "power_governor.h"
+
+/* Private define ------------------------------------------------------------*/
+#define RTC_ALARM_EXTI_LINE     EXTI_IMR_MR17   // RTC alarm is EXTI line 17
+#define SENSOR_GPIO_PORT        DOOR_SW_GPIO_Port  // Door, level and overflow share GPIOA
+#if ENABLE_OVERFLOW_SENSOR
+#define SENSOR_INPUT_MASK       (DOOR_SW_Pin | WATER_LIMIT_Pin | OVERFLOW_SENSOR_Pin)
+#else
+#define SENSOR_INPUT_MASK       (DOOR_SW_Pin | WATER_LIMIT_Pin)   // PA2 parked (GPIO_OverflowInput_Init)
+#endif
+
+/* Private macro -------------------------------------------------------------*/
+#define STATE_SLOT(state)       ((state) == STATE_FULL ? 1 : 0)
+
+/* Private variables ---------------------------------------------------------*/
+static LowPowerStats_t lpStats;
+static volatile uint8_t alarmFired = 0;
+static uint8_t decisionPending = 0;
+static uint32_t wakeCycles = 0;
+static uint32_t decisionInputs = 0;
+static uint32_t lastAccountTick = 0;
+static SystemState_t lastAccountState = STATE_IDLE;
+
+/* Private function prototypes -----------------------------------------------*/
+extern void SystemClock_Config(void);
+static void RTC_WaitSync(void);
+static void RTC_WaitWriteDone(void);
+static uint32_t RTC_GetCounter(void);
+static void RTC_SetAlarm(uint32_t value);
+static void AccountAwakeTime(SystemState_t state);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Configure RTC (LSI, 1 ms counter) and its alarm wake-up line
+  * @param  None
+  * @retval None
+  */
+void LowPower_Init(void)
+{
+  #if ENABLE_DEEP_SLEEP
+  // RTC lives in the backup domain - LSI is already running for the IWDG
+  HAL_PWR_EnableBkUpAccess();
+  if((RCC->BDCR & RCC_BDCR_RTCEN) == 0U) {
+    RCC->BDCR = (RCC->BDCR & ~RCC_BDCR_RTCSEL) | RCC_BDCR_RTCSEL_LSI;
+    RCC->BDCR |= RCC_BDCR_RTCEN;
+  }
+
+  // 1 kHz counter. RTC and IWDG share the LSI, so wake interval vs IWDG
+  // timeout holds even though the LSI itself is only +/-50% accurate.
+  RTC_WaitSync();
+  RTC_WaitWriteDone();
+  RTC->CRL |= RTC_CRL_CNF;
+  RTC->PRLH = 0;
+  RTC->PRLL = (LSI_VALUE / 1000U) - 1U;
+  RTC->CRL &= ~RTC_CRL_CNF;
+  RTC_WaitWriteDone();
+
+  RTC->CRL &= ~RTC_CRL_ALRF;
+  RTC->CRH |= RTC_CRH_ALRIE;
+
+  EXTI->IMR |= RTC_ALARM_EXTI_LINE;
+  EXTI->RTSR |= RTC_ALARM_EXTI_LINE;
+  HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 15, 0);
+  HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+
+  #ifdef DEBUG
+  // Keep the debugger attached across STOP (costs current - debug builds only)
+  DBGMCU->CR |= DBGMCU_CR_DBG_STOP;
+  #endif
+  #endif
+
+  lastAccountTick = HAL_GetTick();
+}
+
+/**
+  * @brief  Enter STOP mode if the state allows it
+  * @param  state Current state machine state
+  * @retval uint8_t 1 if the MCU slept and has just woken, 0 otherwise
+  */
+uint8_t LowPower_Idle(SystemState_t state)
+{
+  AccountAwakeTime(state);
+
+  #if ENABLE_DEEP_SLEEP
+  // IDLE and FULL always; the eco and critical profiles add COOLDOWN and ERROR
+  if(!PowerGov_SleepAllowed(state) || PUMP_IS_ON()) {
+    return 0;
+  }
+
+  // Supervisor_Process() fed the IWDG on this pass if every task checked in;
+  // arm the housekeeping alarm before going down
+  RTC_WaitSync();
+  uint32_t sleepStart = RTC_GetCounter();
+  RTC_SetAlarm(sleepStart + DEEP_SLEEP_MAX_MS);
+  alarmFired = 0;
+
+  // With interrupts masked an edge from here on stays pending and WFI falls
+  // straight through. An edge already serviced since the last decision shows
+  // up as a changed input, so stay awake for it.
+  __disable_irq();
+  if((SENSOR_GPIO_PORT->IDR & SENSOR_INPUT_MASK) != decisionInputs) {
+    __enable_irq();
+    return 0;
+  }
+
+  PowerGov_EnterSleep();
+  HAL_SuspendTick();
+  HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+  // Woken (EXTI edge or RTC alarm) - restore the clock and the timebase
+  // before any ISR runs. TIM4 was frozen, so the slept time is carried over
+  // into the HAL tick first: the EXTI handler that woke us timestamps its
+  // edge (debounce, latency trace) as soon as interrupts are enabled.
+  wakeCycles = CycleCounter_Now();
+  SystemClock_Config();
+  PowerGov_RestoreClock();
+  RTC_WaitSync();
+  uint32_t sleptMs = RTC_GetCounter() - sleepStart;
+  uwTick += sleptMs;
+  HAL_ResumeTick();
+  __enable_irq();
+
+  lpStats.wakeCount++;
+  if(alarmFired) lpStats.alarmWakeCount++;
+  if(state == STATE_IDLE || state == STATE_FULL) {
+    lpStats.sleptMs[STATE_SLOT(state)] += sleptMs;
+  }
+  lastAccountTick = HAL_GetTick();
+  decisionPending = 1;
+
+  return 1;
+  #else
+  return 0;
+  #endif
+}
+
+/**
+  * @brief  Record wake-to-decision latency
+  * @param  None
+  * @retval None
+  */
+void LowPower_MarkDecision(void)
+{
+  decisionInputs = SENSOR_GPIO_PORT->IDR & SENSOR_INPUT_MASK;
+
+  if(!decisionPending) return;
+  decisionPending = 0;
+
+  uint32_t latency_us = CycleCounter_ToMicros(CycleCounter_Now() - wakeCycles);
+  lpStats.lastWakeToDecision_us = latency_us;
+  if(latency_us > lpStats.maxWakeToDecision_us) {
+    lpStats.maxWakeToDecision_us = latency_us;
+  }
+}
+
+/**
+  * @brief  Estimated average MCU current in a state from the sleep ratio
+  * @param  state STATE_IDLE or STATE_FULL
+  * @retval uint32_t Estimated current in uA (0 for other states)
+  */
+uint32_t LowPower_GetEstimatedCurrent_uA(SystemState_t state)
+{
+  if(state != STATE_IDLE && state != STATE_FULL) return 0;
+
+  uint8_t slot = STATE_SLOT(state);
+  uint32_t slept = lpStats.sleptMs[slot];
+  uint32_t awake = lpStats.awakeMs[slot];
+  uint32_t total = slept + awake;
+
+  if(total == 0) return DEEP_SLEEP_RUN_CURRENT_UA;
+
+  // Time-weighted average; 64-bit so weeks of ms * uA do not overflow
+  uint64_t charge = (uint64_t)awake * DEEP_SLEEP_RUN_CURRENT_UA +
+                    (uint64_t)slept * DEEP_SLEEP_STOP_CURRENT_UA;
+  return (uint32_t)(charge / total);
+}
+
+/**
+  * @brief  Get deep sleep statistics
+  * @param  None
+  * @retval const LowPowerStats_t* Pointer to statistics
+  */
+const LowPowerStats_t* LowPower_GetStats(void)
+{
+  return &lpStats;
+}
+
+/**
+  * @brief  RTC alarm interrupt handler body
+  * @param  None
+  * @retval None
+  */
+void LowPower_RtcAlarmISR(void)
+{
+  RTC->CRL &= ~RTC_CRL_ALRF;
+  EXTI->PR = RTC_ALARM_EXTI_LINE;
+  alarmFired = 1;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Wait until RTC registers are synchronized to the APB1 clock
+  */
+static void RTC_WaitSync(void)
+{
+  RTC->CRL &= ~RTC_CRL_RSF;
+  while((RTC->CRL & RTC_CRL_RSF) == 0U) {
+  }
+}
+
+/**
+  * @brief  Wait for the last RTC register write to complete
+  */
+static void RTC_WaitWriteDone(void)
+{
+  while((RTC->CRL & RTC_CRL_RTOFF) == 0U) {
+  }
+}
+
+/**
+  * @brief  Read the 32-bit RTC counter (handles CNTL rollover between reads)
+  */
+static uint32_t RTC_GetCounter(void)
+{
+  uint16_t high1 = RTC->CNTH;
+  uint16_t low = RTC->CNTL;
+  uint16_t high2 = RTC->CNTH;
+
+  if(high1 != high2) {
+    low = RTC->CNTL;
+  }
+  return ((uint32_t)high2 << 16) | low;
+}
+
+/**
+  * @brief  Program the RTC alarm register
+  */
+static void RTC_SetAlarm(uint32_t value)
+{
+  RTC_WaitWriteDone();
+  RTC->CRL |= RTC_CRL_CNF;
+  RTC->ALRH = value >> 16;
+  RTC->ALRL = value & 0xFFFFU;
+  RTC->CRL &= ~RTC_CRL_CNF;
+  RTC_WaitWriteDone();
+}
+
+/**
+  * @brief  Attribute the time since the last call to the awake counter
+  */
+static void AccountAwakeTime(SystemState_t state)
+{
+  uint32_t now = HAL_GetTick();
+  uint32_t elapsed = now - lastAccountTick;
+  lastAccountTick = now;
+
+  if(lastAccountState == STATE_IDLE || lastAccountState == STATE_FULL) {
+    lpStats.awakeMs[STATE_SLOT(lastAccountState)] += elapsed;
+  }
+  lastAccountState = state;
+}
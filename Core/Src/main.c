@@ -29,6 +29,22 @@
 #include "sensors.h"
 #include "error_log.h"
 #include "config_storage.h"
+#include "pump_safety.h"
+#include "latency_trace.h"
+#include "remote_monitor.h"
+#include "low_power.h"
+#include "timebase.h"
+#include "flow_meter.h"
+#include "pump_current.h"
+#include "adc_sampler.h"
+#include "power_governor.h"
+#include "checkpoint.h"
+#include "warm_restart.h"
+#include "crash_dump.h"
+#include "stack_monitor.h"
+#include "sensor_health.h"
+#include "leak_detect.h"
+#include "supervisor.h"
 
 /* USER CODE END Includes */
 
@@ -84,10 +100,10 @@ static void System_Shutdown(void)
   for(int i = 0; i < 3; i++) {
     PROGRAM_LED_ON();
     STATUS_LED_ON();
-    HAL_Delay(200);
+    Supervisor_Delay(200);
     PROGRAM_LED_OFF();
     STATUS_LED_OFF();
-    HAL_Delay(200);
+    Supervisor_Delay(200);
   }
   
   // Turn off all peripherals
@@ -116,23 +132,41 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-
+  WarmRestart_Init();       // Latch RCC_CSR reset flags before anything clears them
   /* USER CODE END Init */
 
   /* Configure the system clock */
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  Timebase_Init();
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_IWDG_Init();
   /* USER CODE BEGIN 2 */
+  GPIO_OverflowInput_Init();  // PA2 pulled, or parked with EXTI2 masked when no sensor is fitted
+
   // Initialize system modules
+  CrashDump_Init();         // Fault handlers on, pending crash record moved to flash
+  LatencyTrace_Init();
+  PumpSafety_Init();
   Sensors_Init();
   StateMachine_Init();
+  Checkpoint_Init();        // Restores lifetime counters over the fresh state machine
+  StateMachine_Resume();    // After a watchdog/software reset: state, hold-off, counters
+  Remote_Init();
+  LowPower_Init();
+  FlowMeter_Init();
+  AdcSampler_Init();
+  PumpCurrent_Init();
+  PowerGov_Init();
+  StackMonitor_Init();
+  Supervisor_Init();        // Reset history; from here the tasks must check in and the WWDG runs
+  Remote_SendCrashReport();
+  Remote_SendSupervisorReport();
+  Remote_SendFormatBenchmark();
   
   // Run startup sequence
   System_Startup();
@@ -144,7 +178,10 @@ int main(void)
   
   // Non-blocking loop variables
   uint32_t lastLoopTime = 0;
-  uint32_t lastIWDGRefresh = 0;
+  uint32_t lastStatusReport = 0;
+  uint32_t lastLatencyReport = 0;
+  uint32_t reportPass = 0;
+  uint8_t reportStep = 0;
   uint32_t loopInterval = 10; // Default 10ms
   
   while (1)
@@ -172,32 +209,81 @@ int main(void)
 
     uint32_t currentTime = HAL_GetTick();
 
-    // IWDG refresh every 2 seconds (safe margin for ~3.2s timeout)
-    if((currentTime - lastIWDGRefresh) >= 2000) {
-      lastIWDGRefresh = currentTime;
-      HAL_IWDG_Refresh(&hiwdg);
-    }
-
     // Non-blocking loop timing
     if((currentTime - lastLoopTime) >= loopInterval) {
       lastLoopTime = currentTime;
 
+      // Fold flow meter pulses and current blocks in before the state machine looks at them
+      FlowMeter_Sample();
+      PumpCurrent_Process();
+
       // Process state machine
       StateMachine_Process();
+      LowPower_MarkDecision();
 
-      // Update LED indicators
+      // Update LED indicators (duty-limited by the power profile)
       StateMachine_UpdateLEDs();
+      PowerGov_FilterLeds();
+      Supervisor_CheckIn(SUP_TASK_CONTROL);
+
+      // Re-arm the power-fail flush after a supply dip that recovered
+      Checkpoint_Process();
+
+      // Battery-driven profile changes (clock, LEDs, telemetry, start budget)
+      PowerGov_Process();
+
+      // Bounded slice of the stack high-water scan
+      StackMonitor_Process();
+
+      // Bounce estimates, debounce windows and edges per minute
+      SensorHealth_Process();
+
+      // Hour-of-day drain profile for the leak detector
+      LeakDetect_Process();
+      Supervisor_CheckIn(SUP_TASK_HOUSEKEEPING);
       
       // Adaptive rate based on state for power efficiency
       SystemState_t state = StateMachine_GetState();
       if(state == STATE_FILLING) {
         loopInterval = 10; // Fast response needed
-      } else if(state == STATE_DOOR_OPEN || state == STATE_ERROR) {
-        loopInterval = 20; // Medium response
+      } else if(state == STATE_DOOR_OPEN || state == STATE_ERROR || state == STATE_WAIT_SETTLE) {
+        loopInterval = 20; // Medium response (settle samples the level every pass)
       } else {
         loopInterval = 50; // Slow response (IDLE/FULL) - saves CPU
       }
     }
+
+    // Remote telemetry (no-op stubs unless ENABLE_REMOTE_MONITOR)
+    uint32_t statusInterval = PowerGov_GetProfile()->telemetryInterval;
+    if(statusInterval != 0 && (currentTime - lastStatusReport) >= statusInterval) {
+      lastStatusReport = currentTime;
+      Remote_SendStatus();
+    }
+    if((currentTime - lastLatencyReport) >= REMOTE_LATENCY_INTERVAL) {
+      lastLatencyReport = currentTime;
+      reportStep = 1;
+    }
+    // One report per control pass keeps each blocking burst inside the WWDG timeout
+    if(reportStep != 0 && lastLoopTime != reportPass) {
+      reportPass = lastLoopTime;
+      switch(reportStep++) {
+        case 1:  Remote_SendLatencyReport(); break;
+        case 2:  Remote_SendPowerReport(); break;
+        case 3:  Remote_SendMemoryReport(); break;
+        default: Remote_SendSupervisorReport(); reportStep = 0; break;
+      }
+    }
+    Remote_SendLog();
+    Supervisor_CheckIn(SUP_TASK_IO);
+
+    // IWDG only when every task checked in, WWDG once per control pass
+    Supervisor_Process();
+
+    // Deep sleep (IDLE/FULL, more states in eco/critical) until the next sensor edge or RTC alarm
+    if(LowPower_Idle(StateMachine_GetState())) {
+      lastLoopTime = HAL_GetTick() - loopInterval; // Decide right after wake
+      Supervisor_Resync();                          // Slept time is not a missed deadline
+    }
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -255,8 +341,14 @@ static void System_Startup(void)
   PROGRAM_LED_OFF();
   STATUS_LED_OFF();
 
+  // Warm restart (watchdog/software reset): resume at once, no LED sequences
+  if(WarmRestart_IsWarm()) {
+    Sensors_SelfTest();
+    return;
+  }
+
   // Power-on stabilization delay
-  HAL_Delay(500);
+  Supervisor_Delay(500);
   
   // Self-test sensors (Task 8)
   uint8_t sensorTest = Sensors_SelfTest();
@@ -266,10 +358,10 @@ static void System_Startup(void)
     for(int i = 0; i < 10; i++) {
       PROGRAM_LED_ON();
       STATUS_LED_OFF();
-      HAL_Delay(100);
+      Supervisor_Delay(100);
       PROGRAM_LED_OFF();
       STATUS_LED_ON();
-      HAL_Delay(100);
+      Supervisor_Delay(100);
     }
     STATUS_LED_OFF();
     // Continue anyway, but user is warned
@@ -279,13 +371,13 @@ static void System_Startup(void)
   for(int i = 0; i < 3; i++) {
     PROGRAM_LED_ON();
     STATUS_LED_ON();
-    HAL_Delay(150);
+    Supervisor_Delay(150);
     PROGRAM_LED_OFF();
     STATUS_LED_OFF();
-    HAL_Delay(150);
+    Supervisor_Delay(150);
   }
 
-  HAL_Delay(500);
+  Supervisor_Delay(500);
 }
 /**
   * @brief  Display system diagnostics via LED
@@ -297,42 +389,46 @@ static void System_Diagnostics(void)
   // Fast blink = correct speed
   for(int i = 0; i < 8; i++) {
     PROGRAM_LED_TOGGLE();
-    HAL_Delay(100);
+    Supervisor_Delay(100);
   }
-  HAL_Delay(500);
+  Supervisor_Delay(500);
   
   // Pattern 2: Sensor status
   if(Sensors_IsDoorClosed()) {
     STATUS_LED_ON();
-    HAL_Delay(500);
+    Supervisor_Delay(500);
     STATUS_LED_OFF();
   }
-  HAL_Delay(500);
+  Supervisor_Delay(500);
   
   if(Sensors_IsTankFull()) {
     STATUS_LED_ON();
-    HAL_Delay(500);
+    Supervisor_Delay(500);
     STATUS_LED_OFF();
   }
-  HAL_Delay(500);
+  Supervisor_Delay(500);
   
+  // One consistent copy for both patterns (main loop is the only writer)
+  SystemStats_t stats;
+  StateMachine_GetStatsSnapshot(&stats);
+
   // Pattern 3: Error count
-  uint8_t errorCount = StateMachine_GetStats()->errorCount;
+  uint8_t errorCount = stats.errorCount;
   for(int i = 0; i < errorCount && i < 10; i++) {
     PROGRAM_LED_ON();
-    HAL_Delay(200);
+    Supervisor_Delay(200);
     PROGRAM_LED_OFF();
-    HAL_Delay(200);
+    Supervisor_Delay(200);
   }
   
   // Pattern 4: Pump cycle count (tens)
-  uint32_t cycles = StateMachine_GetStats()->pumpCycleCount;
+  uint32_t cycles = stats.pumpCycleCount;
   uint8_t tens = (cycles / 10) % 10;
   for(int i = 0; i < tens; i++) {
     STATUS_LED_ON();
-    HAL_Delay(200);
+    Supervisor_Delay(200);
     STATUS_LED_OFF();
-    HAL_Delay(200);
+    Supervisor_Delay(200);
   }
 }
 
@@ -0,0 +1,135 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : mem_pool.c
+  * @brief          : Fixed-block static pools and RAM footprint report
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mem_pool.h"
+
+/* Private define ------------------------------------------------------------*/
+#define RAM_ORIGIN              0x20000000U
+
+/* Private macro -------------------------------------------------------------*/
+#define ENTER_CRITICAL()  uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define EXIT_CRITICAL()   __set_PRIMASK(primask)
+
+/* Private variables ---------------------------------------------------------*/
+static MemPool_t* pools[MEM_POOL_MAX_POOLS];
+static uint8_t poolCount = 0;
+
+// Linker script symbols
+extern uint8_t _sdata, _edata, _sbss, _ebss, _snoinit, _enoinit, _estack;
+extern uint8_t _Min_Heap_Size, _Min_Stack_Size;
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Add a pool to the memory report
+  * @param  pool Pool defined with MEM_POOL_DEFINE
+  * @retval None
+  */
+void MemPool_Register(MemPool_t* pool)
+{
+  for(uint8_t i = 0; i < poolCount; i++) {
+    if(pools[i] == pool) return;
+  }
+  if(poolCount < MEM_POOL_MAX_POOLS) {
+    pools[poolCount++] = pool;
+  }
+}
+
+/**
+  * @brief  Take one block
+  * @param  pool Pool
+  * @retval void* Block, NULL if the pool is exhausted (counted as a failure)
+  */
+void* MemPool_Alloc(MemPool_t* pool)
+{
+  void* block = NULL;
+
+  ENTER_CRITICAL();
+  if(pool->freeMask != 0U) {
+    uint32_t n = __CLZ(__RBIT(pool->freeMask));     // Lowest free block
+    pool->freeMask &= ~(1UL << n);
+    pool->used++;
+    if(pool->used > pool->highWater) {
+      pool->highWater = pool->used;
+    }
+    block = pool->storage + n * pool->blockSize;
+  } else {
+    pool->failures++;
+  }
+  EXIT_CRITICAL();
+
+  return block;
+}
+
+/**
+  * @brief  Return a block taken with MemPool_Alloc
+  * @param  pool Pool the block came from
+  * @param  block Block (NULL is ignored)
+  * @retval None
+  */
+void MemPool_Free(MemPool_t* pool, void* block)
+{
+  if(block == NULL) {
+    return;
+  }
+
+  uint32_t n = (uint32_t)((uint8_t*)block - pool->storage) / pool->blockSize;
+
+  ENTER_CRITICAL();
+  // A foreign pointer or a double free is ignored rather than corrupting the count
+  if(n < pool->blockCount && (pool->freeMask & (1UL << n)) == 0U) {
+    pool->freeMask |= (1UL << n);
+    pool->used--;
+  }
+  EXIT_CRITICAL();
+}
+
+/**
+  * @brief  Registered pool by index (for reports)
+  * @param  index 0 .. MemPool_GetCount() - 1
+  * @retval const MemPool_t* Pool, NULL if out of range
+  */
+const MemPool_t* MemPool_Get(uint8_t index)
+{
+  return (index < poolCount) ? pools[index] : NULL;
+}
+
+/**
+  * @brief  Number of registered pools
+  * @param  None
+  * @retval uint8_t Count
+  */
+uint8_t MemPool_GetCount(void)
+{
+  return poolCount;
+}
+
+/**
+  * @brief  Static RAM footprint
+  * @param  fp Receives the footprint
+  * @retval None
+  */
+void MemPool_GetFootprint(MemFootprint_t* fp)
+{
+  uint32_t total = (uint32_t)&_estack - RAM_ORIGIN;
+
+  fp->data = (uint32_t)(&_edata - &_sdata);
+  fp->bss = (uint32_t)(&_ebss - &_sbss);
+  fp->noinit = (uint32_t)(&_enoinit - &_snoinit);
+  fp->heap = (uint32_t)&_Min_Heap_Size;             // Absolute symbol: its address is the value
+  fp->stack = (uint32_t)&_Min_Stack_Size;
+  fp->free = total - fp->data - fp->bss - fp->noinit - fp->heap - fp->stack;
+
+  fp->pooled = 0;
+  for(uint8_t i = 0; i < poolCount; i++) {
+    fp->pooled += (uint32_t)pools[i]->blockCount * pools[i]->blockSize;
+  }
+}
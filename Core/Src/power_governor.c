@@ -0,0 +1,315 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : power_governor.c
+  * @brief          : Battery-aware operating profiles (normal / eco / critical)
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "power_governor.h"
+#include "battery_monitor.h"
+#include "adc_sampler.h"
+#include "remote_monitor.h"
+#include "supervisor.h"
+#include "deferred_log.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SLEEP_BASE      (POWER_SLEEP_STATE(STATE_IDLE) | POWER_SLEEP_STATE(STATE_FULL))
+#define MS_PER_HOUR     3600000UL
+#define FILTER_SHIFT    3       // 1/8 per evaluation: ~8 s time constant at 1 s
+
+/* Private variables ---------------------------------------------------------*/
+static const PowerProfile_t profiles[POWER_PROFILE_COUNT] = {
+  // name        clock            LED  telemetry               starts/h                        STOP states
+  { "normal",   RCC_SYSCLK_DIV1, 100, REMOTE_STATUS_INTERVAL, 0,                              SLEEP_BASE },
+  { "eco",      RCC_SYSCLK_DIV2, 20,  POWER_ECO_TELEMETRY_MS, POWER_ECO_STARTS_PER_HOUR,      SLEEP_BASE | POWER_SLEEP_STATE(STATE_COOLDOWN) },
+  { "critical", RCC_SYSCLK_DIV4, 5,   0,                      POWER_CRITICAL_STARTS_PER_HOUR, SLEEP_BASE | POWER_SLEEP_STATE(STATE_COOLDOWN) | POWER_SLEEP_STATE(STATE_ERROR) },
+};
+
+static PowerProfileId_t active = POWER_PROFILE_NORMAL;
+
+#if ENABLE_POWER_GOVERNOR
+
+static PowerGovStats_t govStats;
+static int32_t filtered_q4 = 0;             // Battery mV << 4, 0 = no reading yet
+static PowerProfileId_t pending = POWER_PROFILE_NORMAL;
+static uint32_t pendingSince = 0;
+static uint32_t lastEval = 0;
+static uint32_t profileMs = 0;              // Sub-second remainder of timeInProfile_s
+static uint32_t budgetWindowStart = 0;
+static uint8_t budgetStarts = 0;
+static uint8_t refusing = 0;                // Count a held-back refill once
+
+/* Private function prototypes -----------------------------------------------*/
+static PowerProfileId_t SelectProfile(uint16_t mV);
+static void ApplyProfile(PowerProfileId_t id);
+static void ApplyClock(uint32_t ahbDivider);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Start in the normal profile
+  * @param  None
+  * @retval None
+  */
+void PowerGov_Init(void)
+{
+  active = POWER_PROFILE_NORMAL;
+  pending = POWER_PROFILE_NORMAL;
+  filtered_q4 = 0;
+  lastEval = HAL_GetTick();
+  budgetWindowStart = lastEval;
+  budgetStarts = 0;
+}
+
+/**
+  * @brief  Re-evaluate the profile from the battery voltage (main loop)
+  * @param  None
+  * @retval None
+  */
+void PowerGov_Process(void)
+{
+  uint32_t now = HAL_GetTick();
+  uint32_t elapsed = now - lastEval;
+
+  if(elapsed < POWER_EVAL_INTERVAL_MS) {
+    return;
+  }
+  lastEval = now;
+
+  profileMs += elapsed;
+  govStats.timeInProfile_s[active] += profileMs / 1000U;
+  profileMs %= 1000U;
+
+  // Pump load sags the battery without changing its charge: filter only at rest
+  uint16_t mV = Battery_GetVoltage_mV();
+  if(mV == 0 || PUMP_IS_ON()) {
+    return;
+  }
+  if(filtered_q4 == 0) {
+    filtered_q4 = (int32_t)mV << 4;
+  } else {
+    filtered_q4 += (((int32_t)mV << 4) - filtered_q4) >> FILTER_SHIFT;
+  }
+  govStats.filtered_mV = (uint16_t)(filtered_q4 >> 4);
+
+  PowerProfileId_t wanted = SelectProfile(govStats.filtered_mV);
+  if(wanted == active) {
+    pending = active;
+    return;
+  }
+  if(wanted != pending) {
+    pending = wanted;
+    pendingSince = now;
+    return;
+  }
+  if((now - pendingSince) >= POWER_SWITCH_DWELL_MS) {
+    ApplyProfile(wanted);
+  }
+}
+
+/**
+  * @brief  Active profile
+  * @param  None
+  * @retval PowerProfileId_t Profile id
+  */
+PowerProfileId_t PowerGov_GetProfileId(void)
+{
+  return active;
+}
+
+/**
+  * @brief  Active profile settings
+  * @param  None
+  * @retval const PowerProfile_t* Pointer to settings
+  */
+const PowerProfile_t* PowerGov_GetProfile(void)
+{
+  return &profiles[active];
+}
+
+/**
+  * @brief  Whether a state may enter STOP mode in the active profile
+  * @param  state Current state
+  * @retval uint8_t 1 if allowed
+  */
+uint8_t PowerGov_SleepAllowed(SystemState_t state)
+{
+  return (profiles[active].sleepStates & POWER_SLEEP_STATE(state)) != 0U;
+}
+
+/**
+  * @brief  Whether the hourly pump start budget has room for one more
+  * @param  None
+  * @retval uint8_t 1 if a pump start is allowed
+  */
+uint8_t PowerGov_PumpStartAllowed(void)
+{
+  uint8_t limit = profiles[active].pumpStartsPerHour;
+
+  if((HAL_GetTick() - budgetWindowStart) >= MS_PER_HOUR) {
+    budgetWindowStart = HAL_GetTick();
+    budgetStarts = 0;
+  }
+  if(limit == 0 || budgetStarts < limit) {
+    refusing = 0;
+    return 1;
+  }
+
+  if(!refusing) {
+    refusing = 1;
+    govStats.refusedStarts++;
+  }
+  return 0;
+}
+
+/**
+  * @brief  Count a pump start against the hourly budget
+  * @param  None
+  * @retval None
+  */
+void PowerGov_NotePumpStart(void)
+{
+  if(budgetStarts < 0xFF) budgetStarts++;
+}
+
+/**
+  * @brief  Blank the LEDs outside the profile's duty window
+  * @param  None
+  * @retval None
+  * @note   Call right after StateMachine_UpdateLEDs()
+  */
+void PowerGov_FilterLeds(void)
+{
+  uint8_t duty = profiles[active].ledDutyPercent;
+
+  if(duty >= 100) {
+    return;
+  }
+  if((HAL_GetTick() % POWER_LED_PERIOD_MS) >= (POWER_LED_PERIOD_MS * duty) / 100U) {
+    PROGRAM_LED_OFF();
+    STATUS_LED_OFF();
+  }
+}
+
+/**
+  * @brief  About to enter STOP mode: LEDs off unless the profile runs at full duty
+  * @param  None
+  * @retval None
+  */
+void PowerGov_EnterSleep(void)
+{
+  if(profiles[active].ledDutyPercent < 100) {
+    PROGRAM_LED_OFF();
+    STATUS_LED_OFF();
+  }
+}
+
+/**
+  * @brief  Re-apply the profile clock after SystemClock_Config() (STOP wake)
+  * @param  None
+  * @retval None
+  */
+void PowerGov_RestoreClock(void)
+{
+  if(profiles[active].ahbDivider != RCC_SYSCLK_DIV1) {
+    ApplyClock(profiles[active].ahbDivider);
+  }
+}
+
+/**
+  * @brief  Get governor statistics
+  * @param  None
+  * @retval const PowerGovStats_t* Pointer to statistics
+  */
+const PowerGovStats_t* PowerGov_GetStats(void)
+{
+  return &govStats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Profile for a filtered voltage, with hysteresis around the active one
+  */
+static PowerProfileId_t SelectProfile(uint16_t mV)
+{
+  switch(active) {
+    case POWER_PROFILE_NORMAL:
+      if(mV < POWER_CRITICAL_ENTER_MV) return POWER_PROFILE_CRITICAL;
+      if(mV < POWER_ECO_ENTER_MV) return POWER_PROFILE_ECO;
+      return POWER_PROFILE_NORMAL;
+
+    case POWER_PROFILE_ECO:
+      if(mV < POWER_CRITICAL_ENTER_MV) return POWER_PROFILE_CRITICAL;
+      if(mV > POWER_ECO_EXIT_MV) return POWER_PROFILE_NORMAL;
+      return POWER_PROFILE_ECO;
+
+    default:
+      if(mV > POWER_ECO_EXIT_MV) return POWER_PROFILE_NORMAL;
+      if(mV > POWER_CRITICAL_EXIT_MV) return POWER_PROFILE_ECO;
+      return POWER_PROFILE_CRITICAL;
+  }
+}
+
+/**
+  * @brief  Switch profile and apply its clock
+  */
+static void ApplyProfile(PowerProfileId_t id)
+{
+  LOG_INFO("power profile %u -> %u", active, id);
+  active = id;
+  pending = id;
+  govStats.switchCount++;
+  ApplyClock(profiles[id].ahbDivider);
+}
+
+/**
+  * @brief  Set the AHB divider (SYSCLK stays on HSI) and retune clock users
+  */
+static void ApplyClock(uint32_t ahbDivider)
+{
+  RCC_ClkInitTypeDef RCC_ClkInitStruct = {0};
+
+  // Same tree as SystemClock_Config(), only HCLK (and with it PCLK1/2) divided.
+  // HAL_RCC_ClockConfig() re-runs HAL_InitTick(), so TIM4 keeps a 1 MHz count.
+  RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK
+                              |RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
+  RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+  RCC_ClkInitStruct.AHBCLKDivider = ahbDivider;
+  RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
+  RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+
+  if(HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK) {
+    Error_Handler();
+  }
+
+  AdcSampler_ClockChanged();
+  Remote_ClockChanged();
+  Supervisor_ClockChanged();
+}
+
+#else
+
+// Stubs if disabled - always the normal profile
+static PowerGovStats_t govStats;
+
+void PowerGov_Init(void) {}
+void PowerGov_Process(void) {}
+PowerProfileId_t PowerGov_GetProfileId(void) { return active; }
+const PowerProfile_t* PowerGov_GetProfile(void) { return &profiles[active]; }
+uint8_t PowerGov_SleepAllowed(SystemState_t state)
+{
+  return (profiles[active].sleepStates & POWER_SLEEP_STATE(state)) != 0U;
+}
+uint8_t PowerGov_PumpStartAllowed(void) { return 1; }
+void PowerGov_NotePumpStart(void) {}
+void PowerGov_FilterLeds(void) {}
+void PowerGov_EnterSleep(void) {}
+void PowerGov_RestoreClock(void) {}
+const PowerGovStats_t* PowerGov_GetStats(void) { return &govStats; }
+
+#endif // ENABLE_POWER_GOVERNOR
@@ -0,0 +1,136 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : pump_current.c
+  * @brief          : Pump motor current monitoring (dry run / stall)
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "pump_current.h"
+#include "adc_sampler.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define COUNTS_TO_MA(counts)  ((uint16_t)((((counts) > PUMP_CURRENT_ZERO_COUNTS ?                  \
+                                           (uint32_t)(counts) - PUMP_CURRENT_ZERO_COUNTS : 0U) *  \
+                                          PUMP_CURRENT_FULL_SCALE_MA) / 4095U))
+
+/* Private variables ---------------------------------------------------------*/
+static PumpCurrentStatus_t status;
+
+#if ENABLE_PUMP_CURRENT
+
+static CurrentDetector_t detector;
+
+static const CurrentDetectorParams_t params = {
+  .dry_mA       = PUMP_CURRENT_DRY_MA,
+  .stall_mA     = PUMP_CURRENT_STALL_MA,
+  .dryPercent   = PUMP_CURRENT_DRY_PERCENT,
+  .stallPercent = PUMP_CURRENT_STALL_PERCENT,
+  .blank_ms     = PUMP_CURRENT_BLANK_MS,
+  .dryHold_ms   = PUMP_CURRENT_DRY_HOLD_MS,
+  .stallHold_ms = PUMP_CURRENT_STALL_HOLD_MS,
+  .avgShift     = PUMP_CURRENT_AVG_SHIFT,
+};
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Set up the detector (sampling is started by AdcSampler_Init)
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_Init(void)
+{
+  CurrentDetector_Init(&detector, &params);
+}
+
+/**
+  * @brief  Feed queued ADC blocks to the detector (main loop)
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_Process(void)
+{
+  uint16_t means[ADC_CH_COUNT];
+
+  while(AdcSampler_PopBlock(means)) {
+    uint16_t current = COUNTS_TO_MA(means[ADC_CH_PUMP_CURRENT]);
+
+    if(!PUMP_IS_ON()) {
+      status.avg_mA = current;
+      continue;
+    }
+
+    CurrentFault_t before = detector.fault;
+    CurrentFault_t fault = CurrentDetector_Update(&detector, current, ADC_SAMPLER_BLOCK_MS);
+
+    if(fault != before) {
+      if(fault == CURRENT_FAULT_DRY) status.dryTrips++;
+      if(fault == CURRENT_FAULT_STALL) status.stallTrips++;
+    }
+    status.avg_mA = CurrentDetector_GetAverage_mA(&detector);
+    status.fault = fault;
+  }
+}
+
+/**
+  * @brief  Pump switched on - restart inrush blanking
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_Start(void)
+{
+  uint16_t means[ADC_CH_COUNT];
+
+  // Blocks still queued were sampled with the pump off
+  while(AdcSampler_PopBlock(means)) { }
+
+  CurrentDetector_Start(&detector);
+  status.fault = CURRENT_FAULT_NONE;
+}
+
+/**
+  * @brief  Fill ended with the tank full - learn the running current
+  * @param  None
+  * @retval None
+  */
+void PumpCurrent_FillComplete(void)
+{
+  CurrentDetector_LearnNominal(&detector);
+  status.nominal_mA = detector.nominal_mA;
+}
+
+/**
+  * @brief  Detector verdict for the running fill
+  * @param  None
+  * @retval CurrentFault_t CURRENT_FAULT_NONE unless dry or stalled
+  */
+CurrentFault_t PumpCurrent_GetFault(void)
+{
+  return status.fault;
+}
+
+/**
+  * @brief  Get pump current status
+  * @param  None
+  * @retval const PumpCurrentStatus_t* Pointer to status
+  */
+const PumpCurrentStatus_t* PumpCurrent_GetStatus(void)
+{
+  return &status;
+}
+
+#else
+
+// Stubs if disabled
+void PumpCurrent_Init(void) {}
+void PumpCurrent_Process(void) {}
+void PumpCurrent_Start(void) {}
+void PumpCurrent_FillComplete(void) {}
+CurrentFault_t PumpCurrent_GetFault(void) { return CURRENT_FAULT_NONE; }
+const PumpCurrentStatus_t* PumpCurrent_GetStatus(void) { return &status; }
+
+#endif // ENABLE_PUMP_CURRENT
@@ -0,0 +1,242 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : pump_health.c
+  * @brief          : Trend-based pump health model (integer only)
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "pump_health.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct {
+  uint32_t duration_ms;         // Complete fill duration
+  uint32_t timestamp;           // HAL tick at the end of the fill
+} FillSample_t;
+
+/* Private define ------------------------------------------------------------*/
+#define MS_PER_DAY                86400000ULL
+#define FAILURE_FILL_TIME         PUMP_NORMAL_FILL_TIME  // Fill longer than this = "gallon empty"
+#define ERROR_WORDS               ((PUMP_HEALTH_ERROR_WINDOW + 31) / 32)
+
+// Score penalties (points off 100)
+#define PENALTY_TREND_MAX         40    // 4 points per 1 permille/fill growth
+#define PENALTY_MARGIN_MAX        15    // Fitted fill beyond 2/3 of the failure time
+#define PENALTY_ERROR_MAX         30    // 1 point per error per 100 cycles
+#define PENALTY_DUTY_MAX          15    // Mean duty above 50%
+
+/* Private macro -------------------------------------------------------------*/
+#define MIN(a, b)                 (((a) < (b)) ? (a) : (b))
+
+/* Private variables ---------------------------------------------------------*/
+static FillSample_t fills[PUMP_HEALTH_WINDOW];
+static uint8_t fillHead = 0;
+static uint8_t fillCount = 0;
+
+static uint8_t dutyHistory[PUMP_HEALTH_WINDOW];
+static uint8_t dutyHead = 0;
+static uint8_t dutyCount = 0;
+
+static uint32_t errorBits[ERROR_WORDS];
+static uint8_t errorIndex = 0;
+static uint8_t errorCycles = 0;
+static uint8_t errorTotal = 0;
+
+static PumpHealthReport_t report;
+
+/* Private function prototypes -----------------------------------------------*/
+static void RecordError(uint8_t isError);
+static void UpdateTrend(void);
+static void UpdateScore(void);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Clear history
+  * @param  None
+  * @retval None
+  */
+void PumpHealth_Init(void)
+{
+  fillHead = 0;
+  fillCount = 0;
+  dutyHead = 0;
+  dutyCount = 0;
+  errorIndex = 0;
+  errorCycles = 0;
+  errorTotal = 0;
+  for(int i = 0; i < ERROR_WORDS; i++) {
+    errorBits[i] = 0;
+  }
+
+  report.score = 100;
+  report.daysToFailure = PUMP_HEALTH_DAYS_NONE;
+  report.trend_ms_per_fill = 0;
+  report.fitDuration_ms = 0;
+  report.errorsPer100 = 0;
+  report.avgDutyPercent = 0;
+  report.samples = 0;
+}
+
+/**
+  * @brief  Record a finished pump cycle and recompute the report
+  * @param  runtime_ms Pump on time of the cycle
+  * @param  dutyPercent Duty cycle over the current window (0-100)
+  * @param  outcome How the cycle ended
+  * @retval None
+  */
+void PumpHealth_RecordCycle(uint32_t runtime_ms, uint8_t dutyPercent,
+                            PumpCycleOutcome_t outcome)
+{
+  RecordError(outcome == PUMP_CYCLE_ERROR);
+
+  dutyHistory[dutyHead] = dutyPercent;
+  dutyHead = (dutyHead + 1) & (PUMP_HEALTH_WINDOW - 1);
+  if(dutyCount < PUMP_HEALTH_WINDOW) dutyCount++;
+
+  // Only complete fills say anything about how fast the pump moves water
+  if(outcome == PUMP_CYCLE_FULL) {
+    fills[fillHead].duration_ms = runtime_ms;
+    fills[fillHead].timestamp = HAL_GetTick();
+    fillHead = (fillHead + 1) & (PUMP_HEALTH_WINDOW - 1);
+    if(fillCount < PUMP_HEALTH_WINDOW) fillCount++;
+  }
+
+  UpdateTrend();
+  UpdateScore();
+}
+
+/**
+  * @brief  Get the current health report
+  * @param  None
+  * @retval const PumpHealthReport_t* Pointer to report
+  */
+const PumpHealthReport_t* PumpHealth_GetReport(void)
+{
+  return &report;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Slide the 100-cycle error bitmap by one cycle
+  */
+static void RecordError(uint8_t isError)
+{
+  uint32_t* word = &errorBits[errorIndex >> 5];
+  uint32_t mask = 1UL << (errorIndex & 31);
+
+  if(*word & mask) errorTotal--;
+  if(isError) {
+    *word |= mask;
+    errorTotal++;
+  } else {
+    *word &= ~mask;
+  }
+
+  if(++errorIndex >= PUMP_HEALTH_ERROR_WINDOW) errorIndex = 0;
+  if(errorCycles < PUMP_HEALTH_ERROR_WINDOW) errorCycles++;
+
+  // Normalise to 100 cycles, but do not let the first few cycles swing it
+  uint8_t cycles = (errorCycles > PUMP_HEALTH_WINDOW) ? errorCycles : PUMP_HEALTH_WINDOW;
+  report.errorsPer100 = (uint8_t)((errorTotal * 100U) / cycles);
+}
+
+/**
+  * @brief  Least-squares fit of fill duration over the window, and the
+  *         extrapolated time until a fill reaches FAILURE_FILL_TIME
+  */
+static void UpdateTrend(void)
+{
+  int32_t n = fillCount;
+  report.samples = (uint8_t)n;
+
+  if(n < 2) {
+    report.trend_ms_per_fill = 0;
+    report.fitDuration_ms = (n == 1) ? fills[0].duration_ms : 0;
+    report.daysToFailure = PUMP_HEALTH_DAYS_NONE;
+    return;
+  }
+
+  // x = 0 (oldest) .. n-1 (newest)
+  uint8_t start = (uint8_t)(fillHead - n) & (PUMP_HEALTH_WINDOW - 1);
+  int64_t sumY = 0;
+  int64_t sumXY = 0;
+  for(int32_t x = 0; x < n; x++) {
+    uint32_t y = fills[(start + x) & (PUMP_HEALTH_WINDOW - 1)].duration_ms;
+    sumY += y;
+    sumXY += (int64_t)x * y;
+  }
+
+  int32_t sumX = (n * (n - 1)) / 2;
+  int32_t sumXX = ((n - 1) * n * (2 * n - 1)) / 6;
+  int32_t den = (n * sumXX) - (sumX * sumX);
+  int32_t slope = (int32_t)(((int64_t)n * sumXY - (int64_t)sumX * sumY) / den);
+
+  // Fitted value at the newest sample: mean + slope * (x_last - x_mean)
+  int64_t fit = (sumY / n) + ((int64_t)slope * (n - 1)) / 2;
+  if(fit < 0) fit = 0;
+
+  report.trend_ms_per_fill = slope;
+  report.fitDuration_ms = (uint32_t)fit;
+
+  if(n < PUMP_HEALTH_MIN_SAMPLES || slope <= 0) {
+    report.daysToFailure = PUMP_HEALTH_DAYS_NONE;
+    return;
+  }
+  if(fit >= FAILURE_FILL_TIME) {
+    report.daysToFailure = 0;
+    return;
+  }
+
+  // Fills left until the limit, converted with the observed fill rate
+  uint32_t fillsLeft = (uint32_t)((FAILURE_FILL_TIME - fit) / slope);
+  uint8_t newest = (fillHead - 1) & (PUMP_HEALTH_WINDOW - 1);
+  uint32_t span_ms = fills[newest].timestamp - fills[start].timestamp;
+  if(span_ms == 0) {
+    report.daysToFailure = PUMP_HEALTH_DAYS_NONE;
+    return;
+  }
+
+  uint64_t days = ((uint64_t)fillsLeft * span_ms) / ((uint64_t)(n - 1) * MS_PER_DAY);
+  report.daysToFailure = (days < PUMP_HEALTH_DAYS_NONE) ? (uint16_t)days
+                                                         : (PUMP_HEALTH_DAYS_NONE - 1);
+}
+
+/**
+  * @brief  Combine trend, margin, error rate and duty into a 0-100 score
+  */
+static void UpdateScore(void)
+{
+  uint32_t penalty = 0;
+
+  // Duty history
+  uint32_t dutySum = 0;
+  for(int i = 0; i < dutyCount; i++) {
+    dutySum += dutyHistory[i];
+  }
+  report.avgDutyPercent = (dutyCount > 0) ? (uint8_t)(dutySum / dutyCount) : 0;
+
+  if(report.samples >= PUMP_HEALTH_MIN_SAMPLES && report.trend_ms_per_fill > 0 &&
+     report.fitDuration_ms > 0) {
+    // Growth per fill in permille of the current fill time
+    uint32_t growth = ((uint32_t)report.trend_ms_per_fill * 1000U) / report.fitDuration_ms;
+    penalty += MIN(PENALTY_TREND_MAX, growth * 4U);
+  }
+
+  if(report.fitDuration_ms * 3U > FAILURE_FILL_TIME * 2U) {
+    uint32_t over = (report.fitDuration_ms * 3U) - (FAILURE_FILL_TIME * 2U);
+    penalty += MIN(PENALTY_MARGIN_MAX, (over * PENALTY_MARGIN_MAX) / FAILURE_FILL_TIME);
+  }
+
+  penalty += MIN(PENALTY_ERROR_MAX, report.errorsPer100);
+
+  if(report.avgDutyPercent > 50) {
+    penalty += ((report.avgDutyPercent - 50U) * PENALTY_DUTY_MAX) / 50U;
+  }
+
+  report.score = (penalty >= 100) ? 0 : (uint8_t)(100U - penalty);
+}
@@ -0,0 +1,152 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : pump_safety.c
+  * @brief          : Interrupt-level pump cutoff for Water Dispenser Control
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "pump_safety.h"
+#include "cycle_counter.h"
+#include "latency_trace.h"
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint8_t latchedSources = PUMP_CUTOFF_NONE;
+static PumpSafetyStats_t safetyStats;
+
+/* Private function prototypes -----------------------------------------------*/
+static void CutoffFromISR(uint8_t source, uint32_t entryCycles);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Initialize pump safety layer
+  * @param  None
+  * @retval None
+  */
+void PumpSafety_Init(void)
+{
+  CycleCounter_Init();
+  latchedSources = PUMP_CUTOFF_NONE;
+  safetyStats.cutoffCount = 0;
+  safetyStats.lastLatency_us = 0;
+  safetyStats.maxLatency_us = 0;
+}
+
+/**
+  * @brief  Level sensor edge handler (EXTI1 context)
+  * @param  entryCycles DWT cycle count read on ISR entry
+  * @retval None
+  */
+void PumpSafety_LevelEdgeISR(uint32_t entryCycles)
+{
+  // Both edges are routed here; only the "tank full" level cuts the pump
+  if(IS_TANK_FULL()) {
+    CutoffFromISR(PUMP_CUTOFF_LEVEL, entryCycles);
+  }
+}
+
+/**
+  * @brief  Overflow sensor edge handler (EXTI2 context)
+  * @param  entryCycles DWT cycle count read on ISR entry
+  * @retval None
+  */
+void PumpSafety_OverflowEdgeISR(uint32_t entryCycles)
+{
+  #if ENABLE_OVERFLOW_SENSOR
+  if(IS_OVERFLOW()) {
+    CutoffFromISR(PUMP_CUTOFF_OVERFLOW, entryCycles);
+  }
+  #else
+  (void)entryCycles;  // PA2 is parked and EXTI2 masked - never act on it
+  #endif
+}
+
+/**
+  * @brief  Switch pump on unless an ISR cutoff is latched
+  * @note   Runs with interrupts masked so a level edge cannot slip in
+  *         between the latch check and the GPIO write.
+  * @param  None
+  * @retval uint8_t 1 if pump was switched on, 0 if refused
+  */
+uint8_t PumpSafety_PumpOn(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint8_t allowed;
+
+  __disable_irq();
+  allowed = (latchedSources == PUMP_CUTOFF_NONE);
+  if(allowed) {
+    PUMP_ON();
+  }
+  __set_PRIMASK(primask);
+
+  return allowed;
+}
+
+/**
+  * @brief  Read and clear latched cutoff sources
+  * @param  None
+  * @retval uint8_t PUMP_CUTOFF_xxx bit mask
+  */
+uint8_t PumpSafety_TakeLatched(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint8_t sources;
+
+  __disable_irq();
+  sources = latchedSources;
+  latchedSources = PUMP_CUTOFF_NONE;
+  __set_PRIMASK(primask);
+
+  return sources;
+}
+
+/**
+  * @brief  Get ISR cutoff statistics
+  * @param  None
+  * @retval const PumpSafetyStats_t* Pointer to statistics
+  */
+const PumpSafetyStats_t* PumpSafety_GetStats(void)
+{
+  return &safetyStats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Cut pump power and latch the cause
+  * @param  source PUMP_CUTOFF_xxx source bit
+  * @param  entryCycles DWT cycle count read on ISR entry
+  * @retval None
+  */
+static void CutoffFromISR(uint8_t source, uint32_t entryCycles)
+{
+  uint8_t wasRunning = PUMP_IS_ON();
+
+  // Single BSRR/BRR store - pump is off after this line
+  PUMP_OFF_ISR();
+
+  latchedSources |= source;
+
+  if(wasRunning) {
+    // Edge -> ISR entry is fixed by the core; ISR entry -> write is measured
+    uint32_t cycles = (CycleCounter_Now() - entryCycles) + CYCLE_COUNTER_IRQ_ENTRY_CYCLES;
+    uint32_t latency_us = CycleCounter_ToMicros(cycles);
+    LatencyPath_t path = (source == PUMP_CUTOFF_OVERFLOW) ? LATENCY_PATH_OVERFLOW
+                                                          : LATENCY_PATH_TANK_FULL;
+
+    safetyStats.cutoffCount++;
+    safetyStats.lastLatency_us = latency_us;
+    if(latency_us > safetyStats.maxLatency_us) {
+      safetyStats.maxLatency_us = latency_us;
+    }
+
+    // Same edge/actuator pair in the end-to-end trace
+    LatencyTrace_MarkEdge(path, entryCycles - CYCLE_COUNTER_IRQ_ENTRY_CYCLES);
+    LatencyTrace_MarkActuator(path);
+  }
+}
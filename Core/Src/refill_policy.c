@@ -0,0 +1,201 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : refill_policy.c
+  * @brief          : Hysteresis refill policy that batches small top-ups
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "refill_policy.h"
+#include "deferred_log.h"
+
+/* Private define ------------------------------------------------------------*/
+#define LOW_PROBE_GPIO_Port       GPIOB
+#define LOW_PROBE_Pin             GPIO_PIN_0
+
+#if defined(LOW_PROBE_ACTIVE_LOW)
+  #define LOW_PROBE_WET           GPIO_PIN_RESET
+#else
+  #define LOW_PROBE_WET           GPIO_PIN_SET
+#endif
+
+#define MS_PER_HOUR               3600000UL
+#define LEARN_MIN_GAP_MS          60000UL       // Shorter gaps say little about the rate
+
+/* Private variables ---------------------------------------------------------*/
+static RefillPolicyStats_t stats;
+
+static const char* const reasonNames[REFILL_REASON_COUNT] = {
+  "none", "boot", "probe", "volume", "time"
+};
+
+#if ENABLE_REFILL_POLICY
+
+static uint32_t lastFillEnd;        // HAL tick the last fill stopped
+static uint32_t lowSince;           // HAL tick the tank was first seen low after it
+static uint8_t haveFill;            // A fill has finished since boot
+static uint8_t learnValid;          // The last fill ended at the switch (rate can be learned)
+static uint8_t waiting;             // lowSince is valid
+static uint8_t triggered;           // This refill has been counted
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t Consumed(uint32_t now);
+static uint8_t LowProbeDry(void);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Configure the low probe input, forget the fill history
+  * @param  None
+  * @retval None
+  */
+void RefillPolicy_Init(void)
+{
+  #if ENABLE_LOW_PROBE
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  __HAL_RCC_GPIOB_CLK_ENABLE();
+
+  // Float switch to ground, polled (a late edge only delays a refill)
+  GPIO_InitStruct.Pin = LOW_PROBE_Pin;
+  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
+  HAL_GPIO_Init(LOW_PROBE_GPIO_Port, &GPIO_InitStruct);
+  #endif
+
+  haveFill = 0;
+  learnValid = 0;
+  waiting = 0;
+  triggered = 0;
+}
+
+/**
+  * @brief  Whether a refill should start now
+  * @param  None
+  * @retval uint8_t 1 to refill, 0 to keep waiting
+  */
+uint8_t RefillPolicy_RefillDue(void)
+{
+  uint32_t now = HAL_GetTick();
+  uint8_t reason = REFILL_REASON_NONE;
+
+  if(!waiting) {
+    waiting = 1;
+    lowSince = now;
+  }
+
+  if(!haveFill) {
+    reason = REFILL_REASON_NO_HISTORY;
+  } else if(LowProbeDry()) {
+    reason = REFILL_REASON_LOW_PROBE;
+  } else if(Consumed(now) >= REFILL_BATCH_ML) {
+    reason = REFILL_REASON_VOLUME;
+  } else if((now - lastFillEnd) >= REFILL_MAX_DEFER_MS) {
+    reason = REFILL_REASON_TIME;
+  }
+
+  if(reason == REFILL_REASON_NONE) {
+    return 0;
+  }
+
+  if(!triggered) {
+    triggered = 1;
+    stats.lastReason = reason;
+    stats.byReason[reason]++;
+    stats.lastDefer_ms = now - lowSince;
+    if(stats.lastDefer_ms > stats.maxDefer_ms) stats.maxDefer_ms = stats.lastDefer_ms;
+    LOG_INFO("refill due (reason %u): est %u ml consumed, held back %u s",
+             reason, Consumed(now), stats.lastDefer_ms / 1000U);
+  }
+  return 1;
+}
+
+/**
+  * @brief  Record a finished fill and learn the consumption rate from it
+  * @param  volume_ml Volume pumped by the fill
+  * @param  runtime_ms Pump on time of the fill
+  * @param  full 1 if the fill ended at the level switch
+  * @retval None
+  */
+void RefillPolicy_FillDone(uint32_t volume_ml, uint32_t runtime_ms, uint8_t full)
+{
+  uint32_t now = HAL_GetTick();
+  uint32_t gap = (now - runtime_ms) - lastFillEnd;   // Previous fill end to this fill start
+
+  // Switch to switch, the fill put back what was drunk during the gap
+  if(full && learnValid && gap >= LEARN_MIN_GAP_MS) {
+    uint32_t sample = (uint32_t)(((uint64_t)volume_ml * MS_PER_HOUR) / gap);
+
+    if(stats.rate_mlh == 0 || sample > stats.rate_mlh) {
+      stats.rate_mlh = (stats.rate_mlh == 0) ? sample : (stats.rate_mlh + sample + 1U) / 2U;
+    } else {
+      stats.rate_mlh -= (stats.rate_mlh - sample) / 8U;
+    }
+  }
+
+  learnValid = full;
+  lastFillEnd = now;
+  haveFill = 1;
+  waiting = 0;
+  triggered = 0;
+}
+
+/**
+  * @brief  Reason name (for reports)
+  * @param  reason RefillReason_t
+  * @retval const char* Name string
+  */
+const char* RefillPolicy_GetReasonName(uint8_t reason)
+{
+  return (reason < REFILL_REASON_COUNT) ? reasonNames[reason] : "?";
+}
+
+/**
+  * @brief  Get refill policy statistics (refreshes the consumption estimate)
+  * @param  None
+  * @retval const RefillPolicyStats_t* Pointer to statistics
+  */
+const RefillPolicyStats_t* RefillPolicy_GetStats(void)
+{
+  stats.consumed_ml = Consumed(HAL_GetTick());
+  return &stats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Estimated volume drunk since the last fill (0 until a rate is learned)
+  */
+static uint32_t Consumed(uint32_t now)
+{
+  if(!haveFill) {
+    return 0;
+  }
+  return (uint32_t)(((uint64_t)stats.rate_mlh * (now - lastFillEnd)) / MS_PER_HOUR);
+}
+
+/**
+  * @brief  Low probe reads dry (always 0 without ENABLE_LOW_PROBE)
+  */
+static uint8_t LowProbeDry(void)
+{
+  #if ENABLE_LOW_PROBE
+  return (HAL_GPIO_ReadPin(LOW_PROBE_GPIO_Port, LOW_PROBE_Pin) != LOW_PROBE_WET) ? 1 : 0;
+  #else
+  return 0;
+  #endif
+}
+
+#else
+
+// Stubs if disabled - refill as soon as the tank reads not full
+void RefillPolicy_Init(void) {}
+uint8_t RefillPolicy_RefillDue(void) { return 1; }
+void RefillPolicy_FillDone(uint32_t volume_ml, uint32_t runtime_ms, uint8_t full) {}
+const char* RefillPolicy_GetReasonName(uint8_t reason) { return (reason < REFILL_REASON_COUNT) ? reasonNames[reason] : "?"; }
+const RefillPolicyStats_t* RefillPolicy_GetStats(void) { return &stats; }
+
+#endif // ENABLE_REFILL_POLICY
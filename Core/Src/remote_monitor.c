@@ -2,20 +2,81 @@
 #include "config.h"
 #include "state_machine.h"
 #include "battery_monitor.h"
-#include <stdio.h>
+#include "pump_safety.h"
+#include "latency_trace.h"
+#include "low_power.h"
+#include "timebase.h"
+#include "pump_health.h"
+#include "gallon_inventory.h"
+#include "flow_meter.h"
+#include "pump_current.h"
+#include "adc_sampler.h"
+#include "power_governor.h"
+#include "checkpoint.h"
+#include "warm_restart.h"
+#include "crash_dump.h"
+#include "mem_pool.h"
+#include "stack_monitor.h"
+#include "fmt.h"
+#include "deferred_log.h"
+#include "supervisor.h"
+#include "cycle_counter.h"
+#include "start_limiter.h"
+#include "refill_policy.h"
+#include "leak_detect.h"
+#include "error_recovery.h"
+#include "sensor_health.h"
+#if FMT_BENCHMARK
+#include <stdio.h>      // sprintf reference for the format benchmark only
 #include <string.h>
+#endif
 
 #if ENABLE_REMOTE_MONITOR
 
-// Assumes UART1 is initialized and handle is huart1
-extern UART_HandleTypeDef huart1;
+// USART1 on PA9 (TX) / PA10 (RX), 8N1, transmit only. Driven by register:
+// the HAL UART driver is not part of this CubeMX project.
+#define REMOTE_TX_PIN           GPIO_PIN_9
+#define REMOTE_RX_PIN           GPIO_PIN_10
+#define REMOTE_TX_TIMEOUT_MS    100U
+
+// Frames come from a static pool rather than 100-240 byte stack arrays
+typedef struct {
+  char text[REMOTE_FRAME_SIZE];
+} RemoteFrame_t;
+
+MEM_POOL_DEFINE(framePool, RemoteFrame_t, REMOTE_FRAME_COUNT);
+
+static void SendLine(FmtJson_t* json);
+static void UART_SetBaud(void);
+static void UART_Transmit(const uint8_t* data, uint16_t len);
 
 /**
-  * @brief  Initialize remote monitoring
+  * @brief  Initialize remote monitoring and USART1
   */
 void Remote_Init(void)
 {
-  // Any specific init if needed
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  MemPool_Register(&framePool);
+
+  __HAL_RCC_GPIOA_CLK_ENABLE();
+  __HAL_RCC_USART1_CLK_ENABLE();
+
+  // MX_GPIO_Init left both pins analog
+  GPIO_InitStruct.Pin = REMOTE_TX_PIN;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+  GPIO_InitStruct.Pin = REMOTE_RX_PIN;
+  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Pull = GPIO_PULLUP;
+  HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+  USART1->CR1 = 0;
+  USART1->CR2 = 0;                        // 1 stop bit
+  USART1->CR3 = 0;
+  UART_SetBaud();
+  USART1->CR1 = USART_CR1_UE | USART_CR1_TE;
 }
 
 /**
@@ -23,19 +84,502 @@ void Remote_Init(void)
   */
 void Remote_SendStatus(void)
 {
-  char buffer[128];
+  char* buffer;
+  FmtJson_t json;
   SystemState_t state = StateMachine_GetState();
-  SystemStats_t* stats = StateMachine_GetStats();
+  const GallonStatus_t* gallon = Gallon_GetStatus();
+  const FlowMeterStatus_t* flow = FlowMeter_GetStatus();
+  const PumpCurrentStatus_t* current = PumpCurrent_GetStatus();
+  SystemStats_t stats;
+
+  if(!StateMachine_GetStatsSnapshot(&stats)) {
+    return;  // Writer busy - skip this frame rather than send torn stats
+  }
+  if((buffer = MemPool_Alloc(&framePool)) == NULL) {
+    return;
+  }
   
-  // Format JSON-like string
-  // {"state":"IDLE","err":0,"cycles":123,"bat":3300}
-  sprintf(buffer, "{\"state\":\"%s\",\"err\":%d,\"cycles\":%lu,\"bat\":%d}\r\n",
-          StateMachine_GetStateName(state),
-          stats->lastErrorCode,
-          stats->pumpCycleCount,
-          Battery_GetVoltage_mV());
-          
-  HAL_UART_Transmit(&huart1, (uint8_t*)buffer, strlen(buffer), 100);
+  // {"state":"IDLE","err":0,"cycles":123,"bat":3300,"cut_us":4,"health":92,"ttf_d":41,"gal_ml":7400,"gal_low":0,"flow":1500,"vol_ml":86400,"pump_ma":640,"starts_h":3,"settle_saved":1180,"settle_avg":1020}
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonStr(&json, "state", StateMachine_GetStateName(state));
+  Fmt_JsonU32(&json, "err", stats.lastErrorCode);
+  Fmt_JsonU32(&json, "cycles", stats.pumpCycleCount);
+  Fmt_JsonU32(&json, "bat", Battery_GetVoltage_mV());
+  Fmt_JsonU32(&json, "cut_us", PumpSafety_GetStats()->maxLatency_us);
+  Fmt_JsonU32(&json, "health", stats.pumpHealthScore);
+  Fmt_JsonI32(&json, "ttf_d", PumpHealth_GetReport()->daysToFailure);
+  Fmt_JsonI32(&json, "gal_ml", gallon->known ? gallon->remaining_ml : -1L);
+  Fmt_JsonU32(&json, "gal_low", Gallon_IsLow());
+  Fmt_JsonU32(&json, "flow", flow->rate_ml_per_min);
+  Fmt_JsonU32(&json, "vol_ml", flow->total_ml);
+  Fmt_JsonU32(&json, "pump_ma", current->avg_mA);
+  Fmt_JsonU32(&json, "starts_h", StartLimiter_GetStats()->startsLastHour);
+  Fmt_JsonU32(&json, "settle_saved", stats.lastSettleSaved);
+  Fmt_JsonU32(&json, "settle_avg", stats.settleCount ? stats.totalSettleSaved / stats.settleCount : 0);
+  SendLine(&json);
+
+  MemPool_Free(&framePool, buffer);
+}
+
+/**
+  * @brief  Send sensor edge -> pump off latency histograms and sensor input health via UART
+  */
+void Remote_SendLatencyReport(void)
+{
+  char* buffer = MemPool_Alloc(&framePool);
+  FmtJson_t json;
+  LatencySummary_t summary;
+
+  if(buffer == NULL) {
+    return;
+  }
+
+  // One line per path
+  // {"lat":"door","n":12,"p50":20000,"p99":45000,"max":48211}
+  for(int path = 0; path < LATENCY_PATH_COUNT; path++) {
+    LatencyTrace_GetSummary((LatencyPath_t)path, &summary);
+    Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+    Fmt_JsonStr(&json, "lat", LatencyTrace_GetPathName((LatencyPath_t)path));
+    Fmt_JsonU32(&json, "n", summary.count);
+    Fmt_JsonU32(&json, "p50", summary.p50_us);
+    Fmt_JsonU32(&json, "p99", summary.p99_us);
+    Fmt_JsonU32(&json, "max", summary.max_us);
+    SendLine(&json);
+  }
+
+  // One line per sensor input, stuck fills and faults on the level line
+  // {"sensor":"level","score":94,"edges":412,"per_min":2,"drop":37,"bounce":3,"bounce_max":9,"window":10,"stuck":0,"faults":0}
+  const SensorHealthStats_t* health = SensorHealth_GetStats();
+  for(uint8_t i = 0; i < SENSOR_INPUT_COUNT; i++) {
+    const SensorInputStats_t* in = &health->input[i];
+    Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+    Fmt_JsonStr(&json, "sensor", SensorHealth_GetInputName(i));
+    Fmt_JsonU32(&json, "score", in->score);
+    Fmt_JsonU32(&json, "edges", in->edges);
+    Fmt_JsonU32(&json, "per_min", in->edgesLastMinute);
+    Fmt_JsonU32(&json, "drop", in->rejected);
+    Fmt_JsonU32(&json, "bounce", in->bounce_ms);
+    Fmt_JsonU32(&json, "bounce_max", in->maxBounce_ms);
+    Fmt_JsonU32(&json, "window", in->window_ms);
+    if(i == SENSOR_INPUT_LEVEL) {
+      Fmt_JsonU32(&json, "stuck", health->stuckFills);
+      Fmt_JsonU32(&json, "faults", health->faults);
+    }
+    SendLine(&json);
+  }
+  MemPool_Free(&framePool, buffer);
+}
+
+/**
+  * @brief  Send deep sleep residency, estimated current, wake latency and tick cost via UART
+  */
+void Remote_SendPowerReport(void)
+{
+  char* buffer = MemPool_Alloc(&framePool);
+  FmtJson_t json;
+  const LowPowerStats_t* lp = LowPower_GetStats();
+
+  if(buffer == NULL) {
+    return;
+  }
+
+  // {"pwr":"sleep","wakes":310,"alarm":290,"idle_ua":61,"full_ua":45,"wake_us":212,"wake_max":260}
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonStr(&json, "pwr", "sleep");
+  Fmt_JsonU32(&json, "wakes", lp->wakeCount);
+  Fmt_JsonU32(&json, "alarm", lp->alarmWakeCount);
+  Fmt_JsonU32(&json, "idle_ua", LowPower_GetEstimatedCurrent_uA(STATE_IDLE));
+  Fmt_JsonU32(&json, "full_ua", LowPower_GetEstimatedCurrent_uA(STATE_FULL));
+  Fmt_JsonU32(&json, "wake_us", lp->lastWakeToDecision_us);
+  Fmt_JsonU32(&json, "wake_max", lp->maxWakeToDecision_us);
+  SendLine(&json);
+
+  // {"tick":1000,"hal_cyc":96,"fast_cyc":34,"base_cps":96000,"cps":34000}
+  const TimebaseStats_t* tb = Timebase_GetStats();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "tick", tb->tickRateHz);
+  Fmt_JsonU32(&json, "hal_cyc", tb->halIsrCycles);
+  Fmt_JsonU32(&json, "fast_cyc", tb->fastIsrCycles);
+  Fmt_JsonU32(&json, "base_cps", tb->baselineCyclesPerSec);
+  Fmt_JsonU32(&json, "cps", tb->activeCyclesPerSec);
+  SendLine(&json);
+
+  // {"vdda":3297,"bat":3712,"t_dc":312,"adc_ovr":0}
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "vdda", AdcSampler_GetVdda_mV());
+  Fmt_JsonU32(&json, "bat", Battery_GetVoltage_mV());
+  Fmt_JsonI32(&json, "t_dc", AdcSampler_GetChipTemp_dC());
+  Fmt_JsonU32(&json, "adc_ovr", AdcSampler_GetOverruns());
+  SendLine(&json);
+
+  // {"prof":"eco","bat_f":3590,"switches":2,"refused":1,"t_norm":86400,"t_eco":3600,"t_crit":0}
+  const PowerGovStats_t* gov = PowerGov_GetStats();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonStr(&json, "prof", PowerGov_GetProfile()->name);
+  Fmt_JsonU32(&json, "bat_f", gov->filtered_mV);
+  Fmt_JsonU32(&json, "switches", gov->switchCount);
+  Fmt_JsonU32(&json, "refused", gov->refusedStarts);
+  Fmt_JsonU32(&json, "t_norm", gov->timeInProfile_s[POWER_PROFILE_NORMAL]);
+  Fmt_JsonU32(&json, "t_eco", gov->timeInProfile_s[POWER_PROFILE_ECO]);
+  Fmt_JsonU32(&json, "t_crit", gov->timeInProfile_s[POWER_PROFILE_CRITICAL]);
+  SendLine(&json);
+
+  // {"refill":"volume","rate_mlh":420,"est_ml":180,"defer_s":610,"defer_max":1200,"boot":1,"probe":0,"vol":21,"time":9}
+  const RefillPolicyStats_t* refill = RefillPolicy_GetStats();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonStr(&json, "refill", RefillPolicy_GetReasonName(refill->lastReason));
+  Fmt_JsonU32(&json, "rate_mlh", refill->rate_mlh);
+  Fmt_JsonU32(&json, "est_ml", refill->consumed_ml);
+  Fmt_JsonU32(&json, "defer_s", refill->lastDefer_ms / 1000U);
+  Fmt_JsonU32(&json, "defer_max", refill->maxDefer_ms / 1000U);
+  Fmt_JsonU32(&json, "boot", refill->byReason[REFILL_REASON_NO_HISTORY]);
+  Fmt_JsonU32(&json, "probe", refill->byReason[REFILL_REASON_LOW_PROBE]);
+  Fmt_JsonU32(&json, "vol", refill->byReason[REFILL_REASON_VOLUME]);
+  Fmt_JsonU32(&json, "time", refill->byReason[REFILL_REASON_TIME]);
+  SendLine(&json);
+
+  // {"leak_alarms":0,"drains":212,"idle":87,"quiet":9,"susp":1,"streak":0,"last_min":640,"thr_min":256,"quiet_h":9,"learn_h":0}
+  const LeakDetectStats_t* leak = LeakDetect_GetStats();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "leak_alarms", leak->alarms);
+  Fmt_JsonU32(&json, "drains", leak->drains);
+  Fmt_JsonU32(&json, "idle", leak->idleDrains);
+  Fmt_JsonU32(&json, "quiet", leak->quietDrains);
+  Fmt_JsonU32(&json, "susp", leak->suspicious);
+  Fmt_JsonU32(&json, "streak", leak->streak);
+  Fmt_JsonU32(&json, "last_min", leak->lastInterval_min);
+  Fmt_JsonU32(&json, "thr_min", leak->threshold_min);
+  Fmt_JsonU32(&json, "quiet_h", leak->quietSlots);
+  Fmt_JsonU32(&json, "learn_h", leak->learnHoursLeft);
+  SendLine(&json);
+
+  // {"ckpt":14,"restored":1,"flush_us":880,"over":0,"slots":18,"flushes":0,"skipped":0}
+  const CheckpointStatus_t* ckpt = Checkpoint_GetStatus();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "ckpt", ckpt->sequence);
+  Fmt_JsonU32(&json, "restored", ckpt->restored);
+  Fmt_JsonU32(&json, "flush_us", ckpt->lastFlush_us);
+  Fmt_JsonU32(&json, "over", ckpt->overBudget);
+  Fmt_JsonU32(&json, "slots", ckpt->freeSlots);
+  Fmt_JsonU32(&json, "flushes", ckpt->flushes);
+  Fmt_JsonU32(&json, "skipped", ckpt->skipped);
+  SendLine(&json);
+
+  // {"reset":"iwdg","warm":1}
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonStr(&json, "reset", WarmRestart_GetResetCauseName(WarmRestart_GetResetCause()));
+  Fmt_JsonU32(&json, "warm", WarmRestart_IsWarm());
+  SendLine(&json);
+
+  MemPool_Free(&framePool, buffer);
+}
+
+/**
+  * @brief  Send the newest crash record via UART (once at boot)
+  */
+void Remote_SendCrashReport(void)
+{
+  char* buffer;
+  FmtJson_t json;
+  const CrashRecord_t* crash = CrashDump_GetLast();
+
+  if(crash == NULL || (buffer = MemPool_Alloc(&framePool)) == NULL) {
+    return;
+  }
+
+  // Tools/crash_symbolize.py resolves pc/lr against the ELF
+  // {"crash":"bus","new":1,"seq":3,"pc":"0x08001a2c","lr":"0x08001a11","sp":"0x20004f60","cfsr":"0x00008200",...}
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonStr(&json, "crash", CrashDump_GetFaultName((CrashFault_t)crash->fault));
+  Fmt_JsonU32(&json, "new", CrashDump_IsNew());
+  Fmt_JsonU32(&json, "seq", crash->sequence);
+  Fmt_JsonHex32(&json, "pc", crash->pc);
+  Fmt_JsonHex32(&json, "lr", crash->lr);
+  Fmt_JsonHex32(&json, "sp", crash->sp);
+  Fmt_JsonHex32(&json, "cfsr", crash->cfsr);
+  Fmt_JsonHex32(&json, "hfsr", crash->hfsr);
+  Fmt_JsonHex32(&json, "bfar", crash->bfar);
+  Fmt_JsonHex32(&json, "mmfar", crash->mmfar);
+  Fmt_JsonStr(&json, "state", StateMachine_GetStateName((SystemState_t)crash->state));
+  Fmt_JsonU32(&json, "t_ms", crash->tick);
+  SendLine(&json);
+
+  // Last trace events before the fault, oldest first
+  // {"crash_ev":0,"type":2,"arg":1,"id":17,"cyc":123456}
+  for(uint8_t i = 0; i < crash->eventCount && i < CRASH_TRACE_EVENTS; i++) {
+    Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+    Fmt_JsonU32(&json, "crash_ev", i);
+    Fmt_JsonU32(&json, "type", crash->events[i].type);
+    Fmt_JsonU32(&json, "arg", crash->events[i].arg);
+    Fmt_JsonU32(&json, "id", crash->events[i].correlationId);
+    Fmt_JsonU32(&json, "cyc", crash->events[i].timestamp);
+    SendLine(&json);
+  }
+  MemPool_Free(&framePool, buffer);
+}
+
+/**
+  * @brief  Send pool, stack and heap high-water marks and the static RAM footprint via UART
+  */
+void Remote_SendMemoryReport(void)
+{
+  char* buffer = MemPool_Alloc(&framePool);
+  FmtJson_t json;
+  MemFootprint_t fp;
+
+  if(buffer == NULL) {
+    return;
+  }
+
+  // One line per pool, the report frame itself included
+  // {"pool":"framePool","size":240,"cap":1,"used":1,"hw":1,"fail":0}
+  for(uint8_t i = 0; i < MemPool_GetCount(); i++) {
+    const MemPool_t* pool = MemPool_Get(i);
+    Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+    Fmt_JsonStr(&json, "pool", pool->name);
+    Fmt_JsonU32(&json, "size", pool->blockSize);
+    Fmt_JsonU32(&json, "cap", pool->blockCount);
+    Fmt_JsonU32(&json, "used", pool->used);
+    Fmt_JsonU32(&json, "hw", pool->highWater);
+    Fmt_JsonU32(&json, "fail", pool->failures);
+    SendLine(&json);
+  }
+
+  // {"ram_data":120,"bss":3900,"noinit":108,"heap":0,"stack":2048,"free":14304,"pooled":240}
+  MemPool_GetFootprint(&fp);
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "ram_data", fp.data);
+  Fmt_JsonU32(&json, "bss", fp.bss);
+  Fmt_JsonU32(&json, "noinit", fp.noinit);
+  Fmt_JsonU32(&json, "heap", fp.heap);
+  Fmt_JsonU32(&json, "stack", fp.stack);
+  Fmt_JsonU32(&json, "free", fp.free);
+  Fmt_JsonU32(&json, "pooled", fp.pooled);
+  SendLine(&json);
+
+  // {"stack_hw":1320,"stack_rsv":2048,"heap_hw":0,"headroom":12800,"passes":41,"warn":0}
+  const StackMonitorStats_t* stack = StackMonitor_GetStats();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "stack_hw", stack->stackPeak);
+  Fmt_JsonU32(&json, "stack_rsv", stack->stackReserved);
+  Fmt_JsonU32(&json, "heap_hw", stack->heapPeak);
+  Fmt_JsonU32(&json, "headroom", stack->headroom);
+  Fmt_JsonU32(&json, "passes", stack->passes);
+  Fmt_JsonU32(&json, "warn", stack->warned);
+  SendLine(&json);
+
+  // {"log_wr":212,"log_drop":0,"log_hw":40,"log_cap":256}
+  const DeferredLogStats_t* log = DeferredLog_GetStats();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "log_wr", log->written);
+  Fmt_JsonU32(&json, "log_drop", log->dropped);
+  Fmt_JsonU32(&json, "log_hw", log->highWater);
+  Fmt_JsonU32(&json, "log_cap", LOG_RING_WORDS);
+  SendLine(&json);
+
+  MemPool_Free(&framePool, buffer);
+}
+
+/**
+  * @brief  Send the reset history and per-task check-in statistics via UART
+  */
+void Remote_SendSupervisorReport(void)
+{
+  char* buffer = MemPool_Alloc(&framePool);
+  const SupervisorHistory_t* h = Supervisor_GetHistory();
+  FmtJson_t json;
+
+  if(buffer == NULL) {
+    return;
+  }
+
+  // {"boots":14,"reset":"iwdg","por":1,"pin":2,"iwdg":1,"wwdg":0,"sw":10,"lp":0,"starved":2,"late":2,"ewi":0}
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "boots", h->boots);
+  Fmt_JsonStr(&json, "reset", WarmRestart_GetResetCauseName((ResetCause_t)h->lastCause));
+  Fmt_JsonU32(&json, "por", h->causeCount[RESET_CAUSE_POWER_ON]);
+  Fmt_JsonU32(&json, "pin", h->causeCount[RESET_CAUSE_PIN]);
+  Fmt_JsonU32(&json, "iwdg", h->causeCount[RESET_CAUSE_IWDG]);
+  Fmt_JsonU32(&json, "wwdg", h->causeCount[RESET_CAUSE_WWDG]);
+  Fmt_JsonU32(&json, "sw", h->causeCount[RESET_CAUSE_SOFTWARE]);
+  Fmt_JsonU32(&json, "lp", h->causeCount[RESET_CAUSE_LOW_POWER]);
+  Fmt_JsonU32(&json, "starved", h->starved);
+  Fmt_JsonU32(&json, "late", h->late);
+  Fmt_JsonU32(&json, "ewi", h->wwdgEarly);
+  SendLine(&json);
+
+  // {"task":"control","dl":200,"max":61,"miss":0}
+  for(uint8_t i = 0; i < SUP_TASK_COUNT; i++) {
+    const SupervisorTaskStats_t* t = Supervisor_GetTask((SupervisorTask_t)i);
+    Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+    Fmt_JsonStr(&json, "task", Supervisor_GetTaskName((SupervisorTask_t)i));
+    Fmt_JsonU32(&json, "dl", t->deadline_ms);
+    Fmt_JsonU32(&json, "max", t->maxGap_ms);
+    Fmt_JsonU32(&json, "miss", t->misses);
+    SendLine(&json);
+  }
+
+  // {"retries":4,"recovered":3,"exhausted":0,"retry_err":6,"retry_s":240,"timeout_used":0,...,"stall_used":1}
+  const ErrorRecoveryStats_t* rec = ErrorRecovery_GetStats();
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "retries", rec->retries);
+  Fmt_JsonU32(&json, "recovered", rec->recovered);
+  Fmt_JsonU32(&json, "exhausted", rec->exhausted);
+  Fmt_JsonU32(&json, "retry_err", rec->code);
+  Fmt_JsonU32(&json, "retry_s", rec->retryIn_ms / 1000U);
+  Fmt_JsonU32(&json, "timeout_used", rec->used[ERROR_PUMP_TIMEOUT]);
+  Fmt_JsonU32(&json, "cycling_used", rec->used[ERROR_RAPID_CYCLING]);
+  Fmt_JsonU32(&json, "empty_used", rec->used[ERROR_GALLON_EMPTY]);
+  Fmt_JsonU32(&json, "stall_used", rec->used[ERROR_PUMP_STALL]);
+  SendLine(&json);
+
+  MemPool_Free(&framePool, buffer);
+}
+
+/**
+  * @brief  Drain up to LOG_DRAIN_RECORDS deferred log records as COBS frames via UART
+  */
+void Remote_SendLog(void)
+{
+  uint8_t* buffer;
+  uint16_t len = 0;
+  uint8_t n;
+
+  if(DeferredLog_GetStats()->written == 0U || (buffer = MemPool_Alloc(&framePool)) == NULL) {
+    return;
+  }
+
+  // Frames are batched into one transmit; each is self-delimited by 0x00
+  for(uint8_t i = 0; i < LOG_DRAIN_RECORDS && len + LOG_FRAME_MAX_BYTES <= REMOTE_FRAME_SIZE; i++) {
+    if((n = DeferredLog_ReadFrame(&buffer[len])) == 0U) {
+      break;
+    }
+    len = (uint16_t)(len + n);
+  }
+
+  if(len != 0U) {
+    UART_Transmit(buffer, len);
+  }
+  MemPool_Free(&framePool, buffer);
+}
+
+#if FMT_BENCHMARK
+
+/**
+  * @brief  Time the status frame with Fmt_Json* against sprintf, send cycles per frame
+  * @note   Boot only; FMT_BENCHMARK links newlib printf back in for the comparison
+  */
+void Remote_SendFormatBenchmark(void)
+{
+  static char reference[REMOTE_FRAME_SIZE];    // Not on the main stack
+  char* buffer = MemPool_Alloc(&framePool);
+  FmtJson_t json;
+  uint32_t fmtCycles = 0;
+  uint32_t sprintfCycles = 0;
+  uint16_t len = 0;
+
+  if(buffer == NULL) {
+    return;
+  }
+
+  // The status frame of Remote_SendStatus(), every field at a typical width
+  for(uint32_t run = 0; run < FMT_BENCH_RUNS; run++) {
+    uint32_t start = CycleCounter_Now();
+    sprintf(reference, "{\"state\":\"%s\",\"err\":%d,\"cycles\":%lu,\"bat\":%d,\"cut_us\":%lu,\"health\":%d,\"ttf_d\":%d,\"gal_ml\":%ld,\"gal_low\":%d,\"flow\":%lu,\"vol_ml\":%lu,\"pump_ma\":%u,\"starts_h\":%lu,\"settle_saved\":%lu,\"settle_avg\":%lu}\r\n",
+            "FILLING", 0, 1234UL + run, 3712, 4UL, 92, 41, 7400L, 0, 1500UL, 86400UL, 640U, 3UL, 1180UL, 1020UL);
+    sprintfCycles += CycleCounter_Now() - start;
+
+    start = CycleCounter_Now();
+    Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+    Fmt_JsonStr(&json, "state", "FILLING");
+    Fmt_JsonU32(&json, "err", 0);
+    Fmt_JsonU32(&json, "cycles", 1234UL + run);
+    Fmt_JsonU32(&json, "bat", 3712);
+    Fmt_JsonU32(&json, "cut_us", 4);
+    Fmt_JsonU32(&json, "health", 92);
+    Fmt_JsonI32(&json, "ttf_d", 41);
+    Fmt_JsonI32(&json, "gal_ml", 7400);
+    Fmt_JsonU32(&json, "gal_low", 0);
+    Fmt_JsonU32(&json, "flow", 1500);
+    Fmt_JsonU32(&json, "vol_ml", 86400);
+    Fmt_JsonU32(&json, "pump_ma", 640);
+    Fmt_JsonU32(&json, "starts_h", 3);
+    Fmt_JsonU32(&json, "settle_saved", 1180);
+    Fmt_JsonU32(&json, "settle_avg", 1020);
+    len = Fmt_JsonEnd(&json);
+    fmtCycles += CycleCounter_Now() - start;
+  }
+
+  // {"fmt_bench":64,"fmt_cyc":2100,"sprintf_cyc":9800,"same":1}
+  uint8_t same = (len != 0U && strcmp(buffer, reference) == 0);
+  Fmt_JsonBegin(&json, buffer, REMOTE_FRAME_SIZE);
+  Fmt_JsonU32(&json, "fmt_bench", FMT_BENCH_RUNS);
+  Fmt_JsonU32(&json, "fmt_cyc", fmtCycles / FMT_BENCH_RUNS);
+  Fmt_JsonU32(&json, "sprintf_cyc", sprintfCycles / FMT_BENCH_RUNS);
+  Fmt_JsonU32(&json, "same", same);
+  SendLine(&json);
+
+  MemPool_Free(&framePool, buffer);
+}
+
+#else
+
+void Remote_SendFormatBenchmark(void) {}
+
+#endif // FMT_BENCHMARK
+
+/**
+  * @brief  Recompute the UART baud rate register after a core clock change
+  */
+void Remote_ClockChanged(void)
+{
+  // Let the byte in flight finish at the old rate
+  uint32_t start = HAL_GetTick();
+  while((USART1->SR & USART_SR_TC) == 0U && (HAL_GetTick() - start) < REMOTE_TX_TIMEOUT_MS) { }
+  UART_SetBaud();
+}
+
+/**
+  * @brief  Finish a line and transmit it (a line that did not fit is dropped, not truncated)
+  */
+static void SendLine(FmtJson_t* json)
+{
+  uint16_t len = Fmt_JsonEnd(json);
+
+  if(len != 0U) {
+    UART_Transmit((const uint8_t*)json->buf, len);
+  }
+}
+
+/**
+  * @brief  BRR for REMOTE_BAUD_RATE from the current PCLK2 (16x oversampling)
+  */
+static void UART_SetBaud(void)
+{
+  uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+
+  USART1->BRR = (pclk + REMOTE_BAUD_RATE / 2U) / REMOTE_BAUD_RATE;
+}
+
+/**
+  * @brief  Blocking transmit up to the last stop bit (TC), gives up
+  *         REMOTE_TX_TIMEOUT_MS after the start
+  * @note   Returning on TXE would leave the last byte in the shift register,
+  *         and a STOP entry right after it stops HSI mid-byte
+  */
+static void UART_Transmit(const uint8_t* data, uint16_t len)
+{
+  uint32_t start = HAL_GetTick();
+
+  for(uint16_t i = 0; i < len; i++) {
+    while((USART1->SR & USART_SR_TXE) == 0U) {
+      if((HAL_GetTick() - start) >= REMOTE_TX_TIMEOUT_MS) {
+        return;
+      }
+    }
+    USART1->DR = data[i];
+  }
+  while((USART1->SR & USART_SR_TC) == 0U && (HAL_GetTick() - start) < REMOTE_TX_TIMEOUT_MS) { }
 }
 
 #else
@@ -43,5 +587,13 @@ void Remote_SendStatus(void)
 // Stubs
 void Remote_Init(void) {}
 void Remote_SendStatus(void) {}
+void Remote_SendLatencyReport(void) {}
+void Remote_SendPowerReport(void) {}
+void Remote_SendCrashReport(void) {}
+void Remote_SendMemoryReport(void) {}
+void Remote_SendSupervisorReport(void) {}
+void Remote_SendLog(void) {}
+void Remote_SendFormatBenchmark(void) {}
+void Remote_ClockChanged(void) {}
 
 #endif // ENABLE_REMOTE_MONITOR
@@ -0,0 +1,300 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : sensor_health.c
+  * @brief          : Sensor input health: adaptive debounce, chatter, stuck level
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sensor_health.h"
+#include "state_machine.h"
+#include "deferred_log.h"
+
+/* Private define ------------------------------------------------------------*/
+#define MS_PER_MINUTE             60000UL
+
+/* Private macro -------------------------------------------------------------*/
+#define ENTER_CRITICAL()  uint32_t primask = __get_PRIMASK(); __disable_irq()
+#define EXIT_CRITICAL()   __set_PRIMASK(primask)
+
+/* Private variables ---------------------------------------------------------*/
+static SensorHealthStats_t stats;
+
+static const char* const inputNames[SENSOR_INPUT_COUNT] = {
+  "door", "level", "overflow"
+};
+
+#if ENABLE_SENSOR_HEALTH
+
+static volatile uint32_t lastEdge[SENSOR_INPUT_COUNT];      // Tick of the latest raw edge
+static volatile uint32_t lastAccepted[SENSOR_INPUT_COUNT];  // Tick of the latest edge outside the window
+static volatile uint32_t burstStart[SENSOR_INPUT_COUNT];    // Tick of the first edge of the open burst
+static volatile uint8_t burstOpen[SENSOR_INPUT_COUNT];      // Edges within SENSOR_DEBOUNCE_MAX_MS of each other
+static uint32_t edgesAtMinute[SENSOR_INPUT_COUNT];          // Edge count when the minute started
+static uint32_t minuteStart;
+static uint32_t fillEdges;          // Level edge count when the running fill started
+static uint8_t fillExpected;        // The running fill should move the level switch
+
+/* Private function prototypes -----------------------------------------------*/
+static void FoldBurst(SensorInput_t input, uint32_t length);
+static void Fault(SensorInput_t input);
+static uint8_t Score(SensorInput_t input);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Reset the estimates, windows at SENSOR_DEBOUNCE_INIT_MS
+  * @param  None
+  * @retval None
+  */
+void SensorHealth_Init(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  for(uint8_t i = 0; i < SENSOR_INPUT_COUNT; i++) {
+    stats.input[i].bounce_ms = SENSOR_DEBOUNCE_INIT_MS / 2U;
+    stats.input[i].window_ms = SENSOR_DEBOUNCE_INIT_MS;
+    lastEdge[i] = now - SENSOR_DEBOUNCE_MAX_MS;       // Quiet, the first edge is accepted
+    lastAccepted[i] = now - SENSOR_DEBOUNCE_MAX_MS;
+    burstOpen[i] = 0;
+    edgesAtMinute[i] = stats.input[i].edges;
+  }
+  stats.lastFaultInput = SENSOR_INPUT_COUNT;
+  minuteStart = now;
+}
+
+/**
+  * @brief  Count an EXTI edge and apply the input's debounce window (ISR context)
+  * @param  input Input the edge came from
+  * @param  now HAL tick
+  * @retval uint8_t 1 if the edge is outside the window, 0 if it is a bounce
+  */
+uint8_t SensorHealth_EdgeISR(SensorInput_t input, uint32_t now)
+{
+  SensorInputStats_t* s = &stats.input[input];
+
+  s->edges++;
+
+  // A gap longer than any bounce closes the burst before this edge
+  if(burstOpen[input] && (now - lastEdge[input]) > SENSOR_DEBOUNCE_MAX_MS) {
+    FoldBurst(input, lastEdge[input] - burstStart[input]);
+    burstOpen[input] = 0;
+  }
+  if(!burstOpen[input]) {
+    burstOpen[input] = 1;
+    burstStart[input] = now;
+  }
+  lastEdge[input] = now;
+
+  if((now - lastAccepted[input]) < s->window_ms) {
+    s->rejected++;
+    return 0;
+  }
+  lastAccepted[input] = now;
+  return 1;
+}
+
+/**
+  * @brief  Whether an input has had no edge for one debounce window
+  * @param  input Input to check
+  * @retval uint8_t 1 if quiet, 0 if it is still bouncing
+  */
+uint8_t SensorHealth_IsQuiet(SensorInput_t input)
+{
+  return ((HAL_GetTick() - lastEdge[input]) >= stats.input[input].window_ms) ? 1 : 0;
+}
+
+/**
+  * @brief  Fold finished bounce bursts, count edges per minute, raise chatter faults
+  * @param  None
+  * @retval None
+  */
+void SensorHealth_Process(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  for(uint8_t i = 0; i < SENSOR_INPUT_COUNT; i++) {
+    ENTER_CRITICAL();
+    if(burstOpen[i] && (now - lastEdge[i]) > SENSOR_DEBOUNCE_MAX_MS) {
+      FoldBurst((SensorInput_t)i, lastEdge[i] - burstStart[i]);
+      burstOpen[i] = 0;
+    }
+    EXIT_CRITICAL();
+  }
+
+  if((now - minuteStart) < MS_PER_MINUTE) {
+    return;
+  }
+  // Resynchronise after a long gap instead of counting it as several quiet minutes
+  minuteStart = ((now - minuteStart) < 2U * MS_PER_MINUTE) ? minuteStart + MS_PER_MINUTE : now;
+
+  for(uint8_t i = 0; i < SENSOR_INPUT_COUNT; i++) {
+    SensorInputStats_t* s = &stats.input[i];
+    uint32_t edges = s->edges;
+
+    s->edgesLastMinute = edges - edgesAtMinute[i];
+    edgesAtMinute[i] = edges;
+
+    #if !ENABLE_OVERFLOW_SENSOR
+    if(i == SENSOR_INPUT_OVERFLOW) {
+      continue;                         // Not fitted: EXTI2 masked, nothing to count
+    }
+    #endif
+
+    if(s->edgesLastMinute <= SENSOR_CHATTER_EDGES) {
+      s->chatterMinutes = 0;
+    } else if(++s->chatterMinutes >= SENSOR_CHATTER_MINUTES) {
+      LOG_WARN("sensor %u chatters: %u edges/min for %u min", i, s->edgesLastMinute, s->chatterMinutes);
+      s->chatterMinutes = 0;            // Raised again after as many minutes if it keeps on
+      Fault((SensorInput_t)i);
+    }
+  }
+}
+
+/**
+  * @brief  A fill started
+  * @param  waterExpected 1 if the gallon should have water for this fill
+  * @retval None
+  */
+void SensorHealth_FillStart(uint8_t waterExpected)
+{
+  fillEdges = stats.input[SENSOR_INPUT_LEVEL].edges;
+  fillExpected = waterExpected;
+}
+
+/**
+  * @brief  Whether the level switch is stuck if the running fill ends without water at the switch
+  * @param  runtime_ms Pump on time of the running fill
+  * @retval uint8_t 1 to stop the fill as a sensor fault
+  */
+uint8_t SensorHealth_LevelStuck(uint32_t runtime_ms)
+{
+  if(!fillExpected || runtime_ms < SENSOR_STUCK_MIN_RUN_MS ||
+     stats.input[SENSOR_INPUT_LEVEL].edges != fillEdges ||
+     (stats.stuckFills + 1U) < SENSOR_STUCK_FILLS) {
+    return 0;
+  }
+
+  LOG_WARN("level switch did not move in %u fills with water", stats.stuckFills + 1U);
+  stats.faults++;
+  stats.lastFaultInput = SENSOR_INPUT_LEVEL;
+  return 1;
+}
+
+/**
+  * @brief  A fill ended: update the stuck level count
+  * @param  runtime_ms Pump on time of the fill
+  * @param  complete 0 if the door cut the fill short
+  * @retval None
+  */
+void SensorHealth_FillDone(uint32_t runtime_ms, uint8_t complete)
+{
+  if(stats.input[SENSOR_INPUT_LEVEL].edges != fillEdges) {
+    stats.stuckFills = 0;
+  } else if(complete && fillExpected && runtime_ms >= SENSOR_STUCK_MIN_RUN_MS && stats.stuckFills < 255U) {
+    stats.stuckFills++;
+  }
+  fillExpected = 0;
+}
+
+/**
+  * @brief  Input name (for reports)
+  * @param  input SensorInput_t
+  * @retval const char* Name string
+  */
+const char* SensorHealth_GetInputName(uint8_t input)
+{
+  return (input < SENSOR_INPUT_COUNT) ? inputNames[input] : "?";
+}
+
+/**
+  * @brief  Get sensor health statistics (refreshes the scores)
+  * @param  None
+  * @retval const SensorHealthStats_t* Pointer to statistics
+  */
+const SensorHealthStats_t* SensorHealth_GetStats(void)
+{
+  for(uint8_t i = 0; i < SENSOR_INPUT_COUNT; i++) {
+    stats.input[i].score = Score((SensorInput_t)i);
+  }
+  return &stats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Fold a finished bounce burst into the estimate and window (IRQs masked or ISR)
+  */
+static void FoldBurst(SensorInput_t input, uint32_t length)
+{
+  SensorInputStats_t* s = &stats.input[input];
+  uint32_t window;
+
+  if(length > SENSOR_DEBOUNCE_MAX_MS) length = SENSOR_DEBOUNCE_MAX_MS;
+  if(length > s->maxBounce_ms) s->maxBounce_ms = (uint16_t)length;
+
+  // Rises quickly, decays slowly: one long bounce is enough to widen the window
+  if(length > s->bounce_ms) {
+    s->bounce_ms = (uint16_t)((s->bounce_ms + length + 1U) / 2U);
+  } else {
+    s->bounce_ms = (uint16_t)(s->bounce_ms - (s->bounce_ms - length) / 8U);
+  }
+
+  window = 2U * s->bounce_ms;
+  if(window < SENSOR_DEBOUNCE_MIN_MS) window = SENSOR_DEBOUNCE_MIN_MS;
+  if(window > SENSOR_DEBOUNCE_MAX_MS) window = SENSOR_DEBOUNCE_MAX_MS;
+  s->window_ms = (uint16_t)window;
+}
+
+/**
+  * @brief  Count a sensor fault and latch ERROR_SENSOR_FAULT
+  */
+static void Fault(SensorInput_t input)
+{
+  stats.faults++;
+  stats.lastFaultInput = input;
+  StateMachine_RaiseError(ERROR_SENSOR_FAULT);
+}
+
+/**
+  * @brief  100 minus penalties for chatter (up to 40), bounce (up to 30) and missed level fills (up to 30)
+  */
+static uint8_t Score(SensorInput_t input)
+{
+  const SensorInputStats_t* s = &stats.input[input];
+  uint32_t chatter = (s->edgesLastMinute * 40U) / SENSOR_CHATTER_EDGES;
+  uint32_t bounce = ((uint32_t)s->bounce_ms * 30U) / SENSOR_DEBOUNCE_MAX_MS;
+  uint32_t stuck = 0;
+
+  if(input == SENSOR_INPUT_LEVEL) {
+    stuck = ((uint32_t)stats.stuckFills * 30U) / SENSOR_STUCK_FILLS;
+  }
+  if(chatter > 40U) chatter = 40U;
+  if(stuck > 30U) stuck = 30U;
+  return (uint8_t)(100U - chatter - bounce - stuck);
+}
+
+#else
+
+static uint32_t lastAccepted[SENSOR_INPUT_COUNT];
+
+// Stubs if disabled - fixed SENSOR_DEBOUNCE_INIT_MS window on EXTI edges, nothing monitored
+void SensorHealth_Init(void) { stats.lastFaultInput = SENSOR_INPUT_COUNT; }
+uint8_t SensorHealth_EdgeISR(SensorInput_t input, uint32_t now)
+{
+  if((now - lastAccepted[input]) < SENSOR_DEBOUNCE_INIT_MS) return 0;
+  lastAccepted[input] = now;
+  return 1;
+}
+uint8_t SensorHealth_IsQuiet(SensorInput_t input) { return 1; }
+void SensorHealth_Process(void) {}
+void SensorHealth_FillStart(uint8_t waterExpected) {}
+uint8_t SensorHealth_LevelStuck(uint32_t runtime_ms) { return 0; }
+void SensorHealth_FillDone(uint32_t runtime_ms, uint8_t complete) {}
+const char* SensorHealth_GetInputName(uint8_t input) { return (input < SENSOR_INPUT_COUNT) ? inputNames[input] : "?"; }
+const SensorHealthStats_t* SensorHealth_GetStats(void) { return &stats; }
+
+#endif // ENABLE_SENSOR_HEALTH
@@ -10,10 +10,14 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "sensors.h"
+#include "sensor_health.h"
 
 /* Private typedef -----------------------------------------------------------*/
 
 /* Private define ------------------------------------------------------------*/
+#define SELFTEST_SAMPLES        10      // Reads per input during the self-test
+#define SELFTEST_SAMPLE_MS      5       // Time between self-test reads
+#define SELFTEST_MAX_CHANGES    2       // More changes in 50 ms: chattering or floating input
 
 /* Private macro -------------------------------------------------------------*/
 
@@ -31,9 +35,8 @@
 void Sensors_Init(void)
 {
   // Sensor GPIOs are already initialized by MX_GPIO_Init()
-  // This function reserved for future sensor initialization if needed
+  SensorHealth_Init();
 
-  // Could add initial sensor check here
   HAL_Delay(100);  // Allow sensors to stabilize after power-on
 }
 
@@ -44,7 +47,8 @@ void Sensors_Init(void)
   */
 uint8_t Sensors_IsDoorClosed(void)
 {
-  return IS_DOOR_CLOSED();
+  // Open is reported at once, closed only after the switch stopped bouncing
+  return (IS_DOOR_CLOSED() && SensorHealth_IsQuiet(SENSOR_INPUT_DOOR)) ? 1 : 0;
 }
 
 /**
@@ -77,9 +81,15 @@ uint8_t Sensors_IsTankFull(void)
   return IS_TANK_FULL();
 }
 
+/**
+  * @brief  Read water level sensor - tank empty (debounced)
+  * @param  None
+  * @retval uint8_t 1 if tank empty, 0 if not empty
+  */
 uint8_t Sensors_IsTankEmpty(void)
 {
-  return IS_TANK_EMPTY();
+  // Full is reported at once, empty only after the switch stopped bouncing
+  return (IS_TANK_EMPTY() && SensorHealth_IsQuiet(SENSOR_INPUT_LEVEL)) ? 1 : 0;
 }
 
 /**
@@ -138,23 +148,33 @@ GPIO_PinState Sensors_DebouncedRead(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
 }
 
 /**
-  * @brief  Test all sensors (for diagnostics)
+  * @brief  Test door and level inputs for chatter over 50 ms (for diagnostics)
   * @param  None
   * @retval uint8_t Test result: 0 = all OK, non-zero = error code
   */
 uint8_t Sensors_SelfTest(void)
 {
   uint8_t errorCode = 0;
+  uint8_t doorChanges = 0;
+  uint8_t waterChanges = 0;
+  GPIO_PinState door = HAL_GPIO_ReadPin(DOOR_SW_GPIO_Port, DOOR_SW_Pin);
+  GPIO_PinState water = HAL_GPIO_ReadPin(WATER_LIMIT_GPIO_Port, WATER_LIMIT_Pin);
+
+  // A switch at rest does not change; a door opened once changes once
+  for(uint8_t i = 0; i < SELFTEST_SAMPLES; i++) {
+    HAL_Delay(SELFTEST_SAMPLE_MS);
+    GPIO_PinState doorNow = HAL_GPIO_ReadPin(DOOR_SW_GPIO_Port, DOOR_SW_Pin);
+    GPIO_PinState waterNow = HAL_GPIO_ReadPin(WATER_LIMIT_GPIO_Port, WATER_LIMIT_Pin);
+    if(doorNow != door) doorChanges++;
+    if(waterNow != water) waterChanges++;
+    door = doorNow;
+    water = waterNow;
+  }
 
-  // Test door switch
-  GPIO_PinState doorState = HAL_GPIO_ReadPin(DOOR_SW_GPIO_Port, DOOR_SW_Pin);
-  if(doorState != GPIO_PIN_RESET && doorState != GPIO_PIN_SET) {
+  if(doorChanges > SELFTEST_MAX_CHANGES) {
     errorCode |= 0x01;  // Door sensor error
   }
-
-  // Test water level sensor
-  GPIO_PinState waterState = HAL_GPIO_ReadPin(WATER_LIMIT_GPIO_Port, WATER_LIMIT_Pin);
-  if(waterState != GPIO_PIN_RESET && waterState != GPIO_PIN_SET) {
+  if(waterChanges > SELFTEST_MAX_CHANGES) {
     errorCode |= 0x02;  // Water sensor error
   }
 
@@ -0,0 +1,121 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : stack_monitor.c
+  * @brief          : Stack painting high-water mark and early overflow warning
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stack_monitor.h"
+#include "state_machine.h"
+#include "deferred_log.h"
+
+/* Private variables ---------------------------------------------------------*/
+static StackMonitorStats_t stats;
+
+#if ENABLE_STACK_MONITOR
+
+static const uint32_t* lowWater;    // Lowest overwritten word found so far
+static const uint32_t* cursor;      // Next word to check in the current pass
+
+// Linker script symbols and the heap top from sysmem.c
+extern uint32_t _end, _estack;
+extern uint8_t _Min_Stack_Size;
+extern uint8_t* _sbrk_heap_top(void);
+
+/* Private function prototypes -----------------------------------------------*/
+static const uint32_t* ScanFloor(void);
+static void EndPass(const uint32_t* floor);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Start the incremental scan over the painted region
+  * @param  None
+  * @retval None
+  */
+void StackMonitor_Init(void)
+{
+  stats.stackReserved = (uint32_t)&_Min_Stack_Size;   // Absolute symbol: its address is the value
+  lowWater = &_estack;
+  cursor = ScanFloor();
+}
+
+/**
+  * @brief  Scan the next STACK_SCAN_WORDS words, raise the early warning (main loop)
+  * @param  None
+  * @retval None
+  */
+void StackMonitor_Process(void)
+{
+  const uint32_t* floor = ScanFloor();
+
+  if(cursor < floor) {
+    cursor = floor;
+  }
+
+  // The first overwritten word from the bottom is the deepest the stack has been
+  for(uint32_t n = 0; n < STACK_SCAN_WORDS && cursor < lowWater; n++, cursor++) {
+    if(*cursor != STACK_PAINT_PATTERN) {
+      lowWater = cursor;
+      break;
+    }
+  }
+
+  if(cursor >= lowWater) {
+    EndPass(floor);
+  }
+}
+
+/**
+  * @brief  Get stack and heap peaks
+  * @param  None
+  * @retval const StackMonitorStats_t* Pointer to statistics
+  */
+const StackMonitorStats_t* StackMonitor_GetStats(void)
+{
+  return &stats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Lowest painted word still owned by the stack (above the heap top)
+  */
+static const uint32_t* ScanFloor(void)
+{
+  uint32_t top = ((uint32_t)_sbrk_heap_top() + 3U) & ~3U;
+  return (const uint32_t*)top;
+}
+
+/**
+  * @brief  Publish the pass result and check the early-warning threshold
+  */
+static void EndPass(const uint32_t* floor)
+{
+  stats.stackPeak = (uint32_t)((const uint8_t*)&_estack - (const uint8_t*)lowWater);
+  stats.heapPeak = (uint32_t)((const uint8_t*)floor - (const uint8_t*)&_end);
+  stats.headroom = (lowWater > floor) ? (uint32_t)((const uint8_t*)lowWater - (const uint8_t*)floor) : 0U;
+  stats.passes++;
+
+  // Once per boot: the peak never shrinks, and clearing the error must not re-raise it
+  if(!stats.warned && stats.headroom < STACK_WARN_HEADROOM) {
+    stats.warned = 1;
+    LOG_WARN("stack headroom %u bytes, peak %u", stats.headroom, stats.stackPeak);
+    StateMachine_RaiseError(ERROR_STACK_LOW);
+  }
+
+  cursor = floor;
+}
+
+#else
+
+// Stubs if disabled - the stack is still painted at boot, just never scanned
+void StackMonitor_Init(void) {}
+void StackMonitor_Process(void) {}
+const StackMonitorStats_t* StackMonitor_GetStats(void) { return &stats; }
+
+#endif // ENABLE_STACK_MONITOR
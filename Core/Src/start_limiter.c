@@ -0,0 +1,180 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : start_limiter.c
+  * @brief          : Token-bucket pump start limiter and start history
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "start_limiter.h"
+#include "warm_restart.h"
+#include "deferred_log.h"
+
+/* Private define ------------------------------------------------------------*/
+#define MS_PER_HOUR               3600000UL
+
+// One token is MS_PER_HOUR units, so the bucket gains START_REFILL_PER_HOUR
+// units per millisecond and refills exactly, without a fractional remainder
+#define TOKEN                     MS_PER_HOUR
+#define BUCKET_CAPACITY           ((uint32_t)START_BURST * TOKEN)
+
+_Static_assert(START_BURST >= 1 && START_REFILL_PER_HOUR >= 1, "START_BURST and START_REFILL_PER_HOUR must be at least 1");
+_Static_assert((uint64_t)START_BURST * MS_PER_HOUR <= UINT32_MAX, "START_BURST too large for the token counter");
+_Static_assert(START_HISTORY >= START_BURST + START_REFILL_PER_HOUR, "START_HISTORY must cover the most starts one hour allows");
+
+/* Private variables ---------------------------------------------------------*/
+static StartLimiterStats_t stats;
+
+#if ENABLE_RAPID_CYCLE_CHECK
+
+static uint32_t level;                      // Token units in the bucket
+static uint32_t lastRefill;                 // Tick the level was last brought up to date
+static uint32_t history[START_HISTORY];     // Start ticks, oldest overwritten first
+static uint8_t historyHead;                 // Next slot to write
+static uint8_t historyCount;                // Valid entries (up to START_HISTORY)
+static uint8_t inHour;                      // Newest entries still within the last hour
+
+/* Private function prototypes -----------------------------------------------*/
+static void Refill(uint32_t now);
+static void Expire(uint32_t now);
+static uint32_t Slot(uint8_t age);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Fill the bucket (one token after a warm restart), clear the history
+  * @param  None
+  * @retval None
+  */
+void StartLimiter_Init(void)
+{
+  level = WarmRestart_IsWarm() ? TOKEN : BUCKET_CAPACITY;
+  lastRefill = HAL_GetTick();
+  historyHead = 0;
+  historyCount = 0;
+  inHour = 0;
+}
+
+/**
+  * @brief  Whether the bucket has a token for one more pump start
+  * @param  None
+  * @retval uint8_t 1 if a start is allowed, 0 if the pump is cycling too often
+  */
+uint8_t StartLimiter_StartAllowed(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  Refill(now);
+  if(level >= TOKEN) {
+    return 1;
+  }
+
+  Expire(now);
+  stats.refused++;
+  LOG_WARN("pump start refused: %u starts in the last hour, last gap %u ms, next token in %u s",
+           inHour, stats.lastInterval_ms, (TOKEN - level) / START_REFILL_PER_HOUR / 1000U);
+  return 0;
+}
+
+/**
+  * @brief  Take a token and record the start in the history
+  * @param  None
+  * @retval None
+  */
+void StartLimiter_NoteStart(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  Refill(now);
+  level = (level >= TOKEN) ? level - TOKEN : 0;
+
+  if(historyCount > 0) {
+    stats.lastInterval_ms = now - Slot(0);
+    if(stats.minInterval_ms == 0 || stats.lastInterval_ms < stats.minInterval_ms) {
+      stats.minInterval_ms = stats.lastInterval_ms;
+    }
+  }
+
+  Expire(now);
+  history[historyHead] = now;
+  historyHead = (uint8_t)((historyHead + 1U) % START_HISTORY);
+  if(historyCount < START_HISTORY) historyCount++;
+  if(inHour < START_HISTORY) inHour++;    // Full ring: the overwritten entry was in the hour too
+  stats.starts++;
+}
+
+/**
+  * @brief  Tick of a recent pump start
+  * @param  age 0 = latest start, 1 = the one before, ...
+  * @retval uint32_t HAL tick, 0 if the history does not go back that far
+  */
+uint32_t StartLimiter_GetStart(uint8_t age)
+{
+  return (age < historyCount) ? Slot(age) : 0;
+}
+
+/**
+  * @brief  Get start limiter statistics (refreshes tokens and the hourly count)
+  * @param  None
+  * @retval const StartLimiterStats_t* Pointer to statistics
+  */
+const StartLimiterStats_t* StartLimiter_GetStats(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  Refill(now);
+  Expire(now);
+  stats.startsLastHour = inHour;
+  stats.tokens_x100 = level / (TOKEN / 100U);
+  return &stats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Add the tokens earned since the last refill, up to the burst size
+  */
+static void Refill(uint32_t now)
+{
+  uint32_t elapsed = now - lastRefill;
+  uint32_t room = BUCKET_CAPACITY - level;
+
+  lastRefill = now;
+  if(elapsed > room / START_REFILL_PER_HOUR) {
+    level = BUCKET_CAPACITY;
+  } else {
+    level += elapsed * START_REFILL_PER_HOUR;
+  }
+}
+
+/**
+  * @brief  Drop entries older than an hour from the hourly count, oldest first
+  */
+static void Expire(uint32_t now)
+{
+  while(inHour > 0 && (now - Slot(inHour - 1U)) >= MS_PER_HOUR) {
+    inHour--;
+  }
+}
+
+/**
+  * @brief  Ring entry by age (0 = latest)
+  */
+static uint32_t Slot(uint8_t age)
+{
+  return history[(historyHead + START_HISTORY - 1U - age) % START_HISTORY];
+}
+
+#else
+
+// Stubs if disabled - every start allowed, nothing recorded
+void StartLimiter_Init(void) {}
+uint8_t StartLimiter_StartAllowed(void) { return 1; }
+void StartLimiter_NoteStart(void) {}
+uint32_t StartLimiter_GetStart(uint8_t age) { return 0; }
+const StartLimiterStats_t* StartLimiter_GetStats(void) { return &stats; }
+
+#endif // ENABLE_RAPID_CYCLE_CHECK
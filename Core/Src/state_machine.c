@@ -12,16 +12,39 @@
 #include "state_machine.h"
 #include "sensors.h"
 #include "error_log.h"
+#include "pump_safety.h"
+#include "latency_trace.h"
+#include "seqlock.h"
+#include "pump_health.h"
+#include "gallon_inventory.h"
+#include "flow_meter.h"
+#include "usage_stats.h"
+#include "pump_current.h"
+#include "power_governor.h"
+#include "start_limiter.h"
+#include "refill_policy.h"
+#include "error_recovery.h"
+#include "sensor_health.h"
+#include "leak_detect.h"
+#include "warm_restart.h"
+#include "deferred_log.h"
 
 /* Private typedef -----------------------------------------------------------*/
 
 /* Private define ------------------------------------------------------------*/
 
 /* Private macro -------------------------------------------------------------*/
+// Every write to sm.stats goes between these so readers get consistent copies
+#define STATS_WRITE_BEGIN()   SeqLock_WriteBegin(&statsLock)
+#define STATS_WRITE_END()     SeqLock_WriteEnd(&statsLock)
 
 /* Private variables ---------------------------------------------------------*/
 static StateMachine_t sm;  // State machine context
+static SeqLock_t statsLock;  // Guards sm.stats for StateMachine_GetStatsSnapshot()
 static uint32_t pumpOnTimeWindow = 0;
+static uint8_t settleLevel;          // Level at the previous settle sample (1 = full)
+static uint8_t settleStable;         // Consecutive settle samples with that level
+static uint32_t settleSampleTime;    // Tick of the previous settle sample
 static uint32_t windowStartTime = 0;
 
 /* Exported functions --------------------------------------------------------*/
@@ -38,9 +61,19 @@ void StateMachine_Init(void)
   sm.stateChangeTime = 0;
   sm.pumpStartTime = 0;
   sm.errorCode = ERROR_NONE;
+  STATS_WRITE_BEGIN();
   sm.stats.pumpCycleCount = 0;
   sm.stats.totalPumpRunTime = 0;
   sm.stats.errorCount = 0;
+  sm.stats.pumpHealthScore = 100;
+  STATS_WRITE_END();
+  PumpHealth_Init();
+  StartLimiter_Init();
+  RefillPolicy_Init();
+  LeakDetect_Init();
+  ErrorRecovery_Init();
+  Gallon_Init();
+  UsageStats_Init();
   
   // Initial LED state
   StateMachine_UpdateLEDs();
@@ -84,7 +117,8 @@ void StateMachine_UpdateLEDs(void)
   switch(sm.currentState) {
     case STATE_IDLE:
       PROGRAM_LED_ON();
-      STATUS_LED_OFF();
+      // Gallon low: slow 2 s blink (slow enough for deep sleep wakes)
+      if(Gallon_IsLow() && (currentTime / GALLON_LOW_BLINK_MS) % 2) STATUS_LED_ON(); else STATUS_LED_OFF();
       break;
       
     case STATE_DOOR_OPEN:
@@ -107,7 +141,8 @@ void StateMachine_UpdateLEDs(void)
       
     case STATE_FULL:
       PROGRAM_LED_ON();
-      STATUS_LED_ON();
+      // Gallon low: slow 2 s blink instead of steady on
+      if(Gallon_IsLow() && (currentTime / GALLON_LOW_BLINK_MS) % 2) STATUS_LED_OFF(); else STATUS_LED_ON();
       break;
       
     case STATE_ERROR:
@@ -131,9 +166,17 @@ void StateMachine_UpdateLEDs(void)
 
 /* Private function prototypes -----------------------------------------------*/
 static void EnterState(SystemState_t newState);
+static void SaveWarmContext(void);
 static uint8_t CheckSafetyConditions(void);
 static uint8_t CheckPumpDutyCycle(void);
-static void UpdatePumpStatistics(uint32_t runtime);
+static void UpdatePumpStatistics(uint32_t runtime, PumpCycleOutcome_t outcome);
+static void RecordPumpCycle(uint32_t runtime, PumpCycleOutcome_t outcome);
+static void StopGallonEmpty(uint32_t currentTime, uint32_t pumpRunTime, uint8_t cutByEstimate);
+static void StopPumpError(uint32_t currentTime, uint32_t pumpRunTime, uint8_t errorCode);
+static uint8_t CurrentDutyPercent(void);
+static uint8_t StartPump(uint32_t currentTime);
+static void ReconcileISRCutoff(void);
+static uint8_t SettleDone(uint32_t currentTime, uint32_t timeInState);
 
 // Handlers
 static void HandleIdleState(void);
@@ -160,14 +203,29 @@ void StateMachine_Process(void)
   // Global safety check removed to prevent blocking state handlers.
   // Safety is handled by individual state handlers and the Critical Safety Override below.
 
+  // ISR CUTOFF RECONCILIATION
+  // The level/overflow EXTI may already have switched the pump off.
+  // Bring the state machine in line with what the hardware is doing.
+  ReconcileISRCutoff();
+
   // CRITICAL SAFETY OVERRIDE
   // Priority 1: Prevent Overflow
   // If tank is full, FORCE PUMP OFF immediately, regardless of state.
   if(Sensors_IsTankFull()) {
      PUMP_OFF();
+     LatencyTrace_MarkActuator(LATENCY_PATH_TANK_FULL);
      
-     // If we were filling, transition state to record it properly
+     // If we were filling, close the cycle like the tank-full branch of
+     // HandleFillingState(). An ISR cutoff latched since the reconcile above
+     // is applied first, so an overflow is not lost once we leave FILLING.
+     if(sm.currentState == STATE_FILLING) {
+         ReconcileISRCutoff();
+     }
      if(sm.currentState == STATE_FILLING) {
+         uint32_t currentTime = HAL_GetTick();
+
+         sm.pumpStopTime = currentTime;
+         UpdatePumpStatistics(currentTime - sm.pumpStartTime, PUMP_CYCLE_FULL);
          EnterState(STATE_FULL);
      }
   }
@@ -213,6 +271,87 @@ SystemStats_t* StateMachine_GetStats(void)
   return &sm.stats;
 }
 
+/**
+  * @brief  Copy system statistics without tearing
+  * @param  out Destination for the snapshot
+  * @retval uint8_t 1 if out holds a consistent copy, 0 if the writer stayed
+  *         busy for every attempt (caller preempted it)
+  */
+uint8_t StateMachine_GetStatsSnapshot(SystemStats_t* out)
+{
+  for(int attempt = 0; attempt < SEQLOCK_READ_RETRIES; attempt++) {
+    uint32_t start = SeqLock_ReadBegin(&statsLock);
+    *out = sm.stats;
+    if(!SeqLock_ReadRetry(&statsLock, start)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+  * @brief  Carry lifetime counters over from a power-fail checkpoint
+  * @param  saved Counters from the last checkpoint (cycles, runtime, errors)
+  * @retval None
+  */
+void StateMachine_RestoreStats(const SystemStats_t* saved)
+{
+  STATS_WRITE_BEGIN();
+  sm.stats.pumpCycleCount = saved->pumpCycleCount;
+  sm.stats.totalPumpRunTime = saved->totalPumpRunTime;
+  sm.stats.errorCount = saved->errorCount;
+  sm.stats.lastErrorCode = saved->lastErrorCode;
+  STATS_WRITE_END();
+}
+
+/**
+  * @brief  Resume the context saved before a watchdog or software reset
+  * @param  None
+  * @retval uint8_t 1 if resumed (warm restart), 0 on a cold start
+  */
+uint8_t StateMachine_Resume(void)
+{
+  WarmContext_t ctx;
+  uint32_t currentTime = HAL_GetTick();
+
+  if(!WarmRestart_Load(&ctx)) {
+    return 0;
+  }
+
+  // Backup registers are newer than the flash checkpoint
+  STATS_WRITE_BEGIN();
+  sm.stats.pumpCycleCount = ctx.pumpCycleCount;
+  sm.stats.totalPumpRunTime = ctx.totalPumpRunTime;
+  if(sm.stats.errorCount < ctx.errorCount) sm.stats.errorCount = ctx.errorCount;
+  sm.stats.lastErrorCode = ctx.lastErrorCode;
+  STATS_WRITE_END();
+
+  // Pump hold-off continues where it stopped (tick restarted from zero)
+  if(ctx.holdoff_ms > 0) {
+    uint32_t holdoff = (ctx.holdoff_ms > MIN_PUMP_INTERVAL) ? MIN_PUMP_INTERVAL : ctx.holdoff_ms;
+    sm.pumpStopTime = currentTime - (MIN_PUMP_INTERVAL - holdoff);
+    if(sm.pumpStopTime == 0) sm.pumpStopTime = 1;
+  }
+
+  // Protective states are resumed; anything else re-decides from IDLE
+  // (a fill cut short by the reset never restarts the pump directly)
+  if(ctx.state == STATE_ERROR) {
+    sm.errorCode = ctx.errorCode;
+    sm.currentState = STATE_ERROR;
+    ErrorRecovery_ErrorLatched(sm.errorCode);   // Backoff restarts, the retry budget was lost
+  } else if(ctx.state == STATE_COOLDOWN) {
+    sm.currentState = STATE_COOLDOWN;
+  } else {
+    sm.currentState = STATE_IDLE;
+  }
+  sm.previousState = sm.currentState;
+  sm.stateChangeTime = (sm.currentState == STATE_COOLDOWN) ? sm.pumpStopTime : currentTime;
+  LOG_WARN("warm resume into state %u (saved %u), hold-off %u ms", sm.currentState, ctx.state, ctx.holdoff_ms);
+  SaveWarmContext();
+  StateMachine_UpdateLEDs();
+  return 1;
+}
+
 /**
   * @brief  Force reset error state
   * @param  None
@@ -221,11 +360,43 @@ SystemStats_t* StateMachine_GetStats(void)
 void StateMachine_ResetError(void)
 {
   sm.errorCode = ERROR_NONE;
+  ErrorRecovery_ManualReset();
+  STATS_WRITE_BEGIN();
   sm.stats.pumpCycleCount = 0;
   sm.stats.totalPumpRunTime = 0;
+  STATS_WRITE_END();
   EnterState(STATE_IDLE);
 }
 
+/**
+  * @brief  Latch an error detected outside the state handlers (pump off, ERROR state)
+  * @param  errorCode Error to latch
+  * @retval None
+  * @note   Main loop context only; ignored if an error is already latched
+  */
+void StateMachine_RaiseError(uint8_t errorCode)
+{
+  uint32_t currentTime = HAL_GetTick();
+
+  if(sm.currentState == STATE_ERROR) {
+    return;
+  }
+
+  // A running fill is closed out like any other error stop
+  if(sm.currentState == STATE_FILLING) {
+    StopPumpError(currentTime, currentTime - sm.pumpStartTime, errorCode);
+    return;
+  }
+
+  PUMP_OFF();
+  sm.errorCode = errorCode;
+  STATS_WRITE_BEGIN();
+  sm.stats.errorCount++;
+  sm.stats.lastErrorCode = errorCode;
+  STATS_WRITE_END();
+  EnterState(STATE_ERROR);
+}
+
 /**
   * @brief  Get state name string (for debugging)
   * @param  state State to get name for
@@ -255,16 +426,63 @@ const char* StateMachine_GetStateName(SystemState_t state)
   */
 static void EnterState(SystemState_t newState)
 {
+  uint32_t currentTime = HAL_GetTick();
+
+  // A long door-open episode may be a gallon swap
+  if(sm.currentState == STATE_DOOR_OPEN && newState != STATE_DOOR_OPEN) {
+    Gallon_DoorEpisode(currentTime - sm.stateChangeTime);
+    LeakDetect_DoorActivity();
+  }
+
   sm.previousState = sm.currentState;
   sm.currentState = newState;
-  sm.stateChangeTime = HAL_GetTick();
+  sm.stateChangeTime = currentTime;
   sm.ledBlinkState = 0;
   sm.lastBlinkTime = sm.stateChangeTime;
+  LatencyTrace_MarkState((uint8_t)newState);
+  LOG_INFO("state %u -> %u", sm.previousState, newState);
+
+  // Settle starts counting stable level samples from scratch
+  if(newState == STATE_WAIT_SETTLE) {
+    settleStable = 0;
+    settleSampleTime = currentTime - SETTLE_SAMPLE_MS;
+  }
   
   // Log error if entering error state (Task 7)
   if(newState == STATE_ERROR) {
-    ErrorLog_Add(sm.errorCode, sm.previousState, sm.stats.pumpCycleCount);
+    ErrorRecovery_ErrorLatched(sm.errorCode);
+    ErrorLog_Add(sm.errorCode, sm.previousState, sm.stats.pumpCycleCount, ErrorRecovery_GetRetries(sm.errorCode));
+    LOG_ERROR("error %u in state %u, cycle %u", sm.errorCode, sm.previousState, sm.stats.pumpCycleCount);
   }
+
+  SaveWarmContext();
+}
+
+/**
+  * @brief  Keep the context in the backup registers for a warm restart
+  * @retval None
+  */
+static void SaveWarmContext(void)
+{
+  WarmContext_t ctx;
+  uint32_t sinceStop = sm.stateChangeTime - sm.pumpStopTime;
+
+  ctx.state = sm.currentState;
+  ctx.errorCode = sm.errorCode;
+  ctx.lastErrorCode = sm.stats.lastErrorCode;
+  ctx.pumpCycleCount = sm.stats.pumpCycleCount;
+  ctx.totalPumpRunTime = sm.stats.totalPumpRunTime;
+  ctx.errorCount = (sm.stats.errorCount > 0xFFFFU) ? 0xFFFFU : (uint16_t)sm.stats.errorCount;
+
+  // Remaining pump hold-off as of this state change (a reset later only errs long)
+  ctx.holdoff_ms = 0;
+  if(sm.currentState == STATE_COOLDOWN || sm.currentState == STATE_FILLING) {
+    ctx.holdoff_ms = MIN_PUMP_INTERVAL;
+  } else if(sm.pumpStopTime > 0 && sinceStop < MIN_PUMP_INTERVAL) {
+    ctx.holdoff_ms = MIN_PUMP_INTERVAL - sinceStop;
+  }
+
+  WarmRestart_Save(&ctx);
 }
 
 /**
@@ -289,16 +507,11 @@ static uint8_t CheckSafetyConditions(void)
   }
   #endif
 
-  // Check for rapid cycling (potential sensor fault)
-  #if ENABLE_RAPID_CYCLE_CHECK
-  if(sm.stats.pumpCycleCount > MAX_RAPID_CYCLES) {
-    uint32_t avgCycleTime = sm.stats.totalPumpRunTime / sm.stats.pumpCycleCount;
-    if(avgCycleTime < MIN_AVG_CYCLE_TIME) {
-      sm.errorCode = ERROR_RAPID_CYCLING;
-      return 0;
-    }
+  // Check for rapid cycling (potential sensor fault): start bucket empty
+  if(!StartLimiter_StartAllowed()) {
+    StateMachine_RaiseError(ERROR_RAPID_CYCLING);
+    return 0;
   }
-  #endif
 
   return 1;
 }
@@ -317,16 +530,16 @@ static void HandleIdleState(void)
     return;
   }
 
-  // Check if tank needs refilling
+  // Check if tank needs refilling (batched by the refill policy, within the
+  // power profile's start budget)
   if(Sensors_IsTankEmpty()) {
-    if(CheckSafetyConditions()) {
+    if(RefillPolicy_RefillDue() && CheckSafetyConditions() && PowerGov_PumpStartAllowed()) {
       #if ENABLE_STARTUP_DELAY
       EnterState(STATE_WAIT_SETTLE);
       #else
-      EnterState(STATE_FILLING);
-      PUMP_ON();
-      sm.pumpStartTime = HAL_GetTick();
-      sm.stats.pumpCycleCount++;
+      if(StartPump(HAL_GetTick())) {
+        EnterState(STATE_FILLING);
+      }
       #endif
     }
   } else if(Sensors_IsTankFull()) {
@@ -373,19 +586,27 @@ static void HandleWaitSettleState(void)
     return;
   }
 
-  // Wait for settling time
-  if(timeInState >= PUMP_STARTUP_DELAY) {
+  // Wait until the level reading is stable (PUMP_STARTUP_DELAY at most)
+  if(SettleDone(currentTime, timeInState)) {
+    STATS_WRITE_BEGIN();
+    sm.stats.lastSettleSaved = (timeInState < PUMP_STARTUP_DELAY) ? PUMP_STARTUP_DELAY - timeInState : 0;
+    sm.stats.totalSettleSaved += sm.stats.lastSettleSaved;
+    sm.stats.settleCount++;
+    STATS_WRITE_END();
+
     if(Sensors_IsTankFull()) {
       EnterState(STATE_FULL);
     } else if(Sensors_IsTankEmpty()) {
-      if(CheckSafetyConditions()) {
+      if(!CheckSafetyConditions()) {
+        if(sm.currentState != STATE_ERROR) {
+          EnterState(STATE_ERROR);  // Not already raised by the check itself
+        }
+      } else if(!PowerGov_PumpStartAllowed()) {
+        EnterState(STATE_IDLE);   // Start budget spent - wait for the next hour
+      } else if(StartPump(currentTime)) {
         EnterState(STATE_FILLING);
-        PUMP_ON();
-        sm.pumpStartTime = currentTime;
-        sm.stats.pumpCycleCount++;
-      } else {
-        EnterState(STATE_ERROR);
       }
+      // else: ISR cutoff latched meanwhile, reconciled on next pass
     } else {
       EnterState(STATE_IDLE);
     }
@@ -405,8 +626,10 @@ static void HandleFillingState(void)
   if(!CheckPumpDutyCycle()) {
     PUMP_OFF();
     sm.pumpStopTime = currentTime;
-    UpdatePumpStatistics(pumpRunTime);
+    STATS_WRITE_BEGIN();
+    UpdatePumpStatistics(pumpRunTime, PUMP_CYCLE_ERROR);
     sm.stats.errorCount++;
+    STATS_WRITE_END();
     // Force cooldown
     EnterState(STATE_COOLDOWN); 
     return;
@@ -415,12 +638,16 @@ static void HandleFillingState(void)
   // Safety check: overflow detected
   if(Sensors_IsOverflow()) {
     PUMP_OFF();
+    LatencyTrace_MarkActuator(LATENCY_PATH_OVERFLOW);
     sm.pumpStopTime = currentTime;
+    sm.errorCode = ERROR_OVERFLOW;
+    STATS_WRITE_BEGIN();
     sm.stats.totalPumpRunTime += pumpRunTime;
     sm.stats.lastFillDuration = pumpRunTime;
-    sm.errorCode = ERROR_OVERFLOW;
     sm.stats.errorCount++;
     sm.stats.lastErrorCode = ERROR_OVERFLOW;
+    RecordPumpCycle(pumpRunTime, PUMP_CYCLE_ERROR);
+    STATS_WRITE_END();
     EnterState(STATE_ERROR);
     return;
   }
@@ -428,9 +655,13 @@ static void HandleFillingState(void)
   // Safety check: door opened during filling
   if(!Sensors_IsDoorClosed()) {
     PUMP_OFF();
+    LatencyTrace_MarkActuator(LATENCY_PATH_DOOR_OPEN);
     sm.pumpStopTime = currentTime;
+    STATS_WRITE_BEGIN();
     sm.stats.totalPumpRunTime += pumpRunTime;
     sm.stats.lastFillDuration = pumpRunTime;
+    RecordPumpCycle(pumpRunTime, PUMP_CYCLE_INTERRUPTED);
+    STATS_WRITE_END();
     EnterState(STATE_DOOR_OPEN);
     return;
   }
@@ -438,22 +669,57 @@ static void HandleFillingState(void)
   // Tank full - normal completion
   if(Sensors_IsTankFull()) {
     PUMP_OFF();
+    LatencyTrace_MarkActuator(LATENCY_PATH_TANK_FULL);
     sm.pumpStopTime = currentTime;
-    UpdatePumpStatistics(pumpRunTime);
+    UpdatePumpStatistics(pumpRunTime, PUMP_CYCLE_FULL);
     EnterState(STATE_FULL);
     return;
   }
 
+  // Motor current says dry or blocked - seconds instead of the fill timeout
+  CurrentFault_t currentFault = PumpCurrent_GetFault();
+  if(currentFault == CURRENT_FAULT_DRY) {
+    StopGallonEmpty(currentTime, pumpRunTime, 0);
+    return;
+  }
+  if(currentFault == CURRENT_FAULT_STALL) {
+    StopPumpError(currentTime, pumpRunTime, ERROR_PUMP_STALL);
+    return;
+  }
+
+  // Pump running but the flow meter sees no water - gallon ran dry
+  if(FlowMeter_IsDry(pumpRunTime)) {
+    StopGallonEmpty(currentTime, pumpRunTime, 0);
+    return;
+  }
+
+  // More than a tank's worth delivered and still not full - level switch stuck
+  if(FlowMeter_IsOverLimit()) {
+    StopPumpError(currentTime, pumpRunTime, ERROR_SENSOR_FAULT);
+    return;
+  }
+
   #if ENABLE_TIMEOUT_SAFETY
+  // Water was available and the level switch never moved - blame the switch,
+  // not the gallon or the pump
+  if((pumpRunTime > PUMP_MAX_RUN_TIME || (pumpRunTime > PUMP_NORMAL_FILL_TIME && !Sensors_IsTankFull())) &&
+     SensorHealth_LevelStuck(pumpRunTime)) {
+    StopPumpError(currentTime, pumpRunTime, ERROR_SENSOR_FAULT);
+    return;
+  }
+
   // Safety timeout - maximum run time exceeded
   if(pumpRunTime > PUMP_MAX_RUN_TIME) {
     PUMP_OFF();
     sm.pumpStopTime = currentTime;
+    sm.errorCode = ERROR_PUMP_TIMEOUT;
+    STATS_WRITE_BEGIN();
     sm.stats.totalPumpRunTime += pumpRunTime;
     sm.stats.lastFillDuration = pumpRunTime;
-    sm.errorCode = ERROR_PUMP_TIMEOUT;
     sm.stats.errorCount++;
     sm.stats.lastErrorCode = ERROR_PUMP_TIMEOUT;
+    RecordPumpCycle(pumpRunTime, PUMP_CYCLE_ERROR);
+    STATS_WRITE_END();
     EnterState(STATE_ERROR);
     return;
   }
@@ -461,17 +727,90 @@ static void HandleFillingState(void)
   // Auto-stop at normal fill time if sensor doesn't trigger
   // (backup safety in case sensor fails high)
   if(pumpRunTime > PUMP_NORMAL_FILL_TIME && !Sensors_IsTankFull()) {
-    PUMP_OFF();
-    sm.pumpStopTime = currentTime;
-    sm.stats.totalPumpRunTime += pumpRunTime;
-    sm.stats.lastFillDuration = pumpRunTime;
-    sm.errorCode = ERROR_GALLON_EMPTY;
-    sm.stats.errorCount++;
-    sm.stats.lastErrorCode = ERROR_GALLON_EMPTY;
-    EnterState(STATE_ERROR);
+    StopGallonEmpty(currentTime, pumpRunTime, 0);
     return;
   }
   #endif
+
+  // Pumped more than the gallon can hold - stop the dry run early
+  if(Gallon_IsExhausted(pumpRunTime, FlowMeter_GetFillVolume_ml(pumpRunTime))) {
+    StopGallonEmpty(currentTime, pumpRunTime, 1);
+    return;
+  }
+}
+
+/**
+  * @brief  Stop a fill that ran the gallon dry
+  * @param  currentTime Current tick
+  * @param  pumpRunTime Pump on time of the fill
+  * @param  cutByEstimate 1 if stopped by the inventory estimate, 0 by fill time
+  * @retval None
+  */
+static void StopGallonEmpty(uint32_t currentTime, uint32_t pumpRunTime, uint8_t cutByEstimate)
+{
+  PUMP_OFF();
+  sm.pumpStopTime = currentTime;
+  sm.errorCode = ERROR_GALLON_EMPTY;
+  STATS_WRITE_BEGIN();
+  sm.stats.totalPumpRunTime += pumpRunTime;
+  sm.stats.lastFillDuration = pumpRunTime;
+  sm.stats.errorCount++;
+  sm.stats.lastErrorCode = ERROR_GALLON_EMPTY;
+  RecordPumpCycle(pumpRunTime, PUMP_CYCLE_ERROR);
+  STATS_WRITE_END();
+  Gallon_MarkEmpty(cutByEstimate);
+  EnterState(STATE_ERROR);
+}
+
+/**
+  * @brief  Stop a fill on a pump or sensor fault
+  * @param  currentTime Current tick
+  * @param  pumpRunTime Pump on time of the fill
+  * @param  errorCode Error to latch
+  * @retval None
+  */
+static void StopPumpError(uint32_t currentTime, uint32_t pumpRunTime, uint8_t errorCode)
+{
+  PUMP_OFF();
+  sm.pumpStopTime = currentTime;
+  sm.errorCode = errorCode;
+  STATS_WRITE_BEGIN();
+  sm.stats.totalPumpRunTime += pumpRunTime;
+  sm.stats.lastFillDuration = pumpRunTime;
+  sm.stats.errorCount++;
+  sm.stats.lastErrorCode = errorCode;
+  RecordPumpCycle(pumpRunTime, PUMP_CYCLE_ERROR);
+  STATS_WRITE_END();
+  EnterState(STATE_ERROR);
+}
+
+/**
+  * @brief  Sample the level and decide whether the settle phase is over
+  * @param  currentTime Current tick
+  * @param  timeInState Time spent in WAIT_SETTLE
+  * @retval 1 once the level read the same for SETTLE_STABLE_SAMPLES samples
+  *         or PUMP_STARTUP_DELAY has passed, 0 otherwise
+  */
+static uint8_t SettleDone(uint32_t currentTime, uint32_t timeInState)
+{
+  #if SETTLE_STABLE_SAMPLES > 0
+  if((currentTime - settleSampleTime) >= SETTLE_SAMPLE_MS) {
+    uint8_t level = Sensors_IsTankFull();
+
+    settleSampleTime = currentTime;
+    if(settleStable == 0 || level != settleLevel) {
+      settleLevel = level;      // Slosh: start the run again
+      settleStable = 1;
+    } else if(settleStable < SETTLE_STABLE_SAMPLES) {
+      settleStable++;
+    }
+  }
+  if(settleStable >= SETTLE_STABLE_SAMPLES) {
+    return 1;
+  }
+  #endif
+
+  return (timeInState >= PUMP_STARTUP_DELAY) ? 1 : 0;
 }
 
 /**
@@ -488,8 +827,16 @@ static void HandleFullState(void)
     return;
   }
 
-  // Tank no longer full (water consumed)
+  // Tank no longer full (water consumed) - IDLE waits until a refill is due
   if(Sensors_IsTankEmpty()) {
+    if(LeakDetect_Drained()) {
+      StateMachine_RaiseError(ERROR_LEAK);
+      return;
+    }
+    if(!RefillPolicy_RefillDue()) {
+      EnterState(STATE_IDLE);
+      return;
+    }
     #if ENABLE_COOLDOWN_PERIOD
     EnterState(STATE_COOLDOWN);
     #else
@@ -518,6 +865,13 @@ static void HandleErrorState(void)
   } else {
     // Reset timer when door closes
     sm.stateChangeTime = currentTime;
+
+    // Transient errors clear themselves once their backoff has passed
+    // (counters are kept, unlike the door reset)
+    if(ErrorRecovery_RetryDue()) {
+      sm.errorCode = ERROR_NONE;
+      EnterState(STATE_IDLE);
+    }
   }
 }
 
@@ -540,7 +894,7 @@ static void HandleCooldownState(void)
 
   // Wait minimum interval before allowing refill
   if(timeInState >= MIN_PUMP_INTERVAL) {
-    if(Sensors_IsTankEmpty()) {
+    if(Sensors_IsTankEmpty() && RefillPolicy_RefillDue()) {
       EnterState(STATE_WAIT_SETTLE);
     } else if(Sensors_IsTankFull()) {
       EnterState(STATE_FULL);
@@ -591,35 +945,48 @@ static uint8_t CheckPumpDutyCycle(void)
 }
 
 /**
-  * @brief  Calculate pump health score
-  * @retval uint8_t 0-100 (100 = perfect health)
+  * @brief  Duty cycle of the current window
+  * @retval uint8_t 0-100 percent
   */
-static uint8_t CalculatePumpHealth(void)
+static uint8_t CurrentDutyPercent(void)
 {
-  uint8_t score = 100;
-  
-  // Deduct for errors
-  if(sm.stats.errorCount > 10) score -= 20;
-  else if(sm.stats.errorCount > 5) score -= 10;
-  
-  // Deduct for excessive runtime
-  if(sm.stats.pumpAverageRuntime > (PUMP_NORMAL_FILL_TIME * 1.5)) {
-    score -= 15;
-  }
-  
-  // Deduct for rapid cycling
-  if(sm.stats.pumpCycleCount > 1000) {
-    score -= 10;
+  uint32_t windowDuration = HAL_GetTick() - windowStartTime;
+
+  if(windowStartTime == 0 || windowDuration == 0) return 0;
+  if(pumpOnTimeWindow >= windowDuration) return 100;
+  return (uint8_t)((pumpOnTimeWindow * 100) / windowDuration);
+}
+
+/**
+  * @brief  Feed a finished cycle to the health model, gallon inventory,
+  *         usage statistics and pump current detector
+  */
+static void RecordPumpCycle(uint32_t runtime, PumpCycleOutcome_t outcome)
+{
+  uint32_t volume = FlowMeter_GetFillVolume_ml(runtime);
+
+  PumpHealth_RecordCycle(runtime, CurrentDutyPercent(), outcome);
+  Gallon_RecordCycle(volume, outcome);
+  UsageStats_Update(runtime, volume);
+  RefillPolicy_FillDone(volume, runtime, outcome == PUMP_CYCLE_FULL);
+  SensorHealth_FillDone(runtime, outcome != PUMP_CYCLE_INTERRUPTED);
+  if(outcome == PUMP_CYCLE_FULL) {
+    PumpCurrent_FillComplete();
+    ErrorRecovery_FillComplete();
+    LeakDetect_FillFull();
   }
-  
-  return score;
+
+  STATS_WRITE_BEGIN();
+  sm.stats.pumpHealthScore = PumpHealth_GetReport()->score;
+  STATS_WRITE_END();
 }
 
 /**
   * @brief  Update statistics after pump stop
   */
-static void UpdatePumpStatistics(uint32_t runtime)
+static void UpdatePumpStatistics(uint32_t runtime, PumpCycleOutcome_t outcome)
 {
+  STATS_WRITE_BEGIN();
   sm.stats.totalPumpRunTime += runtime;
   sm.stats.lastFillDuration = runtime;
   
@@ -638,6 +1005,68 @@ static void UpdatePumpStatistics(uint32_t runtime)
       sm.stats.totalPumpRunTime / sm.stats.pumpCycleCount;
   }
   
-  // Update health score
-  sm.stats.pumpHealthScore = CalculatePumpHealth();
+  // Update health model and score
+  RecordPumpCycle(runtime, outcome);
+  STATS_WRITE_END();
+}
+
+/**
+  * @brief  Switch pump on and start a new cycle
+  * @param  currentTime Current tick
+  * @retval 1 if pump started, 0 if refused by the ISR safety latch
+  */
+static uint8_t StartPump(uint32_t currentTime)
+{
+  const GallonStatus_t* gallon = Gallon_GetStatus();
+
+  if(!PumpSafety_PumpOn()) {
+    return 0;
+  }
+
+  // The level switch has to move on this fill unless the gallon is believed empty
+  SensorHealth_FillStart(gallon->swapPending || (gallon->known && gallon->remaining_ml > 0));
+
+  sm.pumpStartTime = currentTime;
+  StartLimiter_NoteStart();
+  PowerGov_NotePumpStart();
+  FlowMeter_StartFill();
+  PumpCurrent_Start();
+  STATS_WRITE_BEGIN();
+  sm.stats.pumpCycleCount++;
+  STATS_WRITE_END();
+  return 1;
+}
+
+/**
+  * @brief  Apply a pump cutoff performed by the level/overflow ISR
+  * @retval None
+  */
+static void ReconcileISRCutoff(void)
+{
+  uint8_t sources = PumpSafety_TakeLatched();
+
+  if(sources == PUMP_CUTOFF_NONE || sm.currentState != STATE_FILLING) {
+    return;
+  }
+
+  uint32_t currentTime = HAL_GetTick();
+  uint32_t pumpRunTime = currentTime - sm.pumpStartTime;
+
+  sm.pumpStopTime = currentTime;
+
+  if(sources & PUMP_CUTOFF_OVERFLOW) {
+    sm.errorCode = ERROR_OVERFLOW;
+    STATS_WRITE_BEGIN();
+    sm.stats.totalPumpRunTime += pumpRunTime;
+    sm.stats.lastFillDuration = pumpRunTime;
+    sm.stats.errorCount++;
+    sm.stats.lastErrorCode = ERROR_OVERFLOW;
+    RecordPumpCycle(pumpRunTime, PUMP_CYCLE_ERROR);
+    STATS_WRITE_END();
+    EnterState(STATE_ERROR);
+  } else {
+    // Tank full - normal completion, stopped early by the ISR
+    UpdatePumpStatistics(pumpRunTime, PUMP_CYCLE_FULL);
+    EnterState(STATE_FULL);
+  }
 }
@@ -22,6 +22,16 @@
 #include "stm32f1xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "config.h"
+#include "cycle_counter.h"
+#include "pump_safety.h"
+#include "latency_trace.h"
+#include "low_power.h"
+#include "timebase.h"
+#include "adc_sampler.h"
+#include "sensor_health.h"
+#include "checkpoint.h"
+#include "supervisor.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -51,12 +61,6 @@
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-// Debounce timing
-static uint32_t lastDoorInterruptTime = 0;
-static uint32_t lastWaterInterruptTime = 0;
-static uint32_t lastOverflowInterruptTime = 0;
-
-#define DEBOUNCE_TIME_MS 50  // 50ms debounce
 /* USER CODE END 0 */
 
 /* External variables --------------------------------------------------------*/
@@ -84,66 +88,6 @@ void NMI_Handler(void)
   /* USER CODE END NonMaskableInt_IRQn 1 */
 }
 
-/**
-  * @brief This function handles Hard fault interrupt.
-  */
-void HardFault_Handler(void)
-{
-  /* USER CODE BEGIN HardFault_IRQn 0 */
-
-  /* USER CODE END HardFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_HardFault_IRQn 0 */
-    /* USER CODE END W1_HardFault_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Memory management fault.
-  */
-void MemManage_Handler(void)
-{
-  /* USER CODE BEGIN MemoryManagement_IRQn 0 */
-
-  /* USER CODE END MemoryManagement_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_MemoryManagement_IRQn 0 */
-    /* USER CODE END W1_MemoryManagement_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Prefetch fault, memory access fault.
-  */
-void BusFault_Handler(void)
-{
-  /* USER CODE BEGIN BusFault_IRQn 0 */
-
-  /* USER CODE END BusFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_BusFault_IRQn 0 */
-    /* USER CODE END W1_BusFault_IRQn 0 */
-  }
-}
-
-/**
-  * @brief This function handles Undefined instruction or illegal state.
-  */
-void UsageFault_Handler(void)
-{
-  /* USER CODE BEGIN UsageFault_IRQn 0 */
-
-  /* USER CODE END UsageFault_IRQn 0 */
-  while (1)
-  {
-    /* USER CODE BEGIN W1_UsageFault_IRQn 0 */
-    /* USER CODE END W1_UsageFault_IRQn 0 */
-  }
-}
-
 /**
   * @brief This function handles System service call via SWI instruction.
   */
@@ -210,14 +154,20 @@ void SysTick_Handler(void)
 void EXTI0_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI0_IRQn 0 */
+  uint32_t entryCycles = CycleCounter_Now();
+
+  // Door opened while pumping: start of the door -> pump off trace
+  if(PUMP_IS_ON() && IS_DOOR_OPEN()) {
+    LatencyTrace_MarkEdge(LATENCY_PATH_DOOR_OPEN, entryCycles - CYCLE_COUNTER_IRQ_ENTRY_CYCLES);
+  }
+
   uint32_t currentTime = HAL_GetTick();
   
-  // Debounce check
-  if((currentTime - lastDoorInterruptTime) < DEBOUNCE_TIME_MS) {
+  // Counted for the health monitor; bounces inside the input's window are dropped
+  if(!SensorHealth_EdgeISR(SENSOR_INPUT_DOOR, currentTime)) {
     __HAL_GPIO_EXTI_CLEAR_IT(DOOR_SW_Pin);
     return;  // Ignore this interrupt
   }
-  lastDoorInterruptTime = currentTime;
   /* USER CODE END EXTI0_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(DOOR_SW_Pin);
   /* USER CODE BEGIN EXTI0_IRQn 1 */
@@ -231,14 +181,24 @@ void EXTI0_IRQHandler(void)
 void EXTI1_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI1_IRQn 0 */
+  uint32_t entryCycles = CycleCounter_Now();
+
+  #if ENABLE_ISR_PUMP_CUTOFF
+  // Cut the pump before anything else - a bounce here means water is at the switch
+  PumpSafety_LevelEdgeISR(entryCycles);
+  #else
+  if(PUMP_IS_ON() && IS_TANK_FULL()) {
+    LatencyTrace_MarkEdge(LATENCY_PATH_TANK_FULL, entryCycles - CYCLE_COUNTER_IRQ_ENTRY_CYCLES);
+  }
+  #endif
+
   uint32_t currentTime = HAL_GetTick();
   
-  // Debounce check
-  if((currentTime - lastWaterInterruptTime) < DEBOUNCE_TIME_MS) {
+  // Counted for the health monitor; bounces inside the input's window are dropped
+  if(!SensorHealth_EdgeISR(SENSOR_INPUT_LEVEL, currentTime)) {
     __HAL_GPIO_EXTI_CLEAR_IT(WATER_LIMIT_Pin);
     return;  // Ignore this interrupt
   }
-  lastWaterInterruptTime = currentTime;
   /* USER CODE END EXTI1_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(WATER_LIMIT_Pin);
   /* USER CODE BEGIN EXTI1_IRQn 1 */
@@ -252,14 +212,25 @@ void EXTI1_IRQHandler(void)
 void EXTI2_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI2_IRQn 0 */
+  uint32_t entryCycles = CycleCounter_Now();
+
+  #if ENABLE_ISR_PUMP_CUTOFF
+  PumpSafety_OverflowEdgeISR(entryCycles);
+  #elif ENABLE_OVERFLOW_SENSOR
+  if(PUMP_IS_ON() && IS_OVERFLOW()) {
+    LatencyTrace_MarkEdge(LATENCY_PATH_OVERFLOW, entryCycles - CYCLE_COUNTER_IRQ_ENTRY_CYCLES);
+  }
+  #else
+  (void)entryCycles;
+  #endif
+
   uint32_t currentTime = HAL_GetTick();
   
-  // Debounce check
-  if((currentTime - lastOverflowInterruptTime) < DEBOUNCE_TIME_MS) {
+  // Counted for the health monitor; bounces inside the input's window are dropped
+  if(!SensorHealth_EdgeISR(SENSOR_INPUT_OVERFLOW, currentTime)) {
     __HAL_GPIO_EXTI_CLEAR_IT(OVERFLOW_SENSOR_Pin);
     return;  // Ignore this interrupt
   }
-  lastOverflowInterruptTime = currentTime;
   /* USER CODE END EXTI2_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(OVERFLOW_SENSOR_Pin);
   /* USER CODE BEGIN EXTI2_IRQn 1 */
@@ -273,7 +244,11 @@ void EXTI2_IRQHandler(void)
 void TIM4_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM4_IRQn 0 */
-
+  #if ENABLE_FAST_TICK_ISR
+  // Only the update interrupt is enabled on TIM4 - skip the generic flag walk
+  Timebase_TickISR();
+  return;
+  #endif
   /* USER CODE END TIM4_IRQn 0 */
   HAL_TIM_IRQHandler(&htim4);
   /* USER CODE BEGIN TIM4_IRQn 1 */
@@ -283,4 +258,40 @@ void TIM4_IRQHandler(void)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles RTC alarm interrupt through EXTI line 17.
+  */
+void RTC_Alarm_IRQHandler(void)
+{
+  // Deep sleep housekeeping wake - the main loop feeds the IWDG
+  LowPower_RtcAlarmISR();
+}
+
+/**
+  * @brief This function handles DMA1 channel1 global interrupt.
+  */
+void DMA1_Channel1_IRQHandler(void)
+{
+  // ADC1 half buffer ready - reduce it to per-channel means
+  AdcSampler_DmaISR();
+}
+
+/**
+  * @brief This function handles PVD interrupt through EXTI line 16.
+  */
+void PVD_IRQHandler(void)
+{
+  // VDD falling below the PVD threshold - save counters before the brownout
+  Checkpoint_PvdISR();
+}
+
+/**
+  * @brief This function handles window watchdog early wakeup interrupt.
+  */
+void WWDG_IRQHandler(void)
+{
+  // Control pass overdue - pump off and record before the reset
+  Supervisor_WwdgISR();
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,348 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : supervisor.c
+  * @brief          : Task check-in watchdog supervisor, window watchdog and reset history
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "supervisor.h"
+#include "iwdg.h"
+#include "deferred_log.h"
+#include <stddef.h>
+
+/* Private define ------------------------------------------------------------*/
+#define HISTORY_MAGIC             0x5B0075EDUL
+#define ALL_TASKS                 ((1U << SUP_TASK_COUNT) - 1U)
+#define WWDG_T_MIN                0x40U       // Reset when the counter drops below this
+#define WWDG_TICKS_MAX            64U         // 0x7F down to 0x40
+
+_Static_assert(SUP_TASK_COUNT <= 8, "Task masks are 8 bits wide");
+
+/* Private variables ---------------------------------------------------------*/
+static SupervisorHistory_t history __attribute__((section(".noinit")));
+static SupervisorTaskStats_t tasks[SUP_TASK_COUNT];
+
+static const char* const taskNames[SUP_TASK_COUNT] = {
+  "control", "housekeeping", "io"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void RecordBoot(void);
+static uint32_t Checksum(const SupervisorHistory_t* h);
+#if ENABLE_TASK_SUPERVISOR && ENABLE_WWDG
+static void ConfigureWwdg(void);
+static uint8_t WwdgWindowOpen(void);
+#endif
+
+#if ENABLE_TASK_SUPERVISOR
+
+static const uint32_t taskDeadlines[SUP_TASK_COUNT] = {
+  SUP_DEADLINE_CONTROL_MS, SUP_DEADLINE_HOUSEKEEPING_MS, SUP_DEADLINE_IO_MS
+};
+
+static uint8_t checkedIn = 0;         // Tasks seen since the last IWDG refresh
+
+#if ENABLE_WWDG
+static uint8_t wwdgReload;            // Counter value written on refresh (T)
+static uint8_t wwdgWindow;            // Refresh allowed once the counter is at or below this (W)
+static uint8_t controlPass = 0;       // Control task ran since the last WWDG refresh
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Record the reset cause, start task deadlines and the WWDG
+  * @param  None
+  * @retval None
+  */
+void Supervisor_Init(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  RecordBoot();
+
+  for(uint32_t i = 0; i < SUP_TASK_COUNT; i++) {
+    tasks[i].deadline_ms = taskDeadlines[i];
+    tasks[i].lastCheckIn = now;
+  }
+
+  #if ENABLE_WWDG
+  // Halted core on a debugger must not reset the board
+  __HAL_DBGMCU_FREEZE_WWDG();
+  __HAL_RCC_WWDG_CLK_ENABLE();
+  ConfigureWwdg();
+  WWDG->SR = 0;
+  WWDG->CR = WWDG_CR_WDGA | wwdgReload;
+
+  HAL_NVIC_SetPriority(WWDG_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(WWDG_IRQn);
+  #endif
+}
+
+/**
+  * @brief  Report that a task has run
+  * @param  task Task
+  * @retval None
+  */
+void Supervisor_CheckIn(SupervisorTask_t task)
+{
+  SupervisorTaskStats_t* t = &tasks[task];
+  uint32_t now = HAL_GetTick();
+  uint32_t gap = now - t->lastCheckIn;
+
+  if(gap > t->maxGap_ms) {
+    t->maxGap_ms = gap;
+  }
+  if(gap > t->deadline_ms) {
+    t->misses++;
+    LOG_WARN("task %u checked in after %u ms, deadline %u ms", task, gap, t->deadline_ms);
+  }
+  t->lastCheckIn = now;
+
+  checkedIn |= (uint8_t)(1U << task);
+  history.pending = (uint8_t)(~checkedIn & ALL_TASKS);
+
+  #if ENABLE_WWDG
+  if(task == SUP_TASK_CONTROL) {
+    controlPass = 1;
+  }
+  #endif
+}
+
+/**
+  * @brief  Count deadline misses, refresh the IWDG when all tasks checked
+  *         in and the WWDG once per control pass, inside its window
+  * @param  None
+  * @retval None
+  */
+void Supervisor_Process(void)
+{
+  uint32_t now = HAL_GetTick();
+  uint8_t late = 0;
+
+  for(uint32_t i = 0; i < SUP_TASK_COUNT; i++) {
+    if(now - tasks[i].lastCheckIn > tasks[i].deadline_ms) {
+      late |= (uint8_t)(1U << i);
+    }
+  }
+  history.pendingLate = late;
+
+  // A task that stopped running holds its bit clear and the IWDG runs out
+  if(checkedIn == ALL_TASKS) {
+    HAL_IWDG_Refresh(&hiwdg);
+    checkedIn = 0;
+  }
+  history.pending = (uint8_t)(~checkedIn & ALL_TASKS);
+
+  #if ENABLE_WWDG
+  // Once per control pass, inside the window. A pass right after a blocking
+  // report (or a STOP wake) keeps its claim and refreshes on a later loop turn.
+  if(controlPass && WwdgWindowOpen()) {
+    controlPass = 0;
+    WWDG->CR = wwdgReload;
+  }
+  #endif
+}
+
+/**
+  * @brief  Restart deadlines after a gap in which the tasks could not run
+  *         (STOP mode, supervised delay)
+  * @param  None
+  * @retval None
+  */
+void Supervisor_Resync(void)
+{
+  uint32_t now = HAL_GetTick();
+
+  for(uint32_t i = 0; i < SUP_TASK_COUNT; i++) {
+    tasks[i].lastCheckIn = now;
+  }
+}
+
+/**
+  * @brief  Blocking delay that keeps both watchdogs fed
+  * @param  ms Delay in milliseconds
+  * @retval None
+  */
+void Supervisor_Delay(uint32_t ms)
+{
+  uint32_t start = HAL_GetTick();
+
+  while((HAL_GetTick() - start) <= ms) {
+    HAL_IWDG_Refresh(&hiwdg);
+    #if ENABLE_WWDG
+    if(WwdgWindowOpen()) {
+      WWDG->CR = wwdgReload;
+    }
+    #endif
+  }
+  Supervisor_Resync();
+}
+
+/**
+  * @brief  Recompute the WWDG prescaler and window after a PCLK1 change
+  * @param  None
+  * @retval None
+  */
+void Supervisor_ClockChanged(void)
+{
+  #if ENABLE_WWDG
+  ConfigureWwdg();
+  #endif
+}
+
+/**
+  * @brief  WWDG early-wakeup interrupt: pump off, record, let the reset happen
+  * @param  None
+  * @retval None
+  */
+void Supervisor_WwdgISR(void)
+{
+  PUMP_OFF_ISR();
+  WWDG->SR = 0;
+  history.pendingEarly = 1;
+  // No refresh: the counter reaches 0x3F one WWDG tick later and resets
+}
+
+/**
+  * @brief  Task statistics
+  * @param  task Task
+  * @retval const SupervisorTaskStats_t* Pointer to statistics
+  */
+const SupervisorTaskStats_t* Supervisor_GetTask(SupervisorTask_t task)
+{
+  return &tasks[task];
+}
+
+/**
+  * @brief  Task name (for reports)
+  * @param  task Task
+  * @retval const char* Name string
+  */
+const char* Supervisor_GetTaskName(SupervisorTask_t task)
+{
+  return (task < SUP_TASK_COUNT) ? taskNames[task] : "unknown";
+}
+
+/**
+  * @brief  Reset history including this boot
+  * @param  None
+  * @retval const SupervisorHistory_t* Pointer to the history
+  */
+const SupervisorHistory_t* Supervisor_GetHistory(void)
+{
+  return &history;
+}
+
+#else
+
+// Stubs if disabled - plain IWDG refresh on every pass, boots still counted
+void Supervisor_Init(void) { RecordBoot(); }
+void Supervisor_CheckIn(SupervisorTask_t task) {}
+void Supervisor_Process(void) { HAL_IWDG_Refresh(&hiwdg); }
+void Supervisor_Resync(void) {}
+void Supervisor_Delay(uint32_t ms) { HAL_Delay(ms); }
+void Supervisor_ClockChanged(void) {}
+void Supervisor_WwdgISR(void) {}
+const SupervisorTaskStats_t* Supervisor_GetTask(SupervisorTask_t task) { return &tasks[task]; }
+const char* Supervisor_GetTaskName(SupervisorTask_t task) { return (task < SUP_TASK_COUNT) ? taskNames[task] : "unknown"; }
+const SupervisorHistory_t* Supervisor_GetHistory(void) { return &history; }
+
+#endif // ENABLE_TASK_SUPERVISOR
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Count this boot, take over what was pending when a watchdog fired
+  */
+static void RecordBoot(void)
+{
+  ResetCause_t cause = WarmRestart_GetResetCause();
+  uint8_t watchdog = (cause == RESET_CAUSE_IWDG || cause == RESET_CAUSE_WWDG);
+
+  // .noinit is random after power-on
+  if(cause == RESET_CAUSE_POWER_ON || history.magic != HISTORY_MAGIC || history.check != Checksum(&history)) {
+    uint8_t* p = (uint8_t*)&history;
+    for(uint32_t i = 0; i < sizeof(history); i++) {
+      p[i] = 0;
+    }
+    history.magic = HISTORY_MAGIC;
+  }
+
+  history.boots++;
+  if(history.causeCount[cause] != 0xFFFFU) {
+    history.causeCount[cause]++;
+  }
+  history.lastCause = (uint8_t)cause;
+  history.starved = watchdog ? history.pending : 0U;
+  history.late = watchdog ? history.pendingLate : 0U;
+  history.wwdgEarly = (cause == RESET_CAUSE_WWDG) ? history.pendingEarly : 0U;
+  history.check = Checksum(&history);
+
+  history.pending = 0;
+  history.pendingLate = 0;
+  history.pendingEarly = 0;
+
+  if(watchdog) {
+    LOG_ERROR("watchdog reset (cause %u): tasks 0x%02x not checked in, 0x%02x late",
+              cause, history.starved, history.late);
+  }
+  LOG_INFO("boot %u, reset cause %u", history.boots, cause);
+}
+
+/**
+  * @brief  Rotate-and-add checksum of the boot-time fields (magic up to check)
+  */
+static uint32_t Checksum(const SupervisorHistory_t* h)
+{
+  const uint8_t* p = (const uint8_t*)h;
+  uint32_t sum = 0xA5A5A5A5UL;
+
+  for(uint32_t i = 0; i < offsetof(SupervisorHistory_t, check); i++) {
+    sum = (sum << 1 | sum >> 31) + p[i];
+  }
+  return sum;
+}
+
+#if ENABLE_TASK_SUPERVISOR && ENABLE_WWDG
+
+/**
+  * @brief  Smallest prescaler that covers SUP_WWDG_TIMEOUT_MS at the current PCLK1
+  */
+static void ConfigureWwdg(void)
+{
+  uint32_t kHz = HAL_RCC_GetPCLK1Freq() / 1000U;
+  uint32_t prescaler = 0;
+  uint32_t tickDiv = 4096U;
+  uint32_t ticks;
+  uint32_t minTicks;
+
+  // One WWDG tick is 4096 << WDGTB PCLK1 cycles; 64 ticks at most
+  while((ticks = (SUP_WWDG_TIMEOUT_MS * kHz) / tickDiv) > WWDG_TICKS_MAX && prescaler < 3U) {
+    prescaler++;
+    tickDiv <<= 1;
+  }
+  if(ticks > WWDG_TICKS_MAX) ticks = WWDG_TICKS_MAX;       // Longest possible at this clock
+  if(ticks < 2U) ticks = 2U;
+
+  minTicks = (SUP_WWDG_MIN_MS * kHz + tickDiv - 1U) / tickDiv;
+  if(minTicks >= ticks) minTicks = ticks - 1U;
+
+  wwdgReload = (uint8_t)(WWDG_T_MIN - 1U + ticks);
+  wwdgWindow = (uint8_t)(wwdgReload - minTicks);
+  WWDG->CFR = WWDG_CFR_EWI | (prescaler << WWDG_CFR_WDGTB_Pos) | wwdgWindow;
+}
+
+/**
+  * @brief  Whether a refresh now would be inside the window
+  */
+static uint8_t WwdgWindowOpen(void)
+{
+  return (uint8_t)((WWDG->CR & WWDG_CR_T) <= wwdgWindow);
+}
+
+#endif // ENABLE_TASK_SUPERVISOR && ENABLE_WWDG
@@ -23,11 +23,32 @@
 /* Includes */
 #include <errno.h>
 #include <stdint.h>
+#include "config.h"
 
 /**
  * Pointer to the current high watermark of the heap usage
  */
+#if ENABLE_HEAP
 static uint8_t *__sbrk_heap_end = NULL;
+#endif
+
+/**
+ * @brief Current top of the newlib heap ('_end' if nothing was allocated)
+ *        The stack monitor scans the painted RAM above it
+ *
+ * @return Heap top
+ */
+uint8_t *_sbrk_heap_top(void)
+{
+  extern uint8_t _end; /* Symbol defined in the linker script */
+#if ENABLE_HEAP
+  if (NULL != __sbrk_heap_end)
+  {
+    return __sbrk_heap_end;
+  }
+#endif
+  return &_end;
+}
 
 /**
  * @brief _sbrk() allocates memory to the newlib heap and is used by malloc
@@ -52,6 +73,15 @@ static uint8_t *__sbrk_heap_end = NULL;
  */
 void *_sbrk(ptrdiff_t incr)
 {
+#if !ENABLE_HEAP
+  /* Allocation-free build: nothing may grow the heap. BKPT halts an attached
+   * debugger here; without one it escalates to HardFault and the crash record
+   * points at _sbrk. Reached only if the debugger resumes. */
+  (void)incr;
+  __BKPT(0);
+  errno = ENOMEM;
+  return (void *)-1;
+#else
   extern uint8_t _end; /* Symbol defined in the linker script */
   extern uint8_t _estack; /* Symbol defined in the linker script */
   extern uint32_t _Min_Stack_Size; /* Symbol defined in the linker script */
@@ -76,4 +106,5 @@ void *_sbrk(ptrdiff_t incr)
   __sbrk_heap_end += incr;
 
   return (void *)prev_heap_end;
+#endif // ENABLE_HEAP
 }
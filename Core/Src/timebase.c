@@ -0,0 +1,190 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : timebase.c
+  * @brief          : Lightweight TIM4 tick and sub-tick time reads
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "timebase.h"
+#include "cycle_counter.h"
+
+/* Private define ------------------------------------------------------------*/
+#define TIMEBASE_COUNTER_HZ           1000000U  // TIM4 counter clock set by HAL_InitTick
+#define TIMEBASE_IRQ_OVERHEAD_CYCLES  (2U * CYCLE_COUNTER_IRQ_ENTRY_CYCLES) // Stacking + unstacking
+#define TIMEBASE_MEASURE_RUNS         4
+
+/* Private variables ---------------------------------------------------------*/
+extern TIM_HandleTypeDef htim4;
+static TimebaseStats_t tbStats;
+#if TICK_PERIOD_MS > 1
+static uint32_t lastTickMs = 0;
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static void ReadTick(uint32_t* ms, uint32_t* count);
+static uint32_t MeasurePath(void (*path)(void));
+static void HalTickPath(void);
+static void FastTickPath(void);
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Apply TICK_PERIOD_MS and measure both tick paths
+  * @param  None
+  * @retval None
+  */
+void Timebase_Init(void)
+{
+  CycleCounter_Init();
+
+  #if TICK_PERIOD_MS > 1
+  // HAL_InitTick derives the TIM4 period from uwTickFreq
+  HAL_SetTickFreq((HAL_TickFreqTypeDef)TICK_PERIOD_MS);
+  #endif
+
+  tbStats.tickRateHz = 1000U / TICK_PERIOD_MS;
+  tbStats.halIsrCycles = MeasurePath(HalTickPath);
+  tbStats.fastIsrCycles = MeasurePath(FastTickPath);
+  tbStats.baselineCyclesPerSec = tbStats.halIsrCycles * 1000U;
+
+  #if ENABLE_FAST_TICK_ISR
+  tbStats.activeCyclesPerSec = tbStats.fastIsrCycles * tbStats.tickRateHz;
+  #else
+  tbStats.activeCyclesPerSec = tbStats.halIsrCycles * tbStats.tickRateHz;
+  #endif
+}
+
+/**
+  * @brief  Microsecond timestamp from uwTick and the TIM4 counter
+  * @param  None
+  * @retval uint32_t Microseconds
+  */
+uint32_t Timebase_GetMicros(void)
+{
+  uint32_t ms, count;
+
+  ReadTick(&ms, &count);
+  return (ms * 1000U) + (count * (1000000U / TIMEBASE_COUNTER_HZ));
+}
+
+/**
+  * @brief  Get tick cost report
+  * @param  None
+  * @retval const TimebaseStats_t* Pointer to statistics
+  */
+const TimebaseStats_t* Timebase_GetStats(void)
+{
+  return &tbStats;
+}
+
+#if TICK_PERIOD_MS > 1
+/**
+  * @brief  HAL tick with 1 ms resolution between slow tick interrupts
+  * @note   Overrides the weak HAL version. Clamped so it never runs
+  *         backwards when HAL_InitTick() restarts TIM4 (clock reconfig).
+  * @param  None
+  * @retval uint32_t Milliseconds
+  */
+uint32_t HAL_GetTick(void)
+{
+  uint32_t ms, count;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  ReadTick(&ms, &count);
+  ms += count / (TIMEBASE_COUNTER_HZ / 1000U);
+  if((int32_t)(ms - lastTickMs) < 0) {
+    ms = lastTickMs;
+  }
+  lastTickMs = ms;
+  __set_PRIMASK(primask);
+
+  return ms;
+}
+
+/**
+  * @brief  Millisecond delay without the extra tick period HAL adds
+  * @note   Overrides the weak HAL version. HAL_GetTick() is 1 ms resolution
+  *         here, so one extra millisecond guarantees the minimum wait.
+  * @param  Delay Delay in milliseconds
+  * @retval None
+  */
+void HAL_Delay(uint32_t Delay)
+{
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t wait = Delay;
+
+  if(wait < HAL_MAX_DELAY) {
+    wait++;
+  }
+
+  while((HAL_GetTick() - tickstart) < wait) {
+  }
+}
+#endif
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Consistent uwTick / TIM4 counter pair
+  * @note   A pending update that has not been serviced yet (interrupts
+  *         masked) means the counter already wrapped.
+  */
+static void ReadTick(uint32_t* ms, uint32_t* count)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  *ms = uwTick;
+  *count = TIM4->CNT;
+  if(TIM4->SR & TIM_SR_UIF) {
+    *count = TIM4->CNT;
+    *ms += uwTickFreq;
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Cycles spent in a tick path for one real update event (best of N)
+  */
+static uint32_t MeasurePath(void (*path)(void))
+{
+  uint32_t best = 0xFFFFFFFFU;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  for(int i = 0; i < TIMEBASE_MEASURE_RUNS; i++) {
+    TIM4->EGR = TIM_EGR_UG;     // Raises UIF exactly like a counter overflow
+
+    uint32_t start = CycleCounter_Now();
+    path();
+    uint32_t cycles = CycleCounter_Now() - start;
+
+    uwTick -= uwTickFreq;       // Undo the tick the path just added
+    if(cycles < best) best = cycles;
+  }
+  NVIC_ClearPendingIRQ(TIM4_IRQn);
+  __set_PRIMASK(primask);
+
+  return best + TIMEBASE_IRQ_OVERHEAD_CYCLES;
+}
+
+/**
+  * @brief  Original tick path
+  */
+static void HalTickPath(void)
+{
+  HAL_TIM_IRQHandler(&htim4);
+}
+
+/**
+  * @brief  Minimal tick path
+  */
+static void FastTickPath(void)
+{
+  Timebase_TickISR();
+}
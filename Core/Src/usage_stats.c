@@ -4,41 +4,36 @@
 #if ENABLE_USAGE_STATS
 
 static UsageStats_t stats;
-
-// Estimated flow rate in mL per second
-// Adjust based on pump spec
-#define PUMP_FLOW_RATE_ML_PER_SEC  20 
+static uint32_t pendingMl = 0;  // Volume not yet worth a whole liter
 
 /**
   * @brief  Initialize usage statistics
   */
 void UsageStats_Init(void)
 {
-  // TODO: Load from persistent storage
+  // Lifetime totals are restored afterwards from the power-fail checkpoint
   stats.totalLitersPumped = 0;
   stats.totalFills = 0;
   stats.totalRuntimeSec = 0;
+  pendingMl = 0;
 }
 
 /**
   * @brief  Update statistics after a fill cycle
   * @param  fillDurationMs Duration of the fill in milliseconds
+  * @param  volumeMl Volume delivered (FlowMeter_GetFillVolume_ml)
   */
-void UsageStats_Update(uint32_t fillDurationMs)
+void UsageStats_Update(uint32_t fillDurationMs, uint32_t volumeMl)
 {
   stats.totalFills++;
   
   uint32_t seconds = fillDurationMs / 1000;
   stats.totalRuntimeSec += seconds;
   
-  // Calculate volume
-  uint32_t mlPumped = seconds * PUMP_FLOW_RATE_ML_PER_SEC;
-  
-  // Update total liters (accumulate mL then convert to avoid float)
-  // Simplified for this example
-  stats.totalLitersPumped += (mlPumped / 1000);
-  
-  // TODO: Save to persistent storage
+  // Carry the sub-liter remainder so short fills still add up
+  pendingMl += volumeMl;
+  stats.totalLitersPumped += (pendingMl / 1000);
+  pendingMl %= 1000;
 }
 
 /**
@@ -49,11 +44,20 @@ UsageStats_t* UsageStats_Get(void)
   return &stats;
 }
 
+/**
+  * @brief  Restore lifetime totals (power-fail checkpoint)
+  */
+void UsageStats_Restore(const UsageStats_t* saved)
+{
+  stats = *saved;
+}
+
 #else
 
 // Stubs
 void UsageStats_Init(void) {}
-void UsageStats_Update(uint32_t fillDurationMs) {}
+void UsageStats_Update(uint32_t fillDurationMs, uint32_t volumeMl) {}
 UsageStats_t* UsageStats_Get(void) { return NULL; }
+void UsageStats_Restore(const UsageStats_t* saved) {}
 
 #endif // ENABLE_USAGE_STATS
@@ -0,0 +1,205 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file           : warm_restart.c
+  * @brief          : Reset cause and warm-restart context in backup registers
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "warm_restart.h"
+
+/* Private define ------------------------------------------------------------*/
+#define WARM_MAGIC              0x57A3U
+#define BKP_WORDS               10U                 // DR1..DR10 on medium-density parts
+#define BKP_REG(n)              ((&BKP->DR1)[(n)])  // 16 bits used per 32-bit register
+#define HOLDOFF_UNIT_MS         100U
+
+// Register map
+#define REG_MAGIC               0U
+#define REG_STATE_ERROR         1U                  // state << 8 | errorCode
+#define REG_LAST_ERROR          2U
+#define REG_HOLDOFF             3U                  // 100 ms units
+#define REG_CYCLES_LO           4U
+#define REG_CYCLES_HI           5U
+#define REG_RUNTIME_LO          6U
+#define REG_RUNTIME_HI          7U
+#define REG_ERROR_COUNT         8U
+#define REG_CHECK               9U
+
+/* Private variables ---------------------------------------------------------*/
+static ResetCause_t resetCause = RESET_CAUSE_POWER_ON;
+static uint8_t warm = 0;
+
+static const char* const causeNames[RESET_CAUSE_COUNT] = {
+  "power_on", "pin", "iwdg", "wwdg", "software", "low_power"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static ResetCause_t ReadResetCause(uint32_t csr);
+
+#if ENABLE_WARM_RESTART
+static uint16_t Checksum(const uint16_t* regs);
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Latch and clear the reset flags, decide warm or cold start
+  * @param  None
+  * @retval None
+  * @note   Call once, right after HAL_Init()
+  */
+void WarmRestart_Init(void)
+{
+  resetCause = ReadResetCause(RCC->CSR);
+  RCC->CSR |= RCC_CSR_RMVF;       // Flags are sticky until cleared
+
+  #if ENABLE_WARM_RESTART
+  __HAL_RCC_PWR_CLK_ENABLE();
+  __HAL_RCC_BKP_CLK_ENABLE();
+  HAL_PWR_EnableBkUpAccess();
+
+  // Only a watchdog or software reset resumes: power-on and the reset button start clean
+  warm = (resetCause == RESET_CAUSE_IWDG ||
+          resetCause == RESET_CAUSE_WWDG ||
+          resetCause == RESET_CAUSE_SOFTWARE);
+
+  uint16_t regs[BKP_WORDS];
+  for(uint32_t i = 0; i < BKP_WORDS; i++) {
+    regs[i] = (uint16_t)BKP_REG(i);
+  }
+  if(regs[REG_MAGIC] != WARM_MAGIC || regs[REG_CHECK] != Checksum(regs)) {
+    warm = 0;
+  }
+  if(!warm) {
+    BKP_REG(REG_MAGIC) = 0;
+  }
+  #endif
+}
+
+/**
+  * @brief  Reset cause latched at boot
+  * @param  None
+  * @retval ResetCause_t Reset cause
+  */
+ResetCause_t WarmRestart_GetResetCause(void)
+{
+  return resetCause;
+}
+
+/**
+  * @brief  Reset cause name (for reports)
+  * @param  cause Reset cause
+  * @retval const char* Name string
+  */
+const char* WarmRestart_GetResetCauseName(ResetCause_t cause)
+{
+  return (cause < RESET_CAUSE_COUNT) ? causeNames[cause] : "unknown";
+}
+
+/**
+  * @brief  Whether this boot resumes a valid context
+  * @param  None
+  * @retval uint8_t 1 for a warm restart
+  */
+uint8_t WarmRestart_IsWarm(void)
+{
+  return warm;
+}
+
+#if ENABLE_WARM_RESTART
+
+/**
+  * @brief  Unpack the saved context
+  * @param  ctx Receives the context
+  * @retval uint8_t 1 on a warm restart with a valid context, 0 otherwise
+  */
+uint8_t WarmRestart_Load(WarmContext_t* ctx)
+{
+  if(!warm) {
+    return 0;
+  }
+
+  uint16_t stateError = (uint16_t)BKP_REG(REG_STATE_ERROR);
+  ctx->state = (SystemState_t)(stateError >> 8);
+  ctx->errorCode = (uint8_t)stateError;
+  ctx->lastErrorCode = (uint8_t)BKP_REG(REG_LAST_ERROR);
+  ctx->holdoff_ms = (uint32_t)(uint16_t)BKP_REG(REG_HOLDOFF) * HOLDOFF_UNIT_MS;
+  ctx->pumpCycleCount = ((uint32_t)(uint16_t)BKP_REG(REG_CYCLES_HI) << 16) | (uint16_t)BKP_REG(REG_CYCLES_LO);
+  ctx->totalPumpRunTime = ((uint32_t)(uint16_t)BKP_REG(REG_RUNTIME_HI) << 16) | (uint16_t)BKP_REG(REG_RUNTIME_LO);
+  ctx->errorCount = (uint16_t)BKP_REG(REG_ERROR_COUNT);
+  return 1;
+}
+
+/**
+  * @brief  Pack the context into the backup registers (every state change)
+  * @param  ctx Context to save
+  * @retval None
+  */
+void WarmRestart_Save(const WarmContext_t* ctx)
+{
+  uint16_t regs[BKP_WORDS];
+  uint32_t holdoff = (ctx->holdoff_ms + HOLDOFF_UNIT_MS - 1U) / HOLDOFF_UNIT_MS;  // Round up
+
+  regs[REG_MAGIC] = WARM_MAGIC;
+  regs[REG_STATE_ERROR] = (uint16_t)(((uint32_t)ctx->state << 8) | ctx->errorCode);
+  regs[REG_LAST_ERROR] = ctx->lastErrorCode;
+  regs[REG_HOLDOFF] = (uint16_t)(holdoff > 0xFFFFU ? 0xFFFFU : holdoff);
+  regs[REG_CYCLES_LO] = (uint16_t)ctx->pumpCycleCount;
+  regs[REG_CYCLES_HI] = (uint16_t)(ctx->pumpCycleCount >> 16);
+  regs[REG_RUNTIME_LO] = (uint16_t)ctx->totalPumpRunTime;
+  regs[REG_RUNTIME_HI] = (uint16_t)(ctx->totalPumpRunTime >> 16);
+  regs[REG_ERROR_COUNT] = ctx->errorCount;
+  regs[REG_CHECK] = Checksum(regs);
+
+  // A reset halfway through leaves a bad checksum, which means a cold start
+  for(uint32_t i = 0; i < BKP_WORDS; i++) {
+    BKP_REG(i) = regs[i];
+  }
+}
+
+#else
+
+// Stubs if disabled - every boot is a cold start
+uint8_t WarmRestart_Load(WarmContext_t* ctx) { return 0; }
+void WarmRestart_Save(const WarmContext_t* ctx) {}
+
+#endif // ENABLE_WARM_RESTART
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Most specific reset flag (internal resets also pulse NRST)
+  */
+static ResetCause_t ReadResetCause(uint32_t csr)
+{
+  if(csr & RCC_CSR_PORRSTF)  return RESET_CAUSE_POWER_ON;
+  if(csr & RCC_CSR_LPWRRSTF) return RESET_CAUSE_LOW_POWER;
+  if(csr & RCC_CSR_WWDGRSTF) return RESET_CAUSE_WWDG;
+  if(csr & RCC_CSR_IWDGRSTF) return RESET_CAUSE_IWDG;
+  if(csr & RCC_CSR_SFTRSTF)  return RESET_CAUSE_SOFTWARE;
+  if(csr & RCC_CSR_PINRSTF)  return RESET_CAUSE_PIN;
+  return RESET_CAUSE_POWER_ON;
+}
+
+#if ENABLE_WARM_RESTART
+
+/**
+  * @brief  Fletcher-16 over every register but the checksum
+  */
+static uint16_t Checksum(const uint16_t* regs)
+{
+  uint32_t a = 0xFFU;
+  uint32_t b = 0xFFU;
+
+  for(uint32_t i = 0; i < REG_CHECK; i++) {
+    a = (a + regs[i]) % 0xFFU;
+    b = (b + a) % 0xFFU;
+  }
+  return (uint16_t)((b << 8) | a);
+}
+
+#endif // ENABLE_WARM_RESTART
@@ -5,58 +5,130 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../Core/Src/adc_sampler.c \
 ../Core/Src/battery_monitor.c \
+../Core/Src/checkpoint.c \
 ../Core/Src/config_storage.c \
+../Core/Src/crash_dump.c \
+../Core/Src/current_detector.c \
+../Core/Src/deferred_log.c \
 ../Core/Src/error_log.c \
+../Core/Src/error_recovery.c \
+../Core/Src/flow_meter.c \
+../Core/Src/fmt.c \
+../Core/Src/gallon_inventory.c \
 ../Core/Src/gpio.c \
 ../Core/Src/iwdg.c \
+../Core/Src/latency_trace.c \
+../Core/Src/leak_detect.c \
+../Core/Src/low_power.c \
 ../Core/Src/main.c \
+../Core/Src/mem_pool.c \
+../Core/Src/power_governor.c \
+../Core/Src/pump_current.c \
+../Core/Src/pump_health.c \
+../Core/Src/pump_safety.c \
+../Core/Src/refill_policy.c \
 ../Core/Src/remote_monitor.c \
+../Core/Src/sensor_health.c \
 ../Core/Src/sensors.c \
+../Core/Src/stack_monitor.c \
+../Core/Src/start_limiter.c \
 ../Core/Src/state_machine.c \
 ../Core/Src/stm32f1xx_hal_msp.c \
 ../Core/Src/stm32f1xx_hal_timebase_tim.c \
 ../Core/Src/stm32f1xx_it.c \
+../Core/Src/supervisor.c \
 ../Core/Src/syscalls.c \
 ../Core/Src/sysmem.c \
 ../Core/Src/system_stm32f1xx.c \
-../Core/Src/usage_stats.c 
+../Core/Src/timebase.c \
+../Core/Src/usage_stats.c \
+../Core/Src/warm_restart.c 
 
 OBJS += \
+./Core/Src/adc_sampler.o \
 ./Core/Src/battery_monitor.o \
+./Core/Src/checkpoint.o \
 ./Core/Src/config_storage.o \
+./Core/Src/crash_dump.o \
+./Core/Src/current_detector.o \
+./Core/Src/deferred_log.o \
 ./Core/Src/error_log.o \
+./Core/Src/error_recovery.o \
+./Core/Src/flow_meter.o \
+./Core/Src/fmt.o \
+./Core/Src/gallon_inventory.o \
 ./Core/Src/gpio.o \
 ./Core/Src/iwdg.o \
+./Core/Src/latency_trace.o \
+./Core/Src/leak_detect.o \
+./Core/Src/low_power.o \
 ./Core/Src/main.o \
+./Core/Src/mem_pool.o \
+./Core/Src/power_governor.o \
+./Core/Src/pump_current.o \
+./Core/Src/pump_health.o \
+./Core/Src/pump_safety.o \
+./Core/Src/refill_policy.o \
 ./Core/Src/remote_monitor.o \
+./Core/Src/sensor_health.o \
 ./Core/Src/sensors.o \
+./Core/Src/stack_monitor.o \
+./Core/Src/start_limiter.o \
 ./Core/Src/state_machine.o \
 ./Core/Src/stm32f1xx_hal_msp.o \
 ./Core/Src/stm32f1xx_hal_timebase_tim.o \
 ./Core/Src/stm32f1xx_it.o \
+./Core/Src/supervisor.o \
 ./Core/Src/syscalls.o \
 ./Core/Src/sysmem.o \
 ./Core/Src/system_stm32f1xx.o \
-./Core/Src/usage_stats.o 
+./Core/Src/timebase.o \
+./Core/Src/usage_stats.o \
+./Core/Src/warm_restart.o 
 
 C_DEPS += \
+./Core/Src/adc_sampler.d \
 ./Core/Src/battery_monitor.d \
+./Core/Src/checkpoint.d \
 ./Core/Src/config_storage.d \
+./Core/Src/crash_dump.d \
+./Core/Src/current_detector.d \
+./Core/Src/deferred_log.d \
 ./Core/Src/error_log.d \
+./Core/Src/error_recovery.d \
+./Core/Src/flow_meter.d \
+./Core/Src/fmt.d \
+./Core/Src/gallon_inventory.d \
 ./Core/Src/gpio.d \
 ./Core/Src/iwdg.d \
+./Core/Src/latency_trace.d \
+./Core/Src/leak_detect.d \
+./Core/Src/low_power.d \
 ./Core/Src/main.d \
+./Core/Src/mem_pool.d \
+./Core/Src/power_governor.d \
+./Core/Src/pump_current.d \
+./Core/Src/pump_health.d \
+./Core/Src/pump_safety.d \
+./Core/Src/refill_policy.d \
 ./Core/Src/remote_monitor.d \
+./Core/Src/sensor_health.d \
 ./Core/Src/sensors.d \
+./Core/Src/stack_monitor.d \
+./Core/Src/start_limiter.d \
 ./Core/Src/state_machine.d \
 ./Core/Src/stm32f1xx_hal_msp.d \
 ./Core/Src/stm32f1xx_hal_timebase_tim.d \
 ./Core/Src/stm32f1xx_it.d \
+./Core/Src/supervisor.d \
 ./Core/Src/syscalls.d \
 ./Core/Src/sysmem.d \
 ./Core/Src/system_stm32f1xx.d \
-./Core/Src/usage_stats.d 
+./Core/Src/timebase.d \
+./Core/Src/usage_stats.d \
+./Core/Src/warm_restart.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -66,7 +138,7 @@ Core/Src/%.o Core/Src/%.su Core/Src/%.cyclo: ../Core/Src/%.c Core/Src/subdir.mk
 clean: clean-Core-2f-Src
 
 clean-Core-2f-Src:
-	-$(RM) ./Core/Src/battery_monitor.cyclo ./Core/Src/battery_monitor.d ./Core/Src/battery_monitor.o ./Core/Src/battery_monitor.su ./Core/Src/config_storage.cyclo ./Core/Src/config_storage.d ./Core/Src/config_storage.o ./Core/Src/config_storage.su ./Core/Src/error_log.cyclo ./Core/Src/error_log.d ./Core/Src/error_log.o ./Core/Src/error_log.su ./Core/Src/gpio.cyclo ./Core/Src/gpio.d ./Core/Src/gpio.o ./Core/Src/gpio.su ./Core/Src/iwdg.cyclo ./Core/Src/iwdg.d ./Core/Src/iwdg.o ./Core/Src/iwdg.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/remote_monitor.cyclo ./Core/Src/remote_monitor.d ./Core/Src/remote_monitor.o ./Core/Src/remote_monitor.su ./Core/Src/sensors.cyclo ./Core/Src/sensors.d ./Core/Src/sensors.o ./Core/Src/sensors.su ./Core/Src/state_machine.cyclo ./Core/Src/state_machine.d ./Core/Src/state_machine.o ./Core/Src/state_machine.su ./Core/Src/stm32f1xx_hal_msp.cyclo ./Core/Src/stm32f1xx_hal_msp.d ./Core/Src/stm32f1xx_hal_msp.o ./Core/Src/stm32f1xx_hal_msp.su ./Core/Src/stm32f1xx_hal_timebase_tim.cyclo ./Core/Src/stm32f1xx_hal_timebase_tim.d ./Core/Src/stm32f1xx_hal_timebase_tim.o ./Core/Src/stm32f1xx_hal_timebase_tim.su ./Core/Src/stm32f1xx_it.cyclo ./Core/Src/stm32f1xx_it.d ./Core/Src/stm32f1xx_it.o ./Core/Src/stm32f1xx_it.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f1xx.cyclo ./Core/Src/system_stm32f1xx.d ./Core/Src/system_stm32f1xx.o ./Core/Src/system_stm32f1xx.su ./Core/Src/usage_stats.cyclo ./Core/Src/usage_stats.d ./Core/Src/usage_stats.o ./Core/Src/usage_stats.su
+	-$(RM) ./Core/Src/adc_sampler.cyclo ./Core/Src/adc_sampler.d ./Core/Src/adc_sampler.o ./Core/Src/adc_sampler.su ./Core/Src/battery_monitor.cyclo ./Core/Src/battery_monitor.d ./Core/Src/battery_monitor.o ./Core/Src/battery_monitor.su ./Core/Src/checkpoint.cyclo ./Core/Src/checkpoint.d ./Core/Src/checkpoint.o ./Core/Src/checkpoint.su ./Core/Src/config_storage.cyclo ./Core/Src/config_storage.d ./Core/Src/config_storage.o ./Core/Src/config_storage.su ./Core/Src/crash_dump.cyclo ./Core/Src/crash_dump.d ./Core/Src/crash_dump.o ./Core/Src/crash_dump.su ./Core/Src/current_detector.cyclo ./Core/Src/current_detector.d ./Core/Src/current_detector.o ./Core/Src/current_detector.su ./Core/Src/deferred_log.cyclo ./Core/Src/deferred_log.d ./Core/Src/deferred_log.o ./Core/Src/deferred_log.su ./Core/Src/error_log.cyclo ./Core/Src/error_log.d ./Core/Src/error_log.o ./Core/Src/error_log.su ./Core/Src/error_recovery.cyclo ./Core/Src/error_recovery.d ./Core/Src/error_recovery.o ./Core/Src/error_recovery.su ./Core/Src/flow_meter.cyclo ./Core/Src/flow_meter.d ./Core/Src/flow_meter.o ./Core/Src/flow_meter.su ./Core/Src/fmt.cyclo ./Core/Src/fmt.d ./Core/Src/fmt.o ./Core/Src/fmt.su ./Core/Src/gallon_inventory.cyclo ./Core/Src/gallon_inventory.d ./Core/Src/gallon_inventory.o ./Core/Src/gallon_inventory.su ./Core/Src/gpio.cyclo ./Core/Src/gpio.d ./Core/Src/gpio.o ./Core/Src/gpio.su ./Core/Src/iwdg.cyclo ./Core/Src/iwdg.d ./Core/Src/iwdg.o ./Core/Src/iwdg.su ./Core/Src/latency_trace.cyclo ./Core/Src/latency_trace.d ./Core/Src/latency_trace.o ./Core/Src/latency_trace.su ./Core/Src/leak_detect.cyclo ./Core/Src/leak_detect.d ./Core/Src/leak_detect.o ./Core/Src/leak_detect.su ./Core/Src/low_power.cyclo ./Core/Src/low_power.d ./Core/Src/low_power.o ./Core/Src/low_power.su ./Core/Src/main.cyclo ./Core/Src/main.d ./Core/Src/main.o ./Core/Src/main.su ./Core/Src/mem_pool.cyclo ./Core/Src/mem_pool.d ./Core/Src/mem_pool.o ./Core/Src/mem_pool.su ./Core/Src/power_governor.cyclo ./Core/Src/power_governor.d ./Core/Src/power_governor.o ./Core/Src/power_governor.su ./Core/Src/pump_current.cyclo ./Core/Src/pump_current.d ./Core/Src/pump_current.o ./Core/Src/pump_current.su ./Core/Src/pump_health.cyclo ./Core/Src/pump_health.d ./Core/Src/pump_health.o ./Core/Src/pump_health.su ./Core/Src/pump_safety.cyclo ./Core/Src/pump_safety.d ./Core/Src/pump_safety.o ./Core/Src/pump_safety.su ./Core/Src/refill_policy.cyclo ./Core/Src/refill_policy.d ./Core/Src/refill_policy.o ./Core/Src/refill_policy.su ./Core/Src/remote_monitor.cyclo ./Core/Src/remote_monitor.d ./Core/Src/remote_monitor.o ./Core/Src/remote_monitor.su ./Core/Src/sensor_health.cyclo ./Core/Src/sensor_health.d ./Core/Src/sensor_health.o ./Core/Src/sensor_health.su ./Core/Src/sensors.cyclo ./Core/Src/sensors.d ./Core/Src/sensors.o ./Core/Src/sensors.su ./Core/Src/stack_monitor.cyclo ./Core/Src/stack_monitor.d ./Core/Src/stack_monitor.o ./Core/Src/stack_monitor.su ./Core/Src/start_limiter.cyclo ./Core/Src/start_limiter.d ./Core/Src/start_limiter.o ./Core/Src/start_limiter.su ./Core/Src/state_machine.cyclo ./Core/Src/state_machine.d ./Core/Src/state_machine.o ./Core/Src/state_machine.su ./Core/Src/stm32f1xx_hal_msp.cyclo ./Core/Src/stm32f1xx_hal_msp.d ./Core/Src/stm32f1xx_hal_msp.o ./Core/Src/stm32f1xx_hal_msp.su ./Core/Src/stm32f1xx_hal_timebase_tim.cyclo ./Core/Src/stm32f1xx_hal_timebase_tim.d ./Core/Src/stm32f1xx_hal_timebase_tim.o ./Core/Src/stm32f1xx_hal_timebase_tim.su ./Core/Src/stm32f1xx_it.cyclo ./Core/Src/stm32f1xx_it.d ./Core/Src/stm32f1xx_it.o ./Core/Src/stm32f1xx_it.su ./Core/Src/supervisor.cyclo ./Core/Src/supervisor.d ./Core/Src/supervisor.o ./Core/Src/supervisor.su ./Core/Src/syscalls.cyclo ./Core/Src/syscalls.d ./Core/Src/syscalls.o ./Core/Src/syscalls.su ./Core/Src/sysmem.cyclo ./Core/Src/sysmem.d ./Core/Src/sysmem.o ./Core/Src/sysmem.su ./Core/Src/system_stm32f1xx.cyclo ./Core/Src/system_stm32f1xx.d ./Core/Src/system_stm32f1xx.o ./Core/Src/system_stm32f1xx.su ./Core/Src/timebase.cyclo ./Core/Src/timebase.d ./Core/Src/timebase.o ./Core/Src/timebase.su ./Core/Src/usage_stats.cyclo ./Core/Src/usage_stats.d ./Core/Src/usage_stats.o ./Core/Src/usage_stats.su ./Core/Src/warm_restart.cyclo ./Core/Src/warm_restart.d ./Core/Src/warm_restart.o ./Core/Src/warm_restart.su
 
 .PHONY: clean-Core-2f-Src
 
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Post-mortem report for crash records sent by the remote monitor.
+
+Reads the UART log (a file or stdin), picks the {"crash":...} line and the
+{"crash_ev":...} lines after it, resolves PC and LR to function and source
+line with arm-none-eabi-addr2line, and spells out the CFSR / HFSR bits.
+
+Usage:
+    python3 Tools/crash_symbolize.py --elf "Release/WATER DISPENSERS ARM M3 32BIT.elf" uart.log
+    python3 Tools/crash_symbolize.py --elf firmware.elf < uart.log
+"""
+
+import argparse
+import json
+import subprocess
+import sys
+
+# Configurable fault status register: MMFSR [7:0], BFSR [15:8], UFSR [31:16]
+CFSR_BITS = {
+    0: "IACCVIOL: instruction fetch from a no-execute region",
+    1: "DACCVIOL: data access violation (MMFAR)",
+    3: "MUNSTKERR: MemManage fault on exception return unstacking",
+    4: "MSTKERR: MemManage fault on exception entry stacking",
+    7: "MMARVALID: MMFAR holds the fault address",
+    8: "IBUSERR: instruction fetch bus error",
+    9: "PRECISERR: precise data bus error (BFAR)",
+    10: "IMPRECISERR: imprecise data bus error (PC is after the access)",
+    11: "UNSTKERR: bus fault on exception return unstacking",
+    12: "STKERR: bus fault on exception entry stacking (stack overflow?)",
+    15: "BFARVALID: BFAR holds the fault address",
+    16: "UNDEFINSTR: undefined instruction",
+    17: "INVSTATE: invalid EPSR state (Thumb bit clear - bad function pointer?)",
+    18: "INVPC: invalid EXC_RETURN on exception return",
+    19: "NOCP: coprocessor access (no FPU on Cortex-M3)",
+    24: "UNALIGNED: unaligned access with UNALIGN_TRP set",
+    25: "DIVBYZERO: divide by zero with DIV_0_TRP set",
+}
+
+HFSR_BITS = {
+    1: "VECTTBL: bus fault on vector table read",
+    30: "FORCED: configurable fault escalated to HardFault",
+    31: "DEBUGEVT: debug event",
+}
+
+TRACE_TYPES = {0: "edge", 1: "actuator", 2: "state"}
+
+
+def addr2line(elf, addr):
+    """Function and file:line for one address, or '?' without a toolchain."""
+    try:
+        out = subprocess.run(
+            ["arm-none-eabi-addr2line", "-f", "-C", "-e", elf, addr],
+            capture_output=True, text=True, check=True).stdout.split("\n")
+        return "%s at %s" % (out[0].strip(), out[1].strip())
+    except (OSError, subprocess.CalledProcessError, IndexError):
+        return "?"
+
+
+def decode_bits(value, table):
+    return [text for bit, text in sorted(table.items()) if value & (1 << bit)]
+
+
+def parse_log(lines):
+    """Newest crash line and the event lines that follow it."""
+    crash, events = None, []
+    for line in lines:
+        line = line.strip()
+        if not line.startswith("{"):
+            continue
+        try:
+            obj = json.loads(line)
+        except ValueError:
+            continue
+        if "crash" in obj:
+            crash, events = obj, []
+        elif "crash_ev" in obj and crash is not None:
+            events.append(obj)
+    return crash, events
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--elf", required=True, help="firmware ELF the log was captured with")
+    parser.add_argument("log", nargs="?", help="UART log (default: stdin)")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, encoding="utf-8", errors="replace") as f:
+            crash, events = parse_log(f)
+    else:
+        crash, events = parse_log(sys.stdin)
+
+    if crash is None:
+        print("No crash record in the log")
+        return 1
+
+    cfsr = int(crash["cfsr"], 16)
+    hfsr = int(crash["hfsr"], 16)
+
+    print("%s fault #%d%s, state %s, %d ms after boot" % (
+        crash["crash"], crash["seq"], " (this boot)" if crash["new"] else "",
+        crash["state"], crash["t_ms"]))
+    print("  pc  %s  %s" % (crash["pc"], addr2line(args.elf, crash["pc"])))
+    print("  lr  %s  %s" % (crash["lr"], addr2line(args.elf, crash["lr"])))
+    print("  sp  %s" % crash["sp"])
+    print("  cfsr %s" % crash["cfsr"])
+    for text in decode_bits(cfsr, CFSR_BITS):
+        print("    " + text)
+    if cfsr & (1 << 15):
+        print("    bus fault address %s" % crash["bfar"])
+    if cfsr & (1 << 7):
+        print("    memmanage fault address %s" % crash["mmfar"])
+    print("  hfsr %s" % crash["hfsr"])
+    for text in decode_bits(hfsr, HFSR_BITS):
+        print("    " + text)
+
+    if events:
+        print("  last trace events (oldest first):")
+        for ev in events:
+            print("    %-8s arg %-3d id %-5d cyc %d" % (
+                TRACE_TYPES.get(ev["type"], str(ev["type"])), ev["arg"], ev["id"], ev["cyc"]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
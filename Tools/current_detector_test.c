@@ -0,0 +1,179 @@
+/**
+  ******************************************************************************
+  * @file           : current_detector_test.c
+  * @brief          : Host test of Core/Src/current_detector.c on synthetic traces
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Feeds 32 ms block means, as PumpCurrent_Process() does, through
+  * CurrentDetector_Update() with the tuning of config.h. Each trace starts
+  * with the motor inrush and carries a little noise. Normal fills must not
+  * trip; dry and stalled pumps, from the start or from a point in the fill,
+  * must trip with the right verdict, not before the hold time and no later
+  * than blanking + hold + the settling of the moving average. The same
+  * traces are then run against a learned running current, where the
+  * thresholds become relative.
+  *
+  * Build and run from the repository root:
+  *   gcc -O2 -ITools/host -ICore/Inc -o current_detector_test Tools/current_detector_test.c \
+  *       Core/Src/current_detector.c && ./current_detector_test
+  ******************************************************************************
+  */
+
+#include "current_detector.h"
+#include "adc_sampler.h"
+#include <stdio.h>
+
+#define BLOCK_MS              ADC_SAMPLER_BLOCK_MS
+#define FILL_MS               60000U
+#define NOMINAL_MA            800U
+#define NOISE_MA              40U       // Peak, uniform
+#define INRUSH_MA             2600U     // Decays to the running current over INRUSH_MS
+#define INRUSH_MS             300U
+#define SETTLE_BLOCKS         6U        // Average within a few % of a step (1/4 per block)
+#define NO_FAULT              0xFFFFFFFFUL
+
+static const CurrentDetectorParams_t params = {
+  .dry_mA       = PUMP_CURRENT_DRY_MA,
+  .stall_mA     = PUMP_CURRENT_STALL_MA,
+  .dryPercent   = PUMP_CURRENT_DRY_PERCENT,
+  .stallPercent = PUMP_CURRENT_STALL_PERCENT,
+  .blank_ms     = PUMP_CURRENT_BLANK_MS,
+  .dryHold_ms   = PUMP_CURRENT_DRY_HOLD_MS,
+  .stallHold_ms = PUMP_CURRENT_STALL_HOLD_MS,
+  .avgShift     = PUMP_CURRENT_AVG_SHIFT,
+};
+
+typedef struct {
+  const char* name;
+  uint16_t run_mA;              // Running current before the change
+  uint16_t after_mA;            // Running current from changeAt_ms on
+  uint32_t changeAt_ms;
+  CurrentFault_t want;
+} Trace_t;
+
+static uint32_t rng = 1;
+static unsigned failures = 0;
+
+static uint32_t Random(void)
+{
+  rng = rng * 1664525UL + 1013904223UL;
+  return rng >> 8;
+}
+
+static uint16_t Sample(const Trace_t* t, uint32_t time_ms)
+{
+  int32_t mA = (time_ms >= t->changeAt_ms) ? t->after_mA : t->run_mA;
+
+  // Inrush of a started motor; a blocked rotor stays at the stall current
+  if(time_ms < INRUSH_MS && mA < (int32_t)INRUSH_MA) {
+    mA = (int32_t)INRUSH_MA - (int32_t)((INRUSH_MA - (uint32_t)mA) * time_ms / INRUSH_MS);
+  }
+  mA += (int32_t)(Random() % (2U * NOISE_MA + 1U)) - (int32_t)NOISE_MA;
+
+  return (uint16_t)(mA < 0 ? 0 : mA);
+}
+
+/**
+  * Run one fill, return the time of the first fault (NO_FAULT if none)
+  */
+static uint32_t RunFill(CurrentDetector_t* det, const Trace_t* t, CurrentFault_t* fault)
+{
+  CurrentDetector_Start(det);
+  *fault = CURRENT_FAULT_NONE;
+
+  for(uint32_t time_ms = 0; time_ms < FILL_MS; time_ms += BLOCK_MS) {
+    *fault = CurrentDetector_Update(det, Sample(t, time_ms), BLOCK_MS);
+    if(*fault != CURRENT_FAULT_NONE) {
+      return time_ms + BLOCK_MS;
+    }
+  }
+  return NO_FAULT;
+}
+
+static void Check(const char* label, CurrentDetector_t* det, const Trace_t* t)
+{
+  static const char* const names[] = { "none", "dry", "stall" };
+  CurrentFault_t fault;
+  uint32_t at = RunFill(det, t, &fault);
+
+  if(t->want == CURRENT_FAULT_NONE) {
+    printf("%-8s %-18s %-5s (want none)\n", label, t->name, names[fault]);
+    if(fault != CURRENT_FAULT_NONE) {
+      printf("FAIL %s: tripped %s at %lu ms\n", t->name, names[fault], (unsigned long)at);
+      failures++;
+    }
+    return;
+  }
+
+  // Counting starts when the condition begins, or after blanking if earlier
+  uint32_t hold = (t->want == CURRENT_FAULT_DRY) ? params.dryHold_ms : params.stallHold_ms;
+  uint32_t from = (t->changeAt_ms > params.blank_ms) ? t->changeAt_ms : params.blank_ms;
+  uint32_t latest = from + hold + (SETTLE_BLOCKS + 1U) * BLOCK_MS;
+  uint32_t latency = (at == NO_FAULT) ? 0U : at - t->changeAt_ms;
+
+  printf("%-8s %-18s %-5s after %5lu ms (want %s, %lu..%lu ms)\n", label, t->name, names[fault],
+         (unsigned long)latency, names[t->want], (unsigned long)(from + hold - t->changeAt_ms),
+         (unsigned long)(latest - t->changeAt_ms));
+  if(fault != t->want || at < from + hold || at > latest) {
+    printf("FAIL %s: wrong verdict or latency\n", t->name);
+    failures++;
+  }
+}
+
+int main(void)
+{
+  // Absolute thresholds: 250 mA dry, 2000 mA stall
+  static const Trace_t fresh[] = {
+    { "normal",           NOMINAL_MA, NOMINAL_MA, 0,     CURRENT_FAULT_NONE  },
+    { "normal, low load", 400,        400,        0,     CURRENT_FAULT_NONE  },
+    { "dry from start",   150,        150,        0,     CURRENT_FAULT_DRY   },
+    { "runs dry at 20 s", NOMINAL_MA, 150,        20000, CURRENT_FAULT_DRY   },
+    { "stall from start", 2600,       2600,       0,     CURRENT_FAULT_STALL },
+    { "stall at 20 s",    NOMINAL_MA, 2600,       20000, CURRENT_FAULT_STALL },
+  };
+  // Relative to the learned 800 mA: below 560 mA dry, above 1440 mA stall
+  static const Trace_t learned[] = {
+    { "normal",           NOMINAL_MA, NOMINAL_MA, 0,     CURRENT_FAULT_NONE  },
+    { "half load, 20 s",  NOMINAL_MA, 480,        20000, CURRENT_FAULT_DRY   },
+    { "jam 1.6 A, 20 s",  NOMINAL_MA, 1600,       20000, CURRENT_FAULT_STALL },
+  };
+  CurrentDetector_t det;
+  CurrentFault_t fault;
+
+  printf("%u ms blocks, blank %u ms, dry hold %u ms, stall hold %u ms\n", (unsigned)BLOCK_MS,
+         (unsigned)params.blank_ms, (unsigned)params.dryHold_ms, (unsigned)params.stallHold_ms);
+
+  CurrentDetector_Init(&det, &params);
+  for(unsigned i = 0; i < sizeof(fresh) / sizeof(fresh[0]); i++) {
+    Check("absolute", &det, &fresh[i]);
+  }
+  // The same mild faults go unnoticed before anything is learned
+  for(unsigned i = 1; i < sizeof(learned) / sizeof(learned[0]); i++) {
+    Trace_t t = learned[i];
+    t.want = CURRENT_FAULT_NONE;
+    Check("absolute", &det, &t);
+  }
+
+  // Complete fills teach the running current; a faulted one must not
+  CurrentDetector_Init(&det, &params);
+  for(int fill = 0; fill < 3; fill++) {
+    RunFill(&det, &learned[0], &fault);
+    CurrentDetector_LearnNominal(&det);
+  }
+  uint16_t nominal = det.nominal_mA;
+  RunFill(&det, &fresh[3], &fault);
+  CurrentDetector_LearnNominal(&det);
+  printf("learned  %u mA (want %u +/- 10)\n", (unsigned)nominal, (unsigned)NOMINAL_MA);
+  if(nominal + 10U < NOMINAL_MA || nominal > NOMINAL_MA + 10U || det.nominal_mA != nominal) {
+    printf("FAIL learning: nominal %u mA after good fills, %u mA after a dry one\n",
+           (unsigned)nominal, (unsigned)det.nominal_mA);
+    failures++;
+  }
+
+  for(unsigned i = 0; i < sizeof(learned) / sizeof(learned[0]); i++) {
+    Check("learned", &det, &learned[i]);
+  }
+
+  printf("checks: %s\n", failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,137 @@
+/**
+  ******************************************************************************
+  * @file           : fmt_bench.c
+  * @brief          : Host check and benchmark of Core/Src/fmt.c against sprintf
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Checks Fmt_U32 / Fmt_I32 / Fmt_Hex32 / Fmt_Fixed against printf on edge
+  * cases and a pseudo-random sweep, builds the status frame both ways and
+  * compares the text, then times both. Host timings only show the relative
+  * cost; for cycles on the Cortex-M3 set FMT_BENCHMARK 1 in config.h.
+  *
+  * Build and run from the repository root:
+  *   gcc -O2 -ICore/Inc -o fmt_bench Tools/fmt_bench.c Core/Src/fmt.c && ./fmt_bench
+  ******************************************************************************
+  */
+
+#include "fmt.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_SIZE  288
+#define RUNS        1000000UL
+
+static unsigned failures = 0;
+
+static void Expect(const char* what, const char* got, size_t gotLen, const char* want)
+{
+  if(gotLen != strlen(want) || memcmp(got, want, gotLen) != 0) {
+    printf("MISMATCH %s: got '%.*s' want '%s'\n", what, (int)gotLen, got, want);
+    failures++;
+  }
+}
+
+static void CheckValue(uint32_t u)
+{
+  char got[16];
+  char want[32];
+  int32_t i = (int32_t)u;
+
+  snprintf(want, sizeof(want), "%lu", (unsigned long)u);
+  Expect("u32", got, Fmt_U32(got, u), want);
+  snprintf(want, sizeof(want), "%ld", (long)i);
+  Expect("i32", got, Fmt_I32(got, i), want);
+  snprintf(want, sizeof(want), "0x%08lx", (unsigned long)u);
+  Expect("hex", got, Fmt_Hex32(got, u), want);
+  snprintf(want, sizeof(want), "%s%ld.%03ld", i < 0 ? "-" : "",
+           (long)((i < 0 ? -(int64_t)i : i) / 1000), (long)((i < 0 ? -(int64_t)i : i) % 1000));
+  Expect("fixed", got, Fmt_Fixed(got, i, 3), want);
+}
+
+static uint16_t StatusFmt(char* buf, uint32_t cycles)
+{
+  FmtJson_t json;
+
+  Fmt_JsonBegin(&json, buf, FRAME_SIZE);
+  Fmt_JsonStr(&json, "state", "FILLING");
+  Fmt_JsonU32(&json, "err", 0);
+  Fmt_JsonU32(&json, "cycles", cycles);
+  Fmt_JsonU32(&json, "bat", 3712);
+  Fmt_JsonU32(&json, "cut_us", 4);
+  Fmt_JsonU32(&json, "health", 92);
+  Fmt_JsonI32(&json, "ttf_d", 41);
+  Fmt_JsonI32(&json, "gal_ml", 7400);
+  Fmt_JsonU32(&json, "gal_low", 0);
+  Fmt_JsonU32(&json, "flow", 1500);
+  Fmt_JsonU32(&json, "vol_ml", 86400);
+  Fmt_JsonU32(&json, "pump_ma", 640);
+  Fmt_JsonU32(&json, "starts_h", 3);
+  Fmt_JsonU32(&json, "settle_saved", 1180);
+  Fmt_JsonU32(&json, "settle_avg", 1020);
+  return Fmt_JsonEnd(&json);
+}
+
+static int StatusSprintf(char* buf, uint32_t cycles)
+{
+  return sprintf(buf, "{\"state\":\"%s\",\"err\":%d,\"cycles\":%lu,\"bat\":%d,\"cut_us\":%lu,\"health\":%d,\"ttf_d\":%d,\"gal_ml\":%ld,\"gal_low\":%d,\"flow\":%lu,\"vol_ml\":%lu,\"pump_ma\":%u,\"starts_h\":%lu,\"settle_saved\":%lu,\"settle_avg\":%lu}\r\n",
+                 "FILLING", 0, (unsigned long)cycles, 3712, 4UL, 92, 41, 7400L, 0, 1500UL, 86400UL, 640U, 3UL, 1180UL, 1020UL);
+}
+
+static double Seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+  static const uint32_t edges[] = {
+    0, 1, 9, 10, 99, 100, 999, 1000, 65535, 65536, 999999999, 1000000000,
+    2147483647UL, 2147483648UL, 4294967295UL, 4294966296UL
+  };
+  char a[FRAME_SIZE];
+  char b[FRAME_SIZE];
+  uint32_t x = 12345;
+  volatile uint32_t sink = 0;
+
+  // Correctness
+  for(size_t k = 0; k < sizeof(edges) / sizeof(edges[0]); k++) {
+    CheckValue(edges[k]);
+  }
+  for(uint32_t k = 0; k < 200000; k++) {
+    x = x * 1664525UL + 1013904223UL;
+    CheckValue(x >> (k % 32));
+  }
+  for(uint32_t k = 0; k < 1000; k++) {
+    uint16_t n = StatusFmt(a, k * 7919U);
+    StatusSprintf(b, k * 7919U);
+    Expect("status frame", a, n, b);
+  }
+  {
+    FmtJson_t json;
+    char small[16];
+    Fmt_JsonBegin(&json, small, sizeof(small));
+    Fmt_JsonStr(&json, "state", "WAIT_SETTLE");
+    if(Fmt_JsonEnd(&json) != 0) {
+      printf("MISMATCH overflow: line longer than the buffer was not dropped\n");
+      failures++;
+    }
+  }
+  printf("checks: %s\n", failures ? "FAILED" : "ok");
+
+  // Speed
+  double t0 = Seconds();
+  for(uint32_t k = 0; k < RUNS; k++) sink += StatusSprintf(b, k);
+  double t1 = Seconds();
+  for(uint32_t k = 0; k < RUNS; k++) sink += StatusFmt(a, k);
+  double t2 = Seconds();
+
+  printf("status frame (%u chars), %lu runs\n", (unsigned)strlen(b), RUNS);
+  printf("  sprintf : %6.1f ns/frame\n", (t1 - t0) * 1e9 / RUNS);
+  printf("  Fmt_Json: %6.1f ns/frame (%.1fx)\n", (t2 - t1) * 1e9 / RUNS, (t1 - t0) / (t2 - t1));
+  (void)sink;
+
+  return failures ? 1 : 0;
+}
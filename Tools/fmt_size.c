@@ -0,0 +1,62 @@
+/**
+  ******************************************************************************
+  * @file           : fmt_size.c
+  * @brief          : Cortex-M3 flash cost of the status frame: fmt.c against sprintf
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Builds the status frame once, either with Fmt_Json* or with sprintf
+  * (FMT_SIZE_SPRINTF 1), and nothing else. Linked twice with the flags of
+  * the Release build, the .text difference between the two images is what
+  * dropping newlib-nano's printf for fmt.c saves in the firmware. Cycles
+  * per frame come from FMT_BENCHMARK on the board (documentation section 21).
+  *
+  * Build both and compare from the repository root:
+  *   for v in 0 1; do arm-none-eabi-gcc -mcpu=cortex-m3 -mthumb -mfloat-abi=soft -Os \
+  *     -ffunction-sections -fdata-sections -ICore/Inc -DFMT_SIZE_SPRINTF=$v \
+  *     -o fmt_size_$v.elf Tools/fmt_size.c Core/Src/fmt.c \
+  *     --specs=nano.specs --specs=nosys.specs -Wl,--gc-sections; done
+  *   arm-none-eabi-size fmt_size_0.elf fmt_size_1.elf
+  ******************************************************************************
+  */
+
+#include "fmt.h"
+#if FMT_SIZE_SPRINTF
+#include <stdio.h>
+#endif
+
+#define FRAME_SIZE  288
+
+static char frame[FRAME_SIZE];
+volatile uint32_t sink;                 // Inputs and result, so nothing folds to a constant
+
+int main(void)
+{
+  uint32_t cycles = sink;
+
+#if FMT_SIZE_SPRINTF
+  sink = (uint32_t)sprintf(frame, "{\"state\":\"%s\",\"err\":%d,\"cycles\":%lu,\"bat\":%d,\"cut_us\":%lu,\"health\":%d,\"ttf_d\":%d,\"gal_ml\":%ld,\"gal_low\":%d,\"flow\":%lu,\"vol_ml\":%lu,\"pump_ma\":%u,\"starts_h\":%lu,\"settle_saved\":%lu,\"settle_avg\":%lu}\r\n",
+                           "FILLING", 0, (unsigned long)cycles, 3712, 4UL, 92, 41, 7400L, 0, 1500UL, 86400UL, 640U, 3UL, 1180UL, 1020UL);
+#else
+  FmtJson_t json;
+
+  Fmt_JsonBegin(&json, frame, FRAME_SIZE);
+  Fmt_JsonStr(&json, "state", "FILLING");
+  Fmt_JsonU32(&json, "err", 0);
+  Fmt_JsonU32(&json, "cycles", cycles);
+  Fmt_JsonU32(&json, "bat", 3712);
+  Fmt_JsonU32(&json, "cut_us", 4);
+  Fmt_JsonU32(&json, "health", 92);
+  Fmt_JsonI32(&json, "ttf_d", 41);
+  Fmt_JsonI32(&json, "gal_ml", 7400);
+  Fmt_JsonU32(&json, "gal_low", 0);
+  Fmt_JsonU32(&json, "flow", 1500);
+  Fmt_JsonU32(&json, "vol_ml", 86400);
+  Fmt_JsonU32(&json, "pump_ma", 640);
+  Fmt_JsonU32(&json, "starts_h", 3);
+  Fmt_JsonU32(&json, "settle_saved", 1180);
+  Fmt_JsonU32(&json, "settle_avg", 1020);
+  sink = Fmt_JsonEnd(&json);
+#endif
+
+  return (int)frame[sink & 0x7FU];
+}
@@ -0,0 +1,102 @@
+"""Firmware modules as a host library, for the Python simulations.
+
+Build compiles Core/Src modules with gcc against the HAL stand-in in this
+directory, the way the C harnesses do, and loads them with ctypes. A
+simulation therefore runs the firmware's own decisions instead of a Python
+copy of them. Overrides replace #define values in a copy of
+Core/Inc/config.h, to enable a module that is off by default or to sweep a
+setting. A module that ends up disabled builds its stubs, as on target.
+
+Each Build.load() maps a fresh copy of the library, so its static state
+starts from zero as after a reset. HAL_GetTick() returns what set_tick()
+stored; the GPIO ports are GPIOA..GPIOC.
+"""
+
+import atexit
+import ctypes
+import os
+import re
+import shutil
+import subprocess
+import tempfile
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(__file__), "..", ".."))
+HOST = os.path.join(ROOT, "Tools", "host")
+CORE_INC = os.path.join(ROOT, "Core", "Inc")
+
+_workdir = None
+_loads = 0
+
+
+class GPIO(ctypes.Structure):
+    """GPIO_TypeDef of stm32f1xx_hal.h (host)."""
+    _fields_ = [(name, ctypes.c_uint32) for name in ("CRL", "CRH", "IDR", "ODR", "BSRR", "BRR", "LCKR")]
+
+
+def _tmp():
+    global _workdir
+    if _workdir is None:
+        _workdir = tempfile.mkdtemp(prefix="fw_host_")
+        atexit.register(shutil.rmtree, _workdir, True)
+    return _workdir
+
+
+class Firmware:
+    """One loaded instance; firmware functions are attributes."""
+
+    def __init__(self, path, prototypes):
+        self.lib = ctypes.CDLL(path)
+        self._tick = ctypes.c_uint32.in_dll(self.lib, "HostTick")
+        self.gpioa = GPIO.in_dll(self.lib, "HostGPIOA")
+        self.gpiob = GPIO.in_dll(self.lib, "HostGPIOB")
+        self.gpioc = GPIO.in_dll(self.lib, "HostGPIOC")
+        for name, (restype, argtypes) in prototypes.items():
+            func = getattr(self.lib, name)
+            func.restype = restype
+            func.argtypes = argtypes
+
+    def set_tick(self, ms):
+        self._tick.value = int(ms) & 0xFFFFFFFF
+
+    def __getattr__(self, name):
+        return getattr(self.lib, name)
+
+
+class Build:
+    """Sources (relative to the repository root) compiled with config.h overrides."""
+
+    def __init__(self, sources, prototypes, overrides=None):
+        self.prototypes = prototypes
+        key = "_".join(os.path.splitext(os.path.basename(s))[0] for s in sources)
+        key += "".join(f"_{name}{value}" for name, value in sorted((overrides or {}).items()))
+        out = os.path.join(_tmp(), key)
+        self.path = os.path.join(out, "lib.so")
+        if os.path.exists(self.path):
+            return
+
+        # config.h is included as "config.h" from the headers, so the whole
+        # include directory is copied next to the patched file
+        inc = os.path.join(out, "inc")
+        shutil.copytree(CORE_INC, inc)
+        config = os.path.join(inc, "config.h")
+        with open(config, encoding="utf-8") as f:
+            text = f.read()
+        for name, value in (overrides or {}).items():
+            text, n = re.subn(rf"^(\s*#define\s+{name}\s+)\S+", rf"\g<1>{value}", text, count=1, flags=re.M)
+            if n != 1:
+                raise KeyError(f"{name} is not defined in config.h")
+        with open(config, "w", encoding="utf-8") as f:
+            f.write(text)
+
+        cmd = ["gcc", "-O2", "-shared", "-fPIC", "-I" + HOST, "-I" + inc, "-o", self.path]
+        cmd += [os.path.join(ROOT, s) for s in sources] + [os.path.join(HOST, "hal_host.c")]
+        subprocess.run(cmd, check=True)
+
+    def load(self):
+        global _loads
+        _loads += 1
+        copy = os.path.join(_tmp(), f"fw{_loads}.so")
+        shutil.copyfile(self.path, copy)
+        fw = Firmware(copy, self.prototypes)
+        os.remove(copy)             # Stays mapped
+        return fw
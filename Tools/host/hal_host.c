@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * @file           : hal_host.c
+  * @brief          : Registers and HAL functions behind Tools/host/stm32f1xx_hal.h
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  */
+
+#include "stm32f1xx_hal.h"
+#include <stdlib.h>
+
+GPIO_TypeDef HostGPIOA, HostGPIOB, HostGPIOC;
+DWT_Type HostDWT;
+CoreDebug_Type HostCoreDebug;
+volatile uint32_t HostTick;
+uint32_t SystemCoreClock = 8000000U;
+
+uint32_t HAL_GetTick(void)
+{
+  return HostTick;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init)
+{
+  (void)GPIOx;
+  (void)GPIO_Init;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+  return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+  if(PinState == GPIO_PIN_SET) {
+    GPIOx->ODR |= GPIO_Pin;
+  } else {
+    GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+  }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin)
+{
+  GPIOx->ODR ^= GPIO_Pin;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef* RCC_ClkInitStruct, uint32_t FLatency)
+{
+  (void)FLatency;
+  switch(RCC_ClkInitStruct->AHBCLKDivider) {
+    case RCC_SYSCLK_DIV2: SystemCoreClock = HSI_VALUE / 2U; break;
+    case RCC_SYSCLK_DIV4: SystemCoreClock = HSI_VALUE / 4U; break;
+    default:              SystemCoreClock = HSI_VALUE;      break;
+  }
+  return HAL_OK;
+}
+
+// main.c's, for the modules that call it
+void Error_Handler(void)
+{
+  abort();
+}
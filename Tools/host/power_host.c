@@ -0,0 +1,37 @@
+/**
+  ******************************************************************************
+  * @file           : power_host.c
+  * @brief          : Neighbours of power_governor.c for Tools/power_sim.py
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * The battery reading is HostBattery_mV, which the simulation sets before
+  * each PowerGov_Process(). HostPump_Set() drives the pump pin through the
+  * config.h macros, so PUMP_IS_ON() follows the relay polarity. The clock
+  * users only have to exist: SystemCoreClock carries the profile clock.
+  ******************************************************************************
+  */
+
+#include "battery_monitor.h"
+#include "adc_sampler.h"
+#include "remote_monitor.h"
+#include "supervisor.h"
+
+volatile uint16_t HostBattery_mV;
+
+uint16_t Battery_GetVoltage_mV(void)
+{
+  return HostBattery_mV;
+}
+
+void HostPump_Set(uint8_t on)
+{
+  if(on) {
+    PUMP_ON();
+  } else {
+    PUMP_OFF();
+  }
+}
+
+void AdcSampler_ClockChanged(void) {}
+void Remote_ClockChanged(void) {}
+void Supervisor_ClockChanged(void) {}
@@ -0,0 +1,155 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f1xx_hal.h (host)
+  * @brief          : Host stand-in for the HAL, for the Tools/ harnesses
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Put Tools/host ahead of Core/Inc on the include path and the firmware
+  * modules compile for the host unchanged: Core/Inc/main.h picks up this
+  * file instead of the HAL. Only what the modules under test touch is here.
+  * Registers are plain structs in hal_host.c that the harness drives:
+  * HostTick is the HAL tick, HostDWT.CYCCNT the cycle counter, and the
+  * input pins read GPIOx->IDR. firmware.py builds modules the same way into
+  * a library for the Python simulations. HAL_RCC_ClockConfig() only moves
+  * SystemCoreClock.
+  *
+  * Interrupt masking is a no-op and LDREX/STREX always succeed: the
+  * harnesses are single threaded, except seqlock_stress.c, which brings its
+  * own SEQLOCK_BARRIER().
+  ******************************************************************************
+  */
+
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* HAL types -----------------------------------------------------------------*/
+typedef enum {
+  HAL_OK = 0,
+  HAL_ERROR,
+  HAL_BUSY,
+  HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum {
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef enum {
+  EXTI0_IRQn = 6,
+  EXTI1_IRQn = 7,
+  EXTI2_IRQn = 8
+} IRQn_Type;
+
+typedef struct {
+  volatile uint32_t CRL, CRH, IDR, ODR, BSRR, BRR, LCKR;
+} GPIO_TypeDef;
+
+typedef struct {
+  uint32_t Pin;
+  uint32_t Mode;
+  uint32_t Pull;
+  uint32_t Speed;
+} GPIO_InitTypeDef;
+
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+  uint32_t ClockType;
+  uint32_t SYSCLKSource;
+  uint32_t AHBCLKDivider;
+  uint32_t APB1CLKDivider;
+  uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+/* Registers -----------------------------------------------------------------*/
+extern GPIO_TypeDef HostGPIOA, HostGPIOB, HostGPIOC;
+extern DWT_Type HostDWT;
+extern CoreDebug_Type HostCoreDebug;
+extern volatile uint32_t HostTick;
+extern uint32_t SystemCoreClock;
+
+#define GPIOA                         (&HostGPIOA)
+#define GPIOB                         (&HostGPIOB)
+#define GPIOC                         (&HostGPIOC)
+#define DWT                           (&HostDWT)
+#define CoreDebug                     (&HostCoreDebug)
+
+#define DWT_CTRL_CYCCNTENA_Msk        (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk    (1UL << 24)
+
+/* GPIO ----------------------------------------------------------------------*/
+#define GPIO_PIN_0                    ((uint16_t)0x0001)
+#define GPIO_PIN_1                    ((uint16_t)0x0002)
+#define GPIO_PIN_2                    ((uint16_t)0x0004)
+#define GPIO_PIN_3                    ((uint16_t)0x0008)
+#define GPIO_PIN_4                    ((uint16_t)0x0010)
+#define GPIO_PIN_5                    ((uint16_t)0x0020)
+#define GPIO_PIN_6                    ((uint16_t)0x0040)
+#define GPIO_PIN_7                    ((uint16_t)0x0080)
+#define GPIO_PIN_8                    ((uint16_t)0x0100)
+#define GPIO_PIN_9                    ((uint16_t)0x0200)
+#define GPIO_PIN_10                   ((uint16_t)0x0400)
+#define GPIO_PIN_11                   ((uint16_t)0x0800)
+#define GPIO_PIN_12                   ((uint16_t)0x1000)
+#define GPIO_PIN_13                   ((uint16_t)0x2000)
+#define GPIO_PIN_14                   ((uint16_t)0x4000)
+#define GPIO_PIN_15                   ((uint16_t)0x8000)
+
+#define GPIO_MODE_INPUT               0x00000000U
+#define GPIO_MODE_OUTPUT_PP           0x00000001U
+#define GPIO_MODE_AF_PP               0x00000002U
+#define GPIO_MODE_ANALOG              0x00000003U
+#define GPIO_NOPULL                   0x00000000U
+#define GPIO_PULLUP                   0x00000001U
+#define GPIO_PULLDOWN                 0x00000002U
+#define GPIO_SPEED_FREQ_LOW           0x00000002U
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()  ((void)0)
+
+/* RCC -----------------------------------------------------------------------*/
+#define RCC_CLOCKTYPE_SYSCLK          0x00000001U
+#define RCC_CLOCKTYPE_HCLK            0x00000002U
+#define RCC_CLOCKTYPE_PCLK1           0x00000004U
+#define RCC_CLOCKTYPE_PCLK2           0x00000008U
+#define RCC_SYSCLKSOURCE_HSI          0x00000000U
+#define RCC_SYSCLK_DIV1               0x00000000U
+#define RCC_SYSCLK_DIV2               0x00000080U
+#define RCC_SYSCLK_DIV4               0x00000090U
+#define RCC_HCLK_DIV1                 0x00000000U
+#define FLASH_LATENCY_0               0x00000000U
+#define HSI_VALUE                     8000000U
+
+/* Core ----------------------------------------------------------------------*/
+static inline uint32_t __get_PRIMASK(void) { return 0U; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) { }
+static inline void __enable_irq(void) { }
+static inline void __DMB(void) { __sync_synchronize(); }
+static inline void __DSB(void) { __sync_synchronize(); }
+static inline void __ISB(void) { __sync_synchronize(); }
+static inline uint32_t __LDREXW(volatile uint32_t* addr) { return *addr; }
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t* addr) { *addr = value; return 0U; }
+static inline void __CLREX(void) { }
+
+/* HAL functions (hal_host.c) ------------------------------------------------*/
+uint32_t HAL_GetTick(void);
+void HAL_GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_Init);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef* RCC_ClkInitStruct, uint32_t FLatency);
+
+#endif /* __STM32F1xx_HAL_H */
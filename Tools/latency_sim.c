@@ -0,0 +1,257 @@
+/**
+  ******************************************************************************
+  * @file           : latency_sim.c
+  * @brief          : Host simulation of sensor edge to pump-off latency
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * Runs Core/Src/latency_trace.c against a simulated DWT counter while a
+  * model of the FILLING main loop runs: a control pass every 10 ms, then
+  * the blocking telemetry transmits of main.c (status frame every
+  * REMOTE_STATUS_INTERVAL, one report line per pass every
+  * REMOTE_LATENCY_INTERVAL, at REMOTE_BAUD_RATE). Door, tank-full and
+  * overflow edges arrive at random times. Edges closed by the ISR cutoff
+  * (ENABLE_ISR_PUMP_CUTOFF) cost exception entry plus the cutoff ISR;
+  * the others wait for StateMachine_Process() in the next control pass.
+  *
+  * For each path it prints the p50/p99/max that the firmware would report,
+  * and checks them against the exact values of the same samples, the event
+  * ring against the correlation IDs, and p99 against a latency budget.
+  * Pass costs are estimates (see the model constants); the loop structure,
+  * intervals and frame sizes come from main.c and config.h. Exits 1 on any
+  * failure, so a change that stretches the main loop shows up here before
+  * it is flashed.
+  *
+  * Build and run from the repository root:
+  *   gcc -O2 -ITools/host -ICore/Inc -o latency_sim Tools/latency_sim.c \
+  *       Core/Src/latency_trace.c Tools/host/hal_host.c -lm && ./latency_sim
+  ******************************************************************************
+  */
+
+#include "latency_trace.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Model constants (8 MHz HSI) -----------------------------------------------*/
+#define CORE_HZ               8000000ULL
+#define CYC_PER_MS            (CORE_HZ / 1000ULL)
+#define CONTROL_PERIOD_MS     10U       // main.c loopInterval in FILLING
+#define IRQ_ENTRY_CYCLES      12U       // CYCLE_COUNTER_IRQ_ENTRY_CYCLES
+#define ISR_CUTOFF_CYCLES     28U       // Entry to PUMP_OFF_ISR in the cutoff ISR (~5 us total)
+#define ISR_EDGE_CYCLES       400U      // Door edge ISR: trace, sensor health, EXTI callback
+#define PASS_BEFORE_SM_CYC    200U      // FlowMeter_Sample + PumpCurrent_Process
+#define PASS_AFTER_SM_CYC     1600U     // LEDs .. LeakDetect_Process (stack scan ~20 us)
+#define SPIN_CYC              120U      // One main loop turn without a control pass
+#define STATUS_BYTES          (REMOTE_FRAME_SIZE - 8U)  // Worst-case status line
+#define REPORT_BYTES          (REMOTE_FRAME_SIZE / 2U)  // One report line per pass
+#define MEAN_EDGE_GAP_MS      700U
+
+/* Budgets -------------------------------------------------------------------*/
+#define ISR_BUDGET_US         10U       // 2x the ~5 us of the cutoff table (section 5)
+#define LOOP_BUDGET_US        50000U    // Top of the 10-50 ms main loop row (section 5)
+
+#define SAMPLES_MAX           100000U
+
+typedef struct {
+  uint32_t us[SAMPLES_MAX];
+  uint32_t n;
+} Samples_t;
+
+static uint64_t now;                    // Simulated core cycles
+static uint64_t nextEdge;
+static uint32_t rng = 1;
+static Samples_t exact[LATENCY_PATH_COUNT];
+static int pendingPath = -1;            // Edge waiting for the state machine
+static uint64_t pendingAt;
+static unsigned failures = 0;
+
+static uint32_t Random(void)
+{
+  rng = rng * 1664525UL + 1013904223UL;
+  return rng >> 8;
+}
+
+static uint64_t ExpGap(void)
+{
+  double u = ((double)Random() + 1.0) / 16777217.0;
+  double ms = -(double)MEAN_EDGE_GAP_MS * log(u);
+  return (uint64_t)(ms * (double)CYC_PER_MS);
+}
+
+static void SetClock(uint64_t cycles)
+{
+  HostDWT.CYCCNT = (uint32_t)cycles;
+  HostTick = (uint32_t)(cycles / CYC_PER_MS);
+}
+
+static void Record(LatencyPath_t path, uint64_t edge, uint16_t id)
+{
+  TraceEvent_t ev[3];
+  Samples_t* s = &exact[path];
+
+  if(s->n < SAMPLES_MAX) {
+    s->us[s->n++] = (uint32_t)((now - edge) / (CORE_HZ / 1000000ULL));
+  }
+
+  // Edge, pump off and state change carry the same ID, in that order
+  LatencyTrace_MarkState((uint8_t)(path + 1U));
+  if(LatencyTrace_GetRecentEvents(ev, 3) != 3 || id == 0 ||
+     ev[0].type != TRACE_EVENT_EDGE || ev[1].type != TRACE_EVENT_ACTUATE || ev[2].type != TRACE_EVENT_STATE ||
+     ev[0].correlationId != id || ev[1].correlationId != id || ev[2].correlationId != id) {
+    printf("FAIL %s: event ring does not tie edge %u to its pump-off\n", LatencyTrace_GetPathName(path), id);
+    failures++;
+  }
+}
+
+static uint8_t IsrCutoff(LatencyPath_t path)
+{
+  return (ENABLE_ISR_PUMP_CUTOFF && path != LATENCY_PATH_DOOR_OPEN) ? 1 : 0;
+}
+
+/**
+  * Sensor edge: the EXTI handler preempts whatever the main loop does
+  */
+static uint64_t EdgeIsr(uint64_t edge)
+{
+  LatencyPath_t path = (LatencyPath_t)(Random() % LATENCY_PATH_COUNT);
+  uint64_t entry = edge + IRQ_ENTRY_CYCLES;
+
+  SetClock(entry);
+  LatencyTrace_MarkEdge(path, (uint32_t)(entry - IRQ_ENTRY_CYCLES));
+  if(IsrCutoff(path)) {
+    now = entry + ISR_CUTOFF_CYCLES;
+    SetClock(now);
+    Record(path, edge, LatencyTrace_MarkActuator(path));
+    return IRQ_ENTRY_CYCLES + ISR_CUTOFF_CYCLES + ISR_EDGE_CYCLES;
+  }
+  pendingPath = (int)path;
+  pendingAt = edge;
+  return IRQ_ENTRY_CYCLES + ISR_EDGE_CYCLES;
+}
+
+/**
+  * Main loop work of the given length, with edges that arrive meanwhile
+  */
+static void Run(uint64_t cycles)
+{
+  uint64_t end = now + cycles;
+
+  // One edge at a time: the pump is restarted before the next one
+  while(pendingPath < 0 && nextEdge < end) {
+    uint64_t edge = nextEdge;
+    uint64_t resume = now;
+    end += EdgeIsr(edge);
+    now = resume;
+    nextEdge = edge + ExpGap();
+  }
+  now = end;
+  SetClock(now);
+}
+
+static uint64_t TransmitCycles(uint32_t bytes)
+{
+  return (uint64_t)bytes * 10U * CORE_HZ / REMOTE_BAUD_RATE;
+}
+
+static void Simulate(uint8_t telemetry, uint32_t seconds)
+{
+  uint32_t lastLoop = 0, lastStatus = 0, lastReport = 0, reportPass = 0;
+  uint8_t reportStep = 0;
+  uint64_t stop = (uint64_t)seconds * CORE_HZ;
+
+  LatencyTrace_Init();
+  for(int p = 0; p < LATENCY_PATH_COUNT; p++) {
+    exact[p].n = 0;
+  }
+  now = 0;
+  SetClock(now);
+  nextEdge = ExpGap();
+  pendingPath = -1;
+
+  while(now < stop) {
+    uint32_t tick = (uint32_t)(now / CYC_PER_MS);
+
+    if((tick - lastLoop) >= CONTROL_PERIOD_MS) {
+      lastLoop = tick;
+      Run(PASS_BEFORE_SM_CYC);
+      if(pendingPath >= 0) {
+        LatencyPath_t path = (LatencyPath_t)pendingPath;
+        pendingPath = -1;
+        Record(path, pendingAt, LatencyTrace_MarkActuator(path));
+        if(nextEdge < now) nextEdge = now + ExpGap();
+      }
+      Run(PASS_AFTER_SM_CYC);
+    }
+
+    if(telemetry) {
+      if((tick - lastStatus) >= REMOTE_STATUS_INTERVAL) {
+        lastStatus = tick;
+        Run(TransmitCycles(STATUS_BYTES));
+      }
+      if((tick - lastReport) >= REMOTE_LATENCY_INTERVAL) {
+        lastReport = tick;
+        reportStep = 1;
+      }
+      if(reportStep != 0 && lastLoop != reportPass) {
+        reportPass = lastLoop;
+        reportStep = (reportStep < 4U) ? (uint8_t)(reportStep + 1U) : 0U;
+        Run(TransmitCycles(REPORT_BYTES));
+      }
+    }
+    Run(SPIN_CYC);
+  }
+}
+
+static int Compare(const void* a, const void* b)
+{
+  uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+static void Report(const char* label)
+{
+  for(int p = 0; p < LATENCY_PATH_COUNT; p++) {
+    LatencySummary_t sum;
+    Samples_t* s = &exact[p];
+    uint32_t budget = IsrCutoff((LatencyPath_t)p) ? ISR_BUDGET_US : LOOP_BUDGET_US;
+
+    LatencyTrace_GetSummary((LatencyPath_t)p, &sum);
+    qsort(s->us, s->n, sizeof(s->us[0]), Compare);
+    uint32_t p50 = s->n ? s->us[(s->n * 50U + 99U) / 100U - 1U] : 0U;
+    uint32_t p99 = s->n ? s->us[(s->n * 99U + 99U) / 100U - 1U] : 0U;
+    uint32_t max = s->n ? s->us[s->n - 1U] : 0U;
+
+    printf("%-10s %-4s %6u  p50 %6u (%6u)  p99 %6u (%6u)  max %6u (%6u) us  budget %u\n",
+           label, LatencyTrace_GetPathName((LatencyPath_t)p), (unsigned)sum.count,
+           (unsigned)sum.p50_us, (unsigned)p50, (unsigned)sum.p99_us, (unsigned)p99,
+           (unsigned)sum.max_us, (unsigned)max, (unsigned)budget);
+
+    // Reported percentiles are bucket upper bounds: never low, at most 1.5x high
+    if(sum.count != s->n || sum.max_us != max ||
+       sum.p50_us < p50 || sum.p50_us > p50 + p50 / 2U + 1U ||
+       sum.p99_us < p99 || sum.p99_us > p99 + p99 / 2U + 1U) {
+      printf("FAIL %s: histogram summary does not match the samples\n", LatencyTrace_GetPathName((LatencyPath_t)p));
+      failures++;
+    }
+    if(sum.p99_us > budget) {
+      printf("FAIL %s: p99 %u us over the %u us budget\n", LatencyTrace_GetPathName((LatencyPath_t)p),
+             (unsigned)sum.p99_us, (unsigned)budget);
+      failures++;
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t seconds = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 3600U;
+
+  printf("%u s of FILLING per run, ISR cutoff %s, %u baud; reported (exact)\n", (unsigned)seconds,
+         ENABLE_ISR_PUMP_CUTOFF ? "on" : "off", (unsigned)REMOTE_BAUD_RATE);
+  Simulate(0, seconds);
+  Report("quiet");
+  Simulate(1, seconds);
+  Report("telemetry");
+  printf("checks: %s\n", failures ? "FAILED" : "ok");
+
+  return failures ? 1 : 0;
+}
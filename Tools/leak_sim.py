@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Host benchmark of the leak detector: false alarms against detection delay.
+
+Runs the tank of refill_sim.py with refill_policy.c and leak_detect.c on
+simulated consumption traces. Both modules are compiled for the host
+(Tools/host) and called through ctypes; --sweep rows are builds with
+other config.h values. Glasses are poured according
+to the refill_sim profiles. The door opens only for gallon swaps. The level
+switch drops a few ml (--hysteresis-ml) below the point where fills stop,
+so a leak drains the tank to refill level at a steady pace.
+
+For each profile the benchmark prints false alarms per 30 days without a
+leak, then the delay from the start of a leak to ERROR_LEAK for a range of
+leak rates. Several seeds are run for each row. The detector settings are
+read from Core/Inc/config.h. --sweep adds rows for other LEAK_ALPHA_PERMIL
+and LEAK_CONFIRM_DRAINS values.
+
+Usage:
+    python3 Tools/leak_sim.py [--days 30] [--seeds 5] [--profile home] [--hysteresis-ml 40] [--sweep]
+"""
+
+import argparse
+import ctypes
+
+from host.firmware import Build
+from refill_sim import CONFIG_H, PROFILES, Policy, arrivals, read_config
+from refill_sim import PROTOTYPES as REFILL_PROTOTYPES
+
+STEP_S = 10
+LEAK_RATES_MLH = (10, 25, 50, 100, 200)
+
+SOURCES = ["Core/Src/leak_detect.c", "Core/Src/refill_policy.c", "Core/Src/deferred_log.c"]
+PROTOTYPES = dict(REFILL_PROTOTYPES, **{
+    "LeakDetect_Init": (None, []),
+    "LeakDetect_Process": (None, []),
+    "LeakDetect_FillFull": (None, []),
+    "LeakDetect_DoorActivity": (None, []),
+    "LeakDetect_Drained": (ctypes.c_uint8, []),
+})
+
+
+class Detector:
+    """leak_detect.c in a loaded host library (times in seconds)."""
+
+    def __init__(self, fw):
+        self.fw = fw
+        self.next_hour = 3600
+        fw.set_tick(0)
+        fw.LeakDetect_Init()
+
+    def process(self, now):
+        # The firmware polls every pass; only an hour boundary changes anything
+        if now >= self.next_hour:
+            self.next_hour = (now // 3600 + 1) * 3600
+            self.fw.set_tick(now * 1000)
+            self.fw.LeakDetect_Process()
+
+    def fill_full(self, now):
+        self.fw.set_tick(now * 1000)
+        self.fw.LeakDetect_FillFull()
+
+    def door(self):
+        self.fw.LeakDetect_DoorActivity()
+
+    def drained(self, now):
+        self.fw.set_tick(now * 1000)
+        return self.fw.LeakDetect_Drained() != 0
+
+
+def simulate(cfg, args, pours, build, leak_mlh, leak_day):
+    """Alarm times in seconds (the error is reset at the door at once)."""
+    fw = build.load()
+    policy = Policy(fw)
+    detector = Detector(fw)
+    switch_ml = cfg["ESTIMATED_TANK_SIZE"] * cfg["TANK_TRIGGER_LEVEL"] // 100
+    empty_ml = switch_ml - args.hysteresis_ml
+    pump_rate = cfg["ESTIMATED_PUMP_RATE"]
+    holdoff = cfg["MIN_PUMP_INTERVAL"] / 1000
+    settle = cfg["PUMP_STARTUP_DELAY"] / 1000
+
+    level = float(switch_ml)
+    full, pumping = True, False
+    start_at = None
+    pump_on = last_stop = -holdoff
+    gallon_ml = cfg["GALLON_CAPACITY_ML"]
+    queue, alarms = [], []
+    i = 0
+    leak_at = leak_day * 86400
+
+    policy.fill_done(0, 0, 0)
+    detector.fill_full(0)
+
+    for now in range(0, args.days * 86400, STEP_S):
+        detector.process(now)
+        while i < len(pours) and pours[i] < now + STEP_S:
+            queue.append(pours[i])
+            i += 1
+        while queue and level >= args.glass_ml:
+            level -= args.glass_ml
+            queue.pop(0)
+        if leak_mlh and now >= leak_at:
+            level -= leak_mlh * STEP_S / 3600
+
+        if pumping:
+            level += pump_rate * STEP_S
+            gallon_ml -= pump_rate * STEP_S
+            if level >= switch_ml:
+                pumping, full = False, True
+                last_stop = now
+                policy.fill_done(now, pump_rate * (now - pump_on), now - pump_on)
+                detector.fill_full(now)
+            continue
+
+        if full and level < empty_ml:
+            full = False
+            if detector.drained(now):
+                alarms.append(now)
+                detector.door()           # Reset at the door
+        if gallon_ml < cfg["ESTIMATED_TANK_SIZE"]:
+            gallon_ml = cfg["GALLON_CAPACITY_ML"]
+            detector.door()               # Gallon swap
+        if not full and level < empty_ml:
+            if start_at is None and policy.due(now, level):
+                start_at = max(now, last_stop + holdoff) + settle
+            if start_at is not None and now >= start_at:
+                pumping, pump_on, start_at = True, now, None
+
+    return alarms
+
+
+def run(cfg, args, profile, alpha, confirm):
+    """False alarms per 30 days, then (rate, detected, median delay h or None) per leak rate."""
+    build = Build(SOURCES, PROTOTYPES, {"LEAK_ALPHA_PERMIL": alpha, "LEAK_CONFIRM_DRAINS": confirm})
+    false_alarms = 0
+    for seed in range(args.seeds):
+        pours = arrivals(profile, args.days, seed + 1)
+        false_alarms += len(simulate(cfg, args, pours, build, 0, 0))
+    per_30d = false_alarms * 30 / (args.days * args.seeds)
+
+    leaks = []
+    for rate in LEAK_RATES_MLH:
+        delays = []
+        for seed in range(args.seeds):
+            pours = arrivals(profile, args.days, seed + 1)
+            alarms = simulate(cfg, args, pours, build, rate, args.leak_day)
+            after = [t for t in alarms if t >= args.leak_day * 86400]
+            if after:
+                delays.append((after[0] - args.leak_day * 86400) / 3600)
+        delays.sort()
+        median = delays[len(delays) // 2] if delays else None
+        leaks.append((rate, len(delays), median))
+    return per_30d, leaks
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--days", type=int, default=30)
+    p.add_argument("--seeds", type=int, default=5)
+    p.add_argument("--profile", choices=sorted(PROFILES), help="Only this profile")
+    p.add_argument("--glass-ml", type=int, default=250)
+    p.add_argument("--hysteresis-ml", type=int, default=40, help="Level switch drop below the fill stop point")
+    p.add_argument("--leak-day", type=int, default=7, help="Day the leak starts")
+    p.add_argument("--sweep", action="store_true", help="Also sweep LEAK_ALPHA_PERMIL and LEAK_CONFIRM_DRAINS")
+    args = p.parse_args()
+
+    cfg = read_config(CONFIG_H)
+    alpha, confirm = cfg["LEAK_ALPHA_PERMIL"], cfg["LEAK_CONFIRM_DRAINS"]
+    settings = [(alpha, confirm)]
+    if args.sweep:
+        settings += [(a, k) for a in (50, 100, 200) for k in (2, 3, 4) if (a, k) != (alpha, confirm)]
+
+    print(f"LEAK_ALPHA_PERMIL {alpha}, LEAK_CONFIRM_DRAINS {confirm}, LEAK_QUIET_X16 {cfg['LEAK_QUIET_X16']}, "
+          f"{args.hysteresis_ml} ml hysteresis, {args.days} days x {args.seeds} seeds, leak from day {args.leak_day}")
+    print(f"{'profile':8} {'alpha':>5} {'K':>2} {'false/30d':>9}  "
+          + " ".join(f"{str(r) + ' ml/h':>12}" for r in LEAK_RATES_MLH))
+    for profile in ([args.profile] if args.profile else sorted(PROFILES)):
+        for a, k in settings:
+            per_30d, leaks = run(cfg, args, profile, a, k)
+            cells = " ".join(f"{n}/{args.seeds} " + ("     -" if m is None else f"{m:5.1f}h") for _, n, m in leaks)
+            print(f"{profile:8} {a:5d} {k:2d} {per_30d:9.2f}  {cells}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Decode deferred log records from a UART capture using the firmware ELF.
+
+The firmware sends each LOG_* record as 0x00, COBS data, 0x00 between the
+JSON telemetry lines. A record is a header word (16-bit string ID, level,
+argument count), the HAL tick and up to four 32-bit arguments, plus a byte
+that makes the frame sum to zero. The ID is the offset of the format string
+in the ELF's .log_strings section, which is never loaded into flash.
+
+Text lines are passed through unchanged, so the output is the full log.
+
+Usage:
+    python3 Tools/log_decode.py --elf "Release/WATER DISPENSERS ARM M3 32BIT.elf" uart.bin
+    cat /dev/ttyUSB0 | python3 Tools/log_decode.py --elf firmware.elf
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+LEVELS = {0: "DEBUG", 1: "INFO", 2: "WARN", 3: "ERROR"}
+
+# printf conversions the firmware can use on 32-bit integer arguments
+CONVERSION = re.compile(r"%([-+ 0#]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diuxXoc%])")
+
+
+def load_strings(elf):
+    """Raw bytes of the .log_strings section (its address is 0)."""
+    with open(elf, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError("%s is not a little-endian ELF32 file" % elf)
+    shoff, = struct.unpack_from("<I", data, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+
+    def header(i):
+        # sh_name, sh_type, sh_flags, sh_addr, sh_offset, sh_size
+        return struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+
+    names_off = header(shstrndx)[4]
+    for i in range(shnum):
+        name, _, _, _, offset, size = header(i)
+        end = data.index(b"\0", names_off + name)
+        if data[names_off + name:end] == b".log_strings":
+            return data[offset:offset + size]
+    raise ValueError("%s has no .log_strings section (ENABLE_DEFERRED_LOG 0?)" % elf)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def format_args(fmt, args):
+    """Apply printf conversions to raw 32-bit words."""
+    queue = list(args)
+
+    def convert(m):
+        flags, conv = m.group(1), m.group(2)
+        if conv == "%":
+            return "%"
+        if not queue:
+            return m.group(0)
+        value = queue.pop(0)
+        if conv in "di":
+            value -= (value & 0x80000000) << 1
+            conv = "d"
+        elif conv == "u":
+            conv = "d"
+        elif conv == "c":
+            value &= 0xFF
+        return ("%" + flags + conv) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode_record(strings, raw):
+    """One text line for a decoded frame, None if it is not a valid record."""
+    if len(raw) < 9 or (len(raw) - 1) % 4 or sum(raw) & 0xFF:
+        return None
+    words = struct.unpack("<%dI" % ((len(raw) - 1) // 4), raw[:-1])
+    header, tick, args = words[0], words[1], words[2:]
+    ident, nargs, level = header & 0xFFFF, (header >> 16) & 0xF, (header >> 20) & 0x7
+    if not header & 0x80000000 or nargs != len(args) or ident >= len(strings):
+        return None
+
+    text = strings[ident:strings.index(b"\0", ident)].decode("utf-8", "replace")
+    where, _, fmt = text.partition("\x1f")
+    path, _, line = where.rpartition(":")
+    where = "%s:%s" % (re.split(r"[\\/]", path)[-1], line)
+    return "[%10d] %-5s %s: %s" % (tick, LEVELS.get(level, str(level)), where, format_args(fmt, args))
+
+
+class Decoder:
+    """Splits the byte stream on 0x00; every other token is a COBS frame."""
+
+    def __init__(self, strings, out):
+        self.strings = strings
+        self.out = out
+        self.pending = b""
+        self.in_frame = False
+        self.bad = 0
+
+    def feed(self, chunk):
+        tokens = (self.pending + chunk).split(b"\0")
+        self.pending = tokens.pop()
+        for token in tokens:
+            self.token(token)
+
+    def token(self, token):
+        if not self.in_frame:
+            self.text(token)
+            self.in_frame = True
+            return
+        raw = cobs_decode(token)
+        line = decode_record(self.strings, raw) if raw is not None else None
+        if line is None:
+            # Out of step (lost byte or capture started mid-frame): this was
+            # text, and the zero that ended it opens the next frame
+            self.bad += 1
+            self.text(token)
+            return
+        self.out.write(line + "\n")
+        self.in_frame = False
+
+    def text(self, token):
+        if token:
+            self.out.write(token.decode("utf-8", "replace").replace("\r\n", "\n"))
+
+    def finish(self):
+        self.text(self.pending)
+        self.pending = b""
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--elf", required=True, help="firmware ELF the log was captured with")
+    parser.add_argument("log", nargs="?", help="raw UART capture (default: stdin)")
+    args = parser.parse_args()
+
+    decoder = Decoder(load_strings(args.elf), sys.stdout)
+    stream = open(args.log, "rb") if args.log else sys.stdin.buffer
+    with stream:
+        while True:
+            chunk = stream.read1(4096) if hasattr(stream, "read1") else stream.read(4096)
+            if not chunk:
+                break
+            decoder.feed(chunk)
+            sys.stdout.flush()
+    decoder.finish()
+
+    if decoder.bad:
+        print("%d frame(s) could not be decoded" % decoder.bad, file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
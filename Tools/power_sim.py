@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Host discharge-curve benchmark for the battery power governor.
+
+Runs a battery-powered dispenser from full charge to brownout twice - once
+always in the normal profile (ENABLE_POWER_GOVERNOR 0) and once with the
+governor switching profiles - and prints the runtime of both.
+
+The profile decisions come from power_governor.c itself, compiled for the
+host (Tools/host) and called through ctypes: the battery filter,
+thresholds, dwell and the hourly start budget, and the clock, LED duty and
+telemetry rate of each profile. The governed run is built with
+ENABLE_BATTERY_MONITOR and ENABLE_POWER_GOVERNOR set, the baseline with
+config.h as it is (governor stubbed unless enabled there).
+The load model (run/STOP current, LED, UART frame, pump) is deliberately
+simple; change it with the command line options to match a real unit.
+
+Usage:
+    python3 Tools/power_sim.py [--capacity-mah 2000] [--refills-per-hour 4]
+"""
+
+import argparse
+import ctypes
+import os
+import re
+
+from host.firmware import Build
+
+CONFIG_H = os.path.join(os.path.dirname(__file__), "..", "Core", "Inc", "config.h")
+
+SOURCES = ["Core/Src/power_governor.c", "Core/Src/deferred_log.c", "Tools/host/power_host.c"]
+HSI_HZ = 8000000
+
+# Li-ion open circuit voltage (mV) against state of charge (%)
+OCV_TABLE = [
+    (0, 3000), (5, 3300), (10, 3450), (20, 3580), (30, 3650), (40, 3700),
+    (50, 3750), (60, 3800), (70, 3870), (80, 3950), (90, 4060), (100, 4200),
+]
+
+PROFILES = ["normal", "eco", "critical"]  # PowerProfileId_t order
+
+
+class PowerProfile(ctypes.Structure):
+    """PowerProfile_t of power_governor.h."""
+    _fields_ = [("name", ctypes.c_char_p), ("ahbDivider", ctypes.c_uint32), ("ledDutyPercent", ctypes.c_uint8),
+                ("telemetryInterval", ctypes.c_uint32), ("pumpStartsPerHour", ctypes.c_uint8),
+                ("sleepStates", ctypes.c_uint8)]
+
+
+PROTOTYPES = {
+    "PowerGov_Init": (None, []),
+    "PowerGov_Process": (None, []),
+    "PowerGov_GetProfileId": (ctypes.c_int, []),
+    "PowerGov_GetProfile": (ctypes.POINTER(PowerProfile), []),
+    "PowerGov_PumpStartAllowed": (ctypes.c_uint8, []),
+    "PowerGov_NotePumpStart": (None, []),
+    "HostPump_Set": (None, [ctypes.c_uint8]),
+}
+
+
+def read_config(path):
+    """Integer #defines from config.h."""
+    defines = {}
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            m = re.match(r"\s*#define\s+(\w+)\s+(\d+)\b", line)
+            if m:
+                defines[m.group(1)] = int(m.group(2))
+    return defines
+
+
+def ocv_mv(soc):
+    for (s0, v0), (s1, v1) in zip(OCV_TABLE, OCV_TABLE[1:]):
+        if soc <= s1:
+            return v0 + (v1 - v0) * (soc - s0) / (s1 - s0)
+    return OCV_TABLE[-1][1]
+
+
+class Governor:
+    """power_governor.c in a loaded host library (times in seconds)."""
+
+    def __init__(self, fw):
+        self.fw = fw
+        self.battery = ctypes.c_uint16.in_dll(fw.lib, "HostBattery_mV")
+        self.core_hz = ctypes.c_uint32.in_dll(fw.lib, "SystemCoreClock")
+        fw.set_tick(0)
+        fw.HostPump_Set(0)
+        fw.PowerGov_Init()
+
+    def update(self, now_s, mv):
+        self.fw.set_tick(now_s * 1000)
+        self.battery.value = int(round(mv))
+        self.fw.PowerGov_Process()
+
+    def profile(self):
+        """Active profile name, settings and HCLK divider."""
+        settings = self.fw.PowerGov_GetProfile().contents
+        return PROFILES[self.fw.PowerGov_GetProfileId()], settings, HSI_HZ // self.core_hz.value
+
+    def start_allowed(self, now_s):
+        self.fw.set_tick(now_s * 1000)
+        if not self.fw.PowerGov_PumpStartAllowed():
+            return False
+        self.fw.PowerGov_NotePumpStart()
+        return True
+
+
+def profile_current_ua(cfg, args, settings, clock_div):
+    """Average current outside pump runs for a profile."""
+    run_ua = cfg["DEEP_SLEEP_RUN_CURRENT_UA"]
+    stop_ua = cfg["DEEP_SLEEP_STOP_CURRENT_UA"]
+    # F103 run current is a static part plus a part proportional to HCLK
+    run_ua = args.static_ua + (run_ua - args.static_ua) / clock_div
+
+    # Awake share: one housekeeping wake per DEEP_SLEEP_MAX_MS, slower at a lower clock
+    awake = min(1.0, args.wake_ms * clock_div / cfg["DEEP_SLEEP_MAX_MS"])
+    mcu = awake * run_ua + (1 - awake) * stop_ua
+
+    uart = 0.0
+    if settings.telemetryInterval:
+        uart = (run_ua + args.uart_ua) * args.frame_ms / settings.telemetryInterval
+
+    led = args.led_ua * settings.ledDutyPercent / 100
+    return mcu + uart + led
+
+
+def simulate(cfg, args, build):
+    capacity_uas = args.capacity_mah * 1000.0 * 3600
+    used = 0.0
+    step = 60.0
+    t = 0.0
+    gov = Governor(build.load())
+    evals = int(step * 1000 // cfg["POWER_EVAL_INTERVAL_MS"])
+    refills = refused = 0
+    demand = 0.0
+    time_in = dict.fromkeys(PROFILES, 0.0)
+
+    while True:
+        soc = 100.0 * (1 - used / capacity_uas)
+        mv = ocv_mv(soc)
+        if mv <= args.brownout_mv:
+            break
+        for sub in range(evals):
+            gov.update(t + sub * step / evals, mv)
+        profile, settings, clock_div = gov.profile()
+        time_in[profile] += step
+
+        demand += args.refills_per_hour * step / 3600
+        while demand >= 1:
+            demand -= 1
+            if not gov.start_allowed(t):
+                refused += 1
+                continue
+            refills += 1
+            used += args.pump_ma * 1000 * args.fill_s
+
+        used += profile_current_ua(cfg, args, settings, clock_div) * step
+        t += step
+
+    return t / 3600, refills, refused, time_in
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--capacity-mah", type=float, default=2000)
+    p.add_argument("--brownout-mv", type=float, default=3050, help="Regulator dropout / BOR")
+    p.add_argument("--refills-per-hour", type=float, default=2)
+    p.add_argument("--pump-ma", type=float, default=600)
+    p.add_argument("--fill-s", type=float, default=15)
+    p.add_argument("--led-ua", type=float, default=4000, help="Status LED current when lit")
+    p.add_argument("--static-ua", type=float, default=1500, help="Run current not scaling with HCLK")
+    p.add_argument("--wake-ms", type=float, default=5, help="Awake time per housekeeping wake")
+    p.add_argument("--uart-ua", type=float, default=8000, help="UART transceiver current while sending")
+    p.add_argument("--frame-ms", type=float, default=20, help="Time to send one status frame")
+    args = p.parse_args()
+
+    cfg = read_config(CONFIG_H)
+    baseline = Build(SOURCES, PROTOTYPES)
+    governed = Build(SOURCES, PROTOTYPES, {"ENABLE_BATTERY_MONITOR": 1, "ENABLE_POWER_GOVERNOR": 1})
+    base_h, base_refills, _, _ = simulate(cfg, args, baseline)
+    gov_h, gov_refills, refused, time_in = simulate(cfg, args, governed)
+
+    print(f"normal only : {base_h:8.1f} h  {base_refills} refills")
+    print(f"governed    : {gov_h:8.1f} h  {gov_refills} refills, {refused} held back")
+    print(f"runtime gain: {100 * (gov_h - base_h) / base_h:+.1f} %")
+    total = sum(time_in.values())
+    print("time in profile: " + ", ".join(
+        f"{name} {100 * time_in[name] / total:.1f} %" for name in PROFILES))
+
+
+if __name__ == "__main__":
+    main()
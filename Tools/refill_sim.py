@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+"""Host benchmark of the refill policy: pump starts per day against availability.
+
+Pours glasses from the tank according to a consumption profile and refills
+it the way the firmware does. Refills start when refill_policy.c allows it:
+the module is compiled for the host (Tools/host) and called through ctypes,
+with ENABLE_REFILL_POLICY 0 for the row that refills as soon as the level
+switch reads "not full". The availability latency is how long someone waits at the tap
+because less than a glass is left. The benchmark prints pump starts per day
+and the worst and 99th percentile wait for each profile and policy.
+
+The batch volume, maximum deferral, pump rate, tank size, hold-off and
+settle time are read from Core/Inc/config.h, so the configured policy is
+always one of the rows. The other rows sweep REFILL_BATCH_ML, with and
+without the low probe.
+
+Usage:
+    python3 Tools/refill_sim.py [--days 7] [--profile office] [--low-probe-ml 600] [--max-defer-ms 3600000]
+"""
+
+import argparse
+import ctypes
+import os
+import random
+import re
+
+from host.firmware import Build
+
+CONFIG_H = os.path.join(os.path.dirname(__file__), "..", "Core", "Inc", "config.h")
+
+STEP_S = 2                    # Firmware re-decides at least every DEEP_SLEEP_MAX_MS
+
+SOURCES = ["Core/Src/refill_policy.c", "Core/Src/deferred_log.c"]
+PROTOTYPES = {
+    "RefillPolicy_Init": (None, []),
+    "RefillPolicy_RefillDue": (ctypes.c_uint8, []),
+    "RefillPolicy_FillDone": (None, [ctypes.c_uint32, ctypes.c_uint32, ctypes.c_uint8]),
+}
+LOW_PROBE_PIN = 0x0001        # PB0, LOW_PROBE_Pin in refill_policy.c
+
+# Pours per hour for each hour of the day
+PROFILES = {
+    # Two adults: breakfast, a quiet day, the evening
+    "home": [0, 0, 0, 0, 0, 0, 1, 3, 3, 1, 0.5, 0.5, 1, 0.5, 0.5, 0.5, 0.5, 1, 2, 2, 2, 1, 0.5, 0],
+    # Twenty people from 8 to 17, with a lunch rush
+    "office": [0] * 8 + [10, 12, 10, 10, 30, 12, 10, 10, 8] + [0] * 7,
+    # Home, plus a two-hour gathering every evening
+    "party": [0, 0, 0, 0, 0, 0, 1, 3, 3, 1, 0.5, 0.5, 1, 0.5, 0.5, 0.5, 0.5, 1, 2, 2, 50, 50, 2, 0],
+}
+
+
+def read_config(path):
+    """Integer #defines from config.h."""
+    defines = {}
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            m = re.match(r"\s*#define\s+(\w+)\s+(\d+)\b", line)
+            if m:
+                defines[m.group(1)] = int(m.group(2))
+    return defines
+
+
+def policy_overrides(batch_ml, max_defer_ms, low_probe):
+    """config.h overrides for a policy row; batch_ml None refills at once."""
+    if batch_ml is None:
+        return {"ENABLE_REFILL_POLICY": 0}
+    return {"REFILL_BATCH_ML": batch_ml, "REFILL_MAX_DEFER_MS": max_defer_ms, "ENABLE_LOW_PROBE": int(low_probe)}
+
+
+class Policy:
+    """refill_policy.c in a loaded host library (times in seconds)."""
+
+    def __init__(self, fw, low_probe_ml=None):
+        self.fw = fw
+        self.low_probe_ml = low_probe_ml
+        with open(CONFIG_H, encoding="utf-8") as f:
+            active_low = re.search(r"^\s*#define\s+LOW_PROBE_ACTIVE_LOW\b", f.read(), re.M)
+        self.dry_idr = LOW_PROBE_PIN if active_low else 0
+        fw.set_tick(0)
+        fw.RefillPolicy_Init()
+
+    def due(self, now, level):
+        self.fw.set_tick(now * 1000)
+        if self.low_probe_ml is not None:
+            dry = level < self.low_probe_ml
+            self.fw.gpiob.IDR = self.dry_idr if dry else self.dry_idr ^ LOW_PROBE_PIN
+        return self.fw.RefillPolicy_RefillDue() != 0
+
+    def fill_done(self, now, volume_ml, runtime_s, full=True):
+        self.fw.set_tick(now * 1000)
+        self.fw.RefillPolicy_FillDone(int(volume_ml), int(runtime_s * 1000), 1 if full else 0)
+
+
+def arrivals(profile, days, seed):
+    """Poisson pour times in seconds."""
+    rng = random.Random(seed)
+    times = []
+    for day in range(days):
+        for hour, rate in enumerate(PROFILES[profile]):
+            t = 0.0
+            while rate > 0:
+                t += rng.expovariate(rate / 3600)
+                if t >= 3600:
+                    break
+                times.append((day * 24 + hour) * 3600 + t)
+    return times
+
+
+def simulate(cfg, args, pours, policy):
+    switch_ml = cfg["ESTIMATED_TANK_SIZE"] * cfg["TANK_TRIGGER_LEVEL"] // 100
+    pump_rate = cfg["ESTIMATED_PUMP_RATE"]
+    holdoff = cfg["MIN_PUMP_INTERVAL"] / 1000
+    settle = cfg["PUMP_STARTUP_DELAY"] / 1000
+
+    level = float(switch_ml)
+    pumping = False
+    start_at = None               # Pump start time once a refill is due
+    pump_on = last_stop = -holdoff
+    starts = 0
+    queue = []                    # Arrival times of people waiting for a glass
+    waits = []
+    i = 0
+    end = args.days * 86400
+
+    # A fill already ended at the switch when the simulation starts
+    policy.fill_done(0, 0, 0)
+
+    for now in range(0, end, STEP_S):
+        while i < len(pours) and pours[i] < now + STEP_S:
+            queue.append(pours[i])
+            i += 1
+        while queue and level >= args.glass_ml:
+            level -= args.glass_ml
+            waits.append(max(0.0, now - queue.pop(0)))
+
+        if pumping:
+            level += pump_rate * STEP_S
+            if level >= switch_ml:
+                pumping = False
+                last_stop = now
+                policy.fill_done(now, pump_rate * (now - pump_on), now - pump_on)
+        elif level < switch_ml:
+            if start_at is None and policy.due(now, level):
+                start_at = max(now, last_stop + holdoff) + settle
+            if start_at is not None and now >= start_at:
+                pumping, pump_on, start_at = True, now, None
+                starts += 1
+
+    waits.sort()
+    worst = waits[-1] if waits else 0
+    p99 = waits[int(0.99 * (len(waits) - 1))] if waits else 0
+    return starts / args.days, worst, p99, sum(1 for w in waits if w > 0)
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--days", type=int, default=7)
+    p.add_argument("--profile", choices=sorted(PROFILES), help="Only this profile")
+    p.add_argument("--glass-ml", type=int, default=250)
+    p.add_argument("--low-probe-ml", type=int, default=600, help="Volume left when the low probe runs dry")
+    p.add_argument("--max-defer-ms", type=int, help="Override REFILL_MAX_DEFER_MS")
+    p.add_argument("--seed", type=int, default=1)
+    args = p.parse_args()
+
+    cfg = read_config(CONFIG_H)
+    if args.max_defer_ms is not None:
+        cfg["REFILL_MAX_DEFER_MS"] = args.max_defer_ms
+    batch, defer_ms = cfg["REFILL_BATCH_ML"], cfg["REFILL_MAX_DEFER_MS"]
+    policies = [("immediate", None, False),
+                ("config", batch, False),
+                ("config+probe", batch, True)]
+    for sweep in (250, 500, 1000, 1250):
+        policies.append((f"batch {sweep}", sweep, False))
+        policies.append((f"batch {sweep}+probe", sweep, True))
+    builds = {name: Build(SOURCES, PROTOTYPES, policy_overrides(batch_ml, defer_ms, probe))
+              for name, batch_ml, probe in policies}
+
+    print(f"REFILL_BATCH_ML {batch}, REFILL_MAX_DEFER_MS {defer_ms}, "
+          f"{args.glass_ml} ml glasses, {args.days} days")
+    print(f"{'profile':8} {'policy':18} {'starts/day':>10} {'worst s':>8} {'p99 s':>6} {'waited':>6}")
+    for profile in ([args.profile] if args.profile else sorted(PROFILES)):
+        pours = arrivals(profile, args.days, args.seed)
+        for name, _, probe in policies:
+            policy = Policy(builds[name].load(), args.low_probe_ml if probe else None)
+            per_day, worst, p99, waited = simulate(cfg, args, pours, policy)
+            print(f"{profile:8} {name:18} {per_day:10.1f} {worst:8.0f} {p99:6.0f} {waited:6d}")
+
+
+if __name__ == "__main__":
+    main()
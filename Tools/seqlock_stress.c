@@ -0,0 +1,179 @@
+/**
+  ******************************************************************************
+  * @file           : seqlock_stress.c
+  * @brief          : Host stress test of Core/Inc/seqlock.h on SystemStats_t
+  * @author         : Cuplis Kei Darma
+  ******************************************************************************
+  * One writer thread updates a SystemStats_t field by field under
+  * SeqLock_WriteBegin/End (nested, as UpdatePumpStatistics does inside a
+  * stats block). Every field it writes carries the same generation, so a
+  * copy that mixes two updates is detected. Reader threads take snapshots
+  * with the retry loop of StateMachine_GetStatsSnapshot() and fail the
+  * test on any accepted copy that is torn.
+  *
+  * A first pass copies without the sequence check. It has to see torn
+  * copies, which shows that the race is real on this host; if it sees
+  * none the run proves nothing and is reported as such.
+  *
+  * SEQLOCK_BARRIER is a full fence here, in place of __DMB() on the MCU.
+  *
+  * Build and run from the repository root:
+  *   gcc -O2 -pthread -ITools/host -ICore/Inc -o seqlock_stress Tools/seqlock_stress.c \
+  *       Tools/host/hal_host.c && ./seqlock_stress [seconds]
+  ******************************************************************************
+  */
+
+#define SEQLOCK_BARRIER()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#include "seqlock.h"
+#include "state_machine.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define READERS               3
+#define FIELD_SPIN            8         // Busy loop between field stores, widens the write window
+#define IDLE_SPIN             400       // Busy loop between updates, so readers also find it even
+#define MIN_SNAPSHOTS         100000U
+
+typedef struct {
+  uint64_t snapshots;                   // Accepted copies
+  uint64_t retries;                     // Copies discarded and taken again
+  uint64_t gaveUp;                      // SEQLOCK_READ_RETRIES exhausted (firmware returns 0)
+  uint64_t torn;                        // Accepted copies mixing two updates
+} ReaderStats_t;
+
+static SystemStats_t shared;
+static SeqLock_t lock;
+static volatile int running;
+static volatile int checked;            // 0: raw copies (control), 1: seqlock snapshots
+
+static void Spin(int n)
+{
+  for(volatile int i = 0; i < n; i++) { }
+}
+
+static void* Writer(void* arg)
+{
+  volatile SystemStats_t* s = &shared;
+  uint32_t g = 0;
+
+  (void)arg;
+  while(running) {
+    g++;
+    SeqLock_WriteBegin(&lock);
+    s->totalPumpRunTime = g;    Spin(FIELD_SPIN);
+    s->pumpCycleCount = g;      Spin(FIELD_SPIN);
+    s->lastFillDuration = g;    Spin(FIELD_SPIN);
+    s->totalSystemUptime = g;   Spin(FIELD_SPIN);
+    SeqLock_WriteBegin(&lock);          // Nested block: only the outer one bumps the sequence
+    s->pumpAverageRuntime = g;  Spin(FIELD_SPIN);
+    s->longestPumpRun = g;      Spin(FIELD_SPIN);
+    s->shortestPumpRun = g;     Spin(FIELD_SPIN);
+    s->pumpHealthScore = (uint8_t)g;
+    SeqLock_WriteEnd(&lock);
+    s->errorCount = g;          Spin(FIELD_SPIN);
+    s->lastErrorCode = (uint8_t)g;
+    s->lastSettleSaved = g;     Spin(FIELD_SPIN);
+    s->totalSettleSaved = g;    Spin(FIELD_SPIN);
+    s->settleCount = g;
+    SeqLock_WriteEnd(&lock);
+    Spin(IDLE_SPIN);
+  }
+  return NULL;
+}
+
+static int Consistent(const SystemStats_t* c)
+{
+  uint32_t g = c->totalPumpRunTime;
+
+  return c->pumpCycleCount == g && c->lastFillDuration == g && c->totalSystemUptime == g &&
+         c->pumpAverageRuntime == g && c->longestPumpRun == g && c->shortestPumpRun == g &&
+         c->pumpHealthScore == (uint8_t)g && c->errorCount == g && c->lastErrorCode == (uint8_t)g &&
+         c->lastSettleSaved == g && c->totalSettleSaved == g && c->settleCount == g;
+}
+
+// Same loop as StateMachine_GetStatsSnapshot()
+static uint8_t Snapshot(SystemStats_t* out, ReaderStats_t* st)
+{
+  for(int attempt = 0; attempt < SEQLOCK_READ_RETRIES; attempt++) {
+    uint32_t start = SeqLock_ReadBegin(&lock);
+    *out = shared;
+    if(!SeqLock_ReadRetry(&lock, start)) {
+      return 1;
+    }
+    st->retries++;
+  }
+  return 0;
+}
+
+static void* Reader(void* arg)
+{
+  ReaderStats_t* st = arg;
+  SystemStats_t copy;
+
+  while(running) {
+    if(checked) {
+      if(!Snapshot(&copy, st)) {
+        st->gaveUp++;
+        continue;
+      }
+    } else {
+      copy = shared;
+      SEQLOCK_BARRIER();
+    }
+    st->snapshots++;
+    if(!Consistent(&copy)) {
+      st->torn++;
+    }
+  }
+  return NULL;
+}
+
+static void Run(int withLock, unsigned seconds, ReaderStats_t* total)
+{
+  pthread_t writer, readers[READERS];
+  ReaderStats_t st[READERS] = {0};
+  struct timespec ts = { (time_t)seconds, 0 };
+
+  checked = withLock;
+  running = 1;
+  pthread_create(&writer, NULL, Writer, NULL);
+  for(int i = 0; i < READERS; i++) {
+    pthread_create(&readers[i], NULL, Reader, &st[i]);
+  }
+  nanosleep(&ts, NULL);
+  running = 0;
+  pthread_join(writer, NULL);
+  *total = (ReaderStats_t){0};
+  for(int i = 0; i < READERS; i++) {
+    pthread_join(readers[i], NULL);
+    total->snapshots += st[i].snapshots;
+    total->retries += st[i].retries;
+    total->gaveUp += st[i].gaveUp;
+    total->torn += st[i].torn;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  unsigned seconds = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 10) : 2U;
+  ReaderStats_t raw, locked;
+
+  Run(0, seconds, &raw);
+  printf("raw copies:   %10llu, torn %llu\n", (unsigned long long)raw.snapshots,
+         (unsigned long long)raw.torn);
+  Run(1, seconds, &locked);
+  printf("snapshots:    %10llu, torn %llu, retried %llu, gave up %llu (%d readers, %u updates)\n",
+         (unsigned long long)locked.snapshots, (unsigned long long)locked.torn,
+         (unsigned long long)locked.retries, (unsigned long long)locked.gaveUp, READERS,
+         (unsigned)(lock.sequence / 2U));
+
+  if(locked.torn != 0 || locked.snapshots < MIN_SNAPSHOTS) {
+    printf("checks: FAILED\n");
+    return 1;
+  }
+  printf("checks: %s\n", raw.torn ? "ok" : "ok, but no torn raw copy: the race was not provoked");
+  return 0;
+}